@@ -0,0 +1,195 @@
+#include "adaptive.h"
+#include "save.h"
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+// splitmix64 step for the weighted draw
+static uint64_t next_random(uint64_t& state) {
+    uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static int32_t level_weight(uint8_t level) {
+    return (int32_t)1 << level;
+}
+
+QsAdaptive::QsAdaptive()
+    : count(0), bankId(0), uniform(true), topStep(0), deltaTotal(0), rngState(0) {}
+
+// All-base weights are an all-zero delta tree, so building is just sizing
+void QsAdaptive::reset(uint32_t bankSize, uint32_t id, uint64_t seed) {
+    count = bankSize;
+    bankId = id;
+    uniform = true;
+    topStep = 1;
+    while (topStep <= count / 2) {
+        topStep <<= 1;
+    }
+    tree.assign((size_t)count + 1, 0);
+    levels.assign(count, ADAPTIVE_BASE_LEVEL);
+    deltaTotal = 0;
+    rngState = seed;
+}
+
+void QsAdaptive::addDelta(uint32_t index, int32_t delta) {
+    deltaTotal += delta;
+    for (uint32_t i = index + 1; i <= count; i += i & (~i + 1)) {
+        tree[i] += delta;
+    }
+}
+
+void QsAdaptive::setLevel(uint32_t index, uint8_t level) {
+    uniform = false;
+    if (level > ADAPTIVE_MAX_LEVEL) level = ADAPTIVE_MAX_LEVEL;
+    addDelta(index, level_weight(level) - level_weight(levels[index]));
+    levels[index] = level;
+}
+
+uint32_t QsAdaptive::draw() {
+    return pick(rngState);
+}
+
+uint32_t QsAdaptive::peek() const {
+    uint64_t state = rngState;
+    return pick(state);
+}
+
+uint32_t QsAdaptive::pick(uint64_t& state) const {
+    if (count == 0) return 0;
+    if (uniform) {
+        // No answers recorded yet: weights are uniform
+        return (uint32_t)(next_random(state) % count);
+    }
+
+    // Find the question whose weight interval contains r. A tree node that
+    // covers `step` questions holds their deltas, so its weight sum is
+    // step * base + node.
+    const int64_t base = level_weight(ADAPTIVE_BASE_LEVEL);
+    uint64_t total = (uint64_t)((int64_t)count * base + deltaTotal);
+    int64_t r = (int64_t)(next_random(state) % total);
+    uint32_t pos = 0;
+    for (uint32_t step = topStep; step > 0; step >>= 1) {
+        uint32_t next = pos + step;
+        if (next <= count) {
+            int64_t nodeSum = (int64_t)step * base + tree[next];
+            if (nodeSum <= r) {
+                pos = next;
+                r -= nodeSum;
+            }
+        }
+    }
+    return pos;
+}
+
+void QsAdaptive::recordAnswer(uint32_t index, bool correct) {
+    if (index >= count) return;
+    uint8_t current = levels[index];
+    uint8_t updated;
+    if (correct) {
+        updated = current >= 2 ? current - 2 : 0;
+    } else {
+        updated = current < ADAPTIVE_MAX_LEVEL ? current + 1 : ADAPTIVE_MAX_LEVEL;
+    }
+    setLevel(index, updated);
+}
+
+uint8_t QsAdaptive::level(uint32_t index) const {
+    if (index >= count) return ADAPTIVE_BASE_LEVEL;
+    return levels[index];
+}
+
+void QsAdaptive::exportLevels(vector<pair<uint32_t, uint8_t>>& out) const {
+    for (uint32_t i = 0; i < levels.size(); ++i) {
+        if (levels[i] != ADAPTIVE_BASE_LEVEL) {
+            out.push_back(make_pair(i, levels[i]));
+        }
+    }
+}
+
+void QsAdaptive::importLevel(uint32_t index, uint8_t level) {
+    if (index < count) {
+        setLevel(index, level);
+    }
+}
+
+/**
+ * @brief Header of the question stats side file
+ */
+struct QsStatsHeader {
+    char magic[4];          ///< "HKQS"
+    uint32_t version;       ///< Format version
+    uint32_t bankSizes[3];  ///< Bank sizes the levels refer to
+    uint32_t bankIds[3];    ///< Bank checksums the levels refer to
+    uint32_t entries[3];    ///< Number of (index, level) entries per bank
+};
+
+static const uint32_t QS_STATS_VERSION = 2;
+
+bool save_Qs_stats(const string& filename, const QsAdaptive banks[3]) {
+    QsStatsHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HKQS", 4);
+    header.version = QS_STATS_VERSION;
+
+    // Build the whole file in memory and write it in one call
+    vector<pair<uint32_t, uint8_t>> levels[3];
+    size_t total = 0;
+    for (int b = 0; b < 3; ++b) {
+        banks[b].exportLevels(levels[b]);
+        header.bankSizes[b] = banks[b].size();
+        header.bankIds[b] = banks[b].id();
+        header.entries[b] = (uint32_t)levels[b].size();
+        total += levels[b].size();
+    }
+    string buffer;
+    buffer.reserve(sizeof(header) + total * 5);
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int b = 0; b < 3; ++b) {
+        for (const auto& entry : levels[b]) {
+            buffer.append(reinterpret_cast<const char*>(&entry.first), 4);
+            buffer.push_back((char)entry.second);
+        }
+    }
+
+    // Replaced atomically, so a crash mid-write keeps the old stats
+    string error;
+    return commit_file(filename.c_str(), (filename + ".tmp").c_str(), buffer.data(), buffer.size(), error);
+}
+
+bool load_Qs_stats(const string& filename, QsAdaptive banks[3]) {
+    ifstream file(filename, ios::binary);
+    if (file.fail()) {
+        return false;
+    }
+    string buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(QsStatsHeader)) {
+        return false;
+    }
+    QsStatsHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    if (memcmp(header.magic, "HKQS", 4) != 0 || header.version != QS_STATS_VERSION) {
+        return false;
+    }
+
+    size_t pos = sizeof(header);
+    for (int b = 0; b < 3; ++b) {
+        size_t bytes = (size_t)header.entries[b] * 5;
+        if (pos + bytes > buffer.size()) {
+            return false;
+        }
+        // Levels are only meaningful for the bank they were recorded on
+        if (header.bankSizes[b] == banks[b].size() && header.bankIds[b] == banks[b].id()) {
+            for (uint32_t e = 0; e < header.entries[b]; ++e) {
+                uint32_t index;
+                memcpy(&index, buffer.data() + pos + (size_t)e * 5, 4);
+                banks[b].importLevel(index, (uint8_t)buffer[pos + (size_t)e * 5 + 4]);
+            }
+        }
+        pos += bytes;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Mastery-weighted question selection for one bank
+ *
+ * Every question has a mastery level; its selection weight is
+ * 2^level. Unseen questions start at ADAPTIVE_BASE_LEVEL, a wrong answer
+ * raises the level (the question comes back more often) and a correct
+ * answer lowers it faster (mastered questions fade out).
+ *
+ * The weights live in a Fenwick tree that stores each question's
+ * difference from the base weight, so both the update after an answer
+ * and the weighted draw are O(log n). reset() sizes the tree when the
+ * level loads (an all-base tree is just zeros), so answering a question
+ * never allocates.
+ */
+class QsAdaptive {
+private:
+    uint32_t count;          ///< Number of questions in the bank
+    uint32_t bankId;         ///< Checksum of the bank the levels belong to
+    bool uniform;            ///< No level changed since reset(): draws skip the tree
+    uint32_t topStep;        ///< Highest power of two <= count, for the descent
+    vector<int32_t> tree;    ///< Fenwick tree (1-based) of weight - base weight
+    vector<uint8_t> levels;  ///< Mastery level per question
+    int64_t deltaTotal;      ///< Sum of all weight - base weight
+    uint64_t rngState;       ///< State of the draw's random generator
+
+    void addDelta(uint32_t index, int32_t delta);
+    void setLevel(uint32_t index, uint8_t level);
+    uint32_t pick(uint64_t& state) const;
+
+public:
+    QsAdaptive();
+
+    /**
+     * @brief Resets all weights to the base level for a bank of the given size
+     * @param bankSize Number of questions in the bank
+     * @param id Checksum of the bank (QuestionSet::checksum)
+     * @param seed Seed of the draw's random generator
+     */
+    void reset(uint32_t bankSize, uint32_t id, uint64_t seed);
+
+    /**
+     * @brief Number of questions this tracker covers
+     */
+    uint32_t size() const { return count; }
+
+    /**
+     * @brief Checksum of the bank this tracker covers
+     */
+    uint32_t id() const { return bankId; }
+
+    /**
+     * @brief Draws a question index with probability proportional to its weight
+     * @return Index in [0, size())
+     */
+    uint32_t draw();
+
+    /**
+     * @brief The index the next draw() will return if no answer is recorded first
+     * @return Index in [0, size()); the generator is not advanced
+     */
+    uint32_t peek() const;
+
+    /**
+     * @brief Updates a question's weight after it was answered
+     * @param index Question index in the bank
+     * @param correct True if the player answered correctly
+     */
+    void recordAnswer(uint32_t index, bool correct);
+
+    /**
+     * @brief Current mastery level of a question
+     */
+    uint8_t level(uint32_t index) const;
+
+    /**
+     * @brief Appends (index, level) for every question not at the base level
+     * @param out Output list of pairs
+     */
+    void exportLevels(vector<pair<uint32_t, uint8_t>>& out) const;
+
+    /**
+     * @brief Restores a question's level from persisted stats
+     * @param index Question index in the bank
+     * @param level Saved mastery level
+     */
+    void importLevel(uint32_t index, uint8_t level);
+};
+
+const uint8_t ADAPTIVE_BASE_LEVEL = 4;  ///< Weight 16 for unseen questions
+const uint8_t ADAPTIVE_MAX_LEVEL = 8;   ///< Weight 256 for often-missed questions
+
+/**
+ * @brief Saves the mastery levels of the three banks to a binary side file
+ *
+ * Only questions away from the base level are written, each as a 5-byte
+ * (index, level) entry, under a header that records each bank's size and
+ * checksum so stats from a different bank are not applied. The file is
+ * replaced atomically (commit_file), so a crash keeps the old stats.
+ *
+ * @param filename Path of the stats file
+ * @param banks TA, Professor and Student trackers
+ * @return True if the file was written
+ */
+bool save_Qs_stats(const string& filename, const QsAdaptive banks[3]);
+
+/**
+ * @brief Loads mastery levels saved by save_Qs_stats()
+ *
+ * Banks whose size or checksum no longer matches the file are left at
+ * the base level.
+ *
+ * @param filename Path of the stats file
+ * @param banks TA, Professor and Student trackers, already reset to their bank sizes
+ * @return True if the file was read
+ */
+bool load_Qs_stats(const string& filename, QsAdaptive banks[3]);
+
+#endif
@@ -0,0 +1,54 @@
+#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#ifdef HKU_ALLOC_COUNTER
+
+// Per thread, so other threads' work never shows up in a section being checked
+static thread_local size_t allocations = 0;
+
+// Counting replacements for the global allocation functions
+static void* counted_alloc(size_t size) {
+    ++allocations;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    ++allocations;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    ++allocations;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+
+bool alloc_counter_enabled() {
+    return true;
+}
+
+size_t alloc_count() {
+    return allocations;
+}
+
+#else
+
+bool alloc_counter_enabled() {
+    return false;
+}
+
+size_t alloc_count() {
+    return 0;
+}
+
+#endif
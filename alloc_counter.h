@@ -0,0 +1,35 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+
+/**
+ * @brief Debug heap allocation counter
+ *
+ * When built with -DHKU_ALLOC_COUNTER (make ALLOC_COUNTER=1) the global
+ * operator new is replaced by a counting version, so callers can assert
+ * that a section of code did not touch the heap:
+ *
+ *     size_t before = alloc_count();
+ *     ...
+ *     bool clean = alloc_count() == before;
+ *
+ * Each thread counts its own allocations, so a check on one thread is
+ * not disturbed by others (a server's workers, the prefetch thread).
+ * In normal builds the counter is compiled out and always reads zero.
+ * "make check" builds the counting version and fails on any headless
+ * turn that allocated.
+ */
+
+/**
+ * @brief Returns true when the counting operator new is linked in
+ */
+bool alloc_counter_enabled();
+
+/**
+ * @brief Number of heap allocations made by the calling thread so far
+ * @return Allocation count, or 0 when the counter is disabled
+ */
+size_t alloc_count();
+
+#endif
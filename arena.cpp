@@ -0,0 +1,68 @@
+#include "arena.h"
+#include <cstdint>
+
+using namespace std;
+
+LevelArena::LevelArena(size_t defaultBlockSize)
+    : current(0), used(0), blockSize(defaultBlockSize) {}
+
+LevelArena::~LevelArena() {
+    for (auto& b : blocks) {
+        delete[] b.data;
+    }
+}
+
+// Bump the offset inside the current block; move on to (or create) the next
+// block when the request does not fit.
+void* LevelArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+
+    while (current < blocks.size()) {
+        Block& b = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+        uintptr_t aligned = (base + used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t offset = aligned - base;
+        if (offset + bytes <= b.size) {
+            used = offset + bytes;
+            return b.data + offset;
+        }
+        if (current + 1 < blocks.size() && blocks[current + 1].size >= bytes + alignment) {
+            ++current;
+            used = 0;
+            continue;
+        }
+        break;
+    }
+
+    // No existing block can serve the request: insert a new one after the current one
+    size_t size = bytes + alignment > blockSize ? bytes + alignment : blockSize;
+    Block fresh = {new char[size], size};
+    size_t at = blocks.empty() ? 0 : current + 1;
+    blocks.insert(blocks.begin() + at, fresh);
+    current = at;
+    used = 0;
+    return allocate(bytes, alignment);
+}
+
+void LevelArena::reset() {
+    current = 0;
+    used = 0;
+}
+
+ArenaMark LevelArena::mark() const {
+    ArenaMark m = {current, used};
+    return m;
+}
+
+void LevelArena::rewind(const ArenaMark& m) {
+    current = m.block;
+    used = m.offset;
+}
+
+size_t LevelArena::capacity() const {
+    size_t total = 0;
+    for (const auto& b : blocks) {
+        total += b.size;
+    }
+    return total;
+}
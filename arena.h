@@ -0,0 +1,147 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Position inside a LevelArena, used to rewind short-lived allocations
+ */
+struct ArenaMark {
+    size_t block;   ///< Index of the block that was current
+    size_t offset;  ///< Bytes used in that block
+};
+
+/**
+ * @brief Bump allocator owning all transient memory of one level
+ *
+ * Allocations are carved out of large blocks by advancing an offset and
+ * are never freed individually. reset() releases everything in one step
+ * while keeping the blocks, so the next level reuses the same memory
+ * instead of going back to the heap.
+ */
+class LevelArena {
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    vector<Block> blocks;  ///< All blocks owned by the arena, in use order
+    size_t current;        ///< Index of the block being bumped
+    size_t used;           ///< Bytes used in the current block
+    size_t blockSize;      ///< Default size of a new block
+
+public:
+    /**
+     * @brief Constructs an empty arena
+     * @param defaultBlockSize Size in bytes of each block requested from the heap
+     */
+    explicit LevelArena(size_t defaultBlockSize = 64 * 1024);
+    ~LevelArena();
+
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    /**
+     * @brief Allocates uninitialized memory from the arena
+     * @param bytes Number of bytes needed
+     * @param alignment Required alignment (power of two)
+     * @return Pointer valid until the next reset() or rewind() past it
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t));
+
+    /**
+     * @brief Allocates an uninitialized array of T from the arena
+     * @param count Number of elements
+     * @return Pointer to the first element
+     */
+    template <typename T>
+    T* allocate_array(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /**
+     * @brief Releases every allocation at once, keeping the blocks for reuse
+     */
+    void reset();
+
+    /**
+     * @brief Returns the current position for a later rewind()
+     */
+    ArenaMark mark() const;
+
+    /**
+     * @brief Releases everything allocated after the given mark
+     * @param m Position previously returned by mark()
+     */
+    void rewind(const ArenaMark& m);
+
+    /**
+     * @brief Total bytes reserved from the heap by this arena
+     */
+    size_t capacity() const;
+};
+
+/**
+ * @brief Rewinds an arena to its entry position when leaving a scope
+ *
+ * Used for per-frame scratch data so it does not accumulate over a level.
+ * Declare it before the containers it should release.
+ */
+class ArenaScope {
+private:
+    LevelArena& arena;
+    ArenaMark start;
+
+public:
+    explicit ArenaScope(LevelArena& a) : arena(a), start(a.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+/**
+ * @brief Standard allocator adapter so containers can live in a LevelArena
+ *
+ * deallocate() is a no-op; memory comes back when the arena is reset.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    LevelArena* arena;
+
+    explicit ArenaAllocator(LevelArena& a) : arena(&a) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return arena->allocate_array<T>(n);
+    }
+
+    void deallocate(T*, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+/**
+ * @brief Vector whose storage is served by a LevelArena
+ */
+template <typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+#endif
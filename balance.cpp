@@ -0,0 +1,235 @@
+#include "montecarlo.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+
+static const char* const DIFFICULTY_NAMES[4] = {"", "Easy", "Normal", "Hard"};
+
+static void print_usage(const char* program) {
+    cerr << "Usage: " << program << " [options]" << endl;
+    cerr << "  --games N            games per configuration (default 10000)" << endl;
+    cerr << "  --threads N          worker threads (default: one per core)" << endl;
+    cerr << "  --seed N             seed of the first game of each configuration (default 1)" << endl;
+    cerr << "  --difficulty LIST    difficulties to measure, e.g. 1,3 (default 1,2,3)" << endl;
+    cerr << "  --correct-rate LIST  answer accuracies to measure, e.g. 0.5,0.9 (default 0.75)" << endl;
+    cerr << "  --max-turns N        turn limit per game (default 10000)" << endl;
+    cerr << "Rules to sweep instead of the difficulty's (each a list; every combination is measured):" << endl;
+    cerr << "  --initial-gpa LIST   starting GPAs, e.g. 3.0,3.5" << endl;
+    cerr << "  --ta-k LIST          TA penalty multipliers" << endl;
+    cerr << "  --prof-k LIST        Professor penalty multipliers" << endl;
+    cerr << "  --stu-k LIST         Student penalty multipliers" << endl;
+    cerr << "  --map-size LIST      level sizes, e.g. 8x14,12x20" << endl;
+    cerr << "  --walls LIST         wall chance of a map cell in percent" << endl;
+    cerr << "  --enemies LIST       enemy chance of a map cell in percent" << endl;
+}
+
+// Parse a comma-separated list of numbers; false if any entry is not a number
+static bool parse_list(const char* text, vector<double>& values) {
+    values.clear();
+    while (*text != '\0') {
+        char* end;
+        double value = strtod(text, &end);
+        if (end == text) return false;
+        values.push_back(value);
+        text = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return false;
+    }
+    return !values.empty();
+}
+
+// Parse a comma-separated list of map sizes (ROWSxCOLS); false if any entry is not one
+static bool parse_sizes(const char* text, vector<pair<int, int>>& sizes) {
+    sizes.clear();
+    while (*text != '\0') {
+        int rows, cols, length;
+        if (sscanf(text, "%dx%d%n", &rows, &cols, &length) != 2 || rows < 3 || cols < 3) return false;
+        sizes.push_back(make_pair(rows, cols));
+        text += length;
+        if (*text == ',') {
+            ++text;
+        } else if (*text != '\0') {
+            return false;
+        }
+    }
+    return !sizes.empty();
+}
+
+// True if every value lies in [low, high]
+static bool within(const vector<double>& values, double low, double high) {
+    for (double value : values) {
+        if (!(value >= low && value <= high)) return false;
+    }
+    return true;
+}
+
+// Replace every configuration with one copy per value of a swept setting (none given: unchanged)
+template <typename T>
+static void sweep(vector<BalanceConfig>& configs, T BalanceConfig::*field, const vector<double>& values) {
+    if (values.empty()) return;
+    vector<BalanceConfig> swept;
+    for (const BalanceConfig& config : configs) {
+        for (double value : values) {
+            swept.push_back(config);
+            swept.back().*field = (T)value;
+        }
+    }
+    configs.swap(swept);
+}
+
+static void print_stats(const BalanceConfig& config, const BalanceStats& s) {
+    double games = s.games > 0 ? (double)s.games : 1.0;
+
+    // Only the rules the run overrides get a column
+    char label[192];
+    int n = snprintf(label, sizeof(label), "%-6s %5.2f", DIFFICULTY_NAMES[config.difficulty], config.correctRate);
+    if (config.initialGPA > 0) n += snprintf(label + n, sizeof(label) - n, " GPA %4.2f", config.initialGPA);
+    if (config.taK >= 0) n += snprintf(label + n, sizeof(label) - n, " TA x%.2f", config.taK);
+    if (config.profK >= 0) n += snprintf(label + n, sizeof(label) - n, " Prof x%.2f", config.profK);
+    if (config.stuK >= 0) n += snprintf(label + n, sizeof(label) - n, " Stu x%.2f", config.stuK);
+    if (config.mapRows > 0) {
+        char size[32];
+        snprintf(size, sizeof(size), "%dx%d", config.mapRows, config.mapCols);
+        n += snprintf(label + n, sizeof(label) - n, " map %-7s", size);
+    }
+    if (config.wallPercent >= 0) n += snprintf(label + n, sizeof(label) - n, " walls %3d%%", config.wallPercent);
+    if (config.enemyPercent >= 0) snprintf(label + n, sizeof(label) - n, " enemies %3d%%", config.enemyPercent);
+
+    char line[768];
+    snprintf(line, sizeof(line),
+             "%s | win %6.2f%%  lose %6.2f%%  limit %5.2f%% | "
+             "turns to exit mean %6.1f  p10 %4ld  p50 %4ld  p90 %4ld | "
+             "GPA lost mean %.3f  p50 %.2f  p90 %.2f | %.3f ms/game",
+             label,
+             100.0 * s.wins / games, 100.0 * s.losses / games, 100.0 * s.turnLimits / games,
+             s.wins > 0 ? s.turnSum / s.wins : 0.0,
+             s.turnsPercentile(0.1), s.turnsPercentile(0.5), s.turnsPercentile(0.9),
+             s.gpaLossSum / games, s.gpaLossPercentile(0.5), s.gpaLossPercentile(0.9),
+             s.gameMs / games);
+    cout << line << '\n';
+}
+
+/**
+ * @brief Monte Carlo balancing harness
+ *
+ * Plays many headless autopilot games for every combination of the
+ * chosen difficulties, answer accuracies and swept rules (starting GPA,
+ * penalty multipliers, map size and density), on all cores, and prints
+ * win rate, turns-to-exit and GPA-loss distributions per combination.
+ * Game i of every combination uses seed + i, so combinations are compared
+ * on the same random stream and any single game can be replayed with
+ * "hku_gpa_escape --headless --autopilot --seed S" plus the same rule
+ * options.
+ */
+int main(int argc, char* argv[]) {
+    BalanceRun run;
+    run.gamesPerConfig = 10000;
+    run.seed = 1;
+    run.maxTurns = 10000;
+    run.threads = 0;
+    vector<double> difficulties = {1, 2, 3};
+    vector<double> correctRates = {0.75};
+    vector<double> initialGPAs, taKs, profKs, stuKs, wallPercents, enemyPercents;
+    vector<pair<int, int>> mapSizes;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--games") == 0 && hasValue) {
+            run.gamesPerConfig = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            run.threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            run.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && hasValue) {
+            if (!parse_list(argv[++i], difficulties)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--correct-rate") == 0 && hasValue) {
+            if (!parse_list(argv[++i], correctRates)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-turns") == 0 && hasValue) {
+            run.maxTurns = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--map-size") == 0 && hasValue) {
+            if (!parse_sizes(argv[++i], mapSizes)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--initial-gpa") == 0 && hasValue) {
+            if (!parse_list(argv[++i], initialGPAs) || !within(initialGPAs, 0.01, 100.0)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--ta-k") == 0 || strcmp(argv[i], "--prof-k") == 0 ||
+                    strcmp(argv[i], "--stu-k") == 0) && hasValue) {
+            vector<double>& values = strcmp(argv[i], "--ta-k") == 0 ? taKs :
+                                     (strcmp(argv[i], "--prof-k") == 0 ? profKs : stuKs);
+            if (!parse_list(argv[++i], values) || !within(values, 0.0, 100.0)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--walls") == 0 || strcmp(argv[i], "--enemies") == 0) && hasValue) {
+            vector<double>& values = strcmp(argv[i], "--walls") == 0 ? wallPercents : enemyPercents;
+            if (!parse_list(argv[++i], values) || !within(values, 0.0, 100.0)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    for (double d : difficulties) {
+        if (d != 1 && d != 2 && d != 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Every combination: difficulty varies slowest, then accuracy, then each rule in this order
+    BalanceConfig base = {2, 0.75, 0.0, -1.0, -1.0, -1.0, 0, 0, -1, -1};
+    run.configs.push_back(base);
+    sweep(run.configs, &BalanceConfig::difficulty, difficulties);
+    sweep(run.configs, &BalanceConfig::correctRate, correctRates);
+    sweep(run.configs, &BalanceConfig::initialGPA, initialGPAs);
+    sweep(run.configs, &BalanceConfig::taK, taKs);
+    sweep(run.configs, &BalanceConfig::profK, profKs);
+    sweep(run.configs, &BalanceConfig::stuK, stuKs);
+    if (!mapSizes.empty()) {
+        vector<BalanceConfig> swept;
+        for (const BalanceConfig& config : run.configs) {
+            for (const pair<int, int>& size : mapSizes) {
+                swept.push_back(config);
+                swept.back().mapRows = size.first;
+                swept.back().mapCols = size.second;
+            }
+        }
+        run.configs.swap(swept);
+    }
+    sweep(run.configs, &BalanceConfig::wallPercent, wallPercents);
+    sweep(run.configs, &BalanceConfig::enemyPercent, enemyPercents);
+
+    // Load the shared question bank once, before any worker starts
+    streambuf* screen = cout.rdbuf(cerr.rdbuf());
+    load_All_Qs();
+    cout.rdbuf(screen);
+
+    double elapsedMs;
+    unsigned threads;
+    vector<BalanceStats> results = run_balance(run, elapsedMs, threads);
+
+    // Compare games/s between --threads 1 and more threads to see the scaling
+    unsigned long games = 0;
+    for (size_t c = 0; c < results.size(); ++c) {
+        print_stats(run.configs[c], results[c]);
+        games += results[c].games;
+    }
+    cout << games << " games on " << threads << " thread(s) in " << elapsedMs / 1000.0 << " s ("
+         << (elapsedMs > 0 ? games / (elapsedMs / 1000.0) : 0.0) << " games/s)" << endl;
+    return 0;
+}
@@ -9,12 +9,11 @@
 using namespace std;
 
 // External functions from map module
-extern bool position_walkable(int row, int col);
-extern bool at_exit_position(int row, int col);
+extern bool at_exit_position(const World& world, int row, int col);
 
 // Check if position is valid for enemy movement
-bool isValidEnemyPosition(int x, int y, function<bool(int, int)> isWalkable) {
-    return isWalkable(x, y) && !at_exit_position(y, x);
+bool isValidEnemyPosition(const World& world, int x, int y, WalkableFn isWalkable) {
+    return isWalkable(world, x, y) && !at_exit_position(world, y, x);
 }
 
 // Initialize player at specified position
@@ -43,11 +42,7 @@ vector<Entity> initEnemies(const GameConfig& config) {
         ta.type = 'T';
         ta.active = true;
         ta.id = nextId++;
-        ta.chaseProbability = calculateTAChaseProbability(config.level, config.stage, i);
-        ta.detectionRange = calculateTADetectionRange(config.level, config.stage);
-        ta.movementStrategy = calculateTAMovementStrategy(config.level, config.stage, i);
-        ta.predictiveTracking = 0;
-        ta.distractionFactor = 0;
+        initEnemyBehavior(ta, config.level, config.stage, i);
         enemies.push_back(ta);
     }
     
@@ -56,11 +51,7 @@ vector<Entity> initEnemies(const GameConfig& config) {
         professor.type = 'F';
         professor.active = true;
         professor.id = nextId++;
-        professor.chaseProbability = calculateProfessorChaseProbability(config.level, config.stage, i);
-        professor.detectionRange = calculateProfessorDetectionRange(config.level, config.stage);
-        professor.movementStrategy = calculateProfessorMovementStrategy(config.level, config.stage, i);
-        professor.predictiveTracking = calculateProfessorPredictiveAbility(config.level, config.stage);
-        professor.distractionFactor = 0;
+        initEnemyBehavior(professor, config.level, config.stage, i);
         enemies.push_back(professor);
     }
     
@@ -69,20 +60,44 @@ vector<Entity> initEnemies(const GameConfig& config) {
         student.type = 'S';
         student.active = true;
         student.id = nextId++;
-        student.chaseProbability = calculateStudentChaseProbability(config.level, config.stage, i);
-        student.movementStrategy = calculateStudentMovementStrategy(config.level, config.stage, i);
-        student.distractionFactor = calculateStudentDistraction(config.level, config.stage);
-        student.detectionRange = 2;
-        student.predictiveTracking = 0;
+        initEnemyBehavior(student, config.level, config.stage, i);
         enemies.push_back(student);
     }
     
     return enemies;
 }
 
+// Set behavior modifiers according to the enemy's type
+void initEnemyBehavior(Entity& enemy, int level, int stage, int enemyIndex) {
+    enemy.chaseProbability = 0;
+    enemy.detectionRange = 0;
+    enemy.movementStrategy = 0;
+    enemy.predictiveTracking = 0;
+    enemy.distractionFactor = 0;
+    switch (enemy.type) {
+        case 'T':
+            enemy.chaseProbability = calculateTAChaseProbability(level, stage, enemyIndex);
+            enemy.detectionRange = calculateTADetectionRange(level, stage);
+            enemy.movementStrategy = calculateTAMovementStrategy(level, stage, enemyIndex);
+            break;
+        case 'F':
+            enemy.chaseProbability = calculateProfessorChaseProbability(level, stage, enemyIndex);
+            enemy.detectionRange = calculateProfessorDetectionRange(level, stage);
+            enemy.movementStrategy = calculateProfessorMovementStrategy(level, stage, enemyIndex);
+            enemy.predictiveTracking = calculateProfessorPredictiveAbility(level, stage);
+            break;
+        case 'S':
+            enemy.chaseProbability = calculateStudentChaseProbability(level, stage, enemyIndex);
+            enemy.movementStrategy = calculateStudentMovementStrategy(level, stage, enemyIndex);
+            enemy.distractionFactor = calculateStudentDistraction(level, stage);
+            enemy.detectionRange = 2;
+            break;
+    }
+}
+
 // Move player with direction input
-bool movePlayer(Entity& player, char direction, 
-                function<bool(int, int)> isWalkable,
+bool movePlayer(const World& world, Entity& player, char direction, 
+                WalkableFn isWalkable,
                 int mapWidth, int mapHeight) {
     
     int newX = player.x;
@@ -103,7 +118,7 @@ bool movePlayer(Entity& player, char direction,
         return false;
     }
     
-    if (isWalkable(newX, newY)) {
+    if (isWalkable(world, newX, newY)) {
         player.x = newX;
         player.y = newY;
         return true;
@@ -114,13 +129,32 @@ bool movePlayer(Entity& player, char direction,
 }
 
 // Move all enemies based on their type
-void moveEnemies(vector<Entity>& enemies, const Entity& player,
-                function<bool(int, int)> isWalkable,
+void moveEnemies(World& world, vector<Entity>& enemies, const Entity& player,
+                WalkableFn isWalkable,
                 int mapWidth, int mapHeight) {
+    moveEnemies(world, enemies, &player, 1, isWalkable, mapWidth, mapHeight);
+}
+
+// Move all enemies, each towards its nearest player
+void moveEnemies(World& world, vector<Entity>& enemies, const Entity* players, int playerCount,
+                WalkableFn isWalkable,
+                int mapWidth, int mapHeight) {
+    
+    // Active enemies per cell, so checking a target cell does not scan every enemy
+    countEnemies(world, enemies, mapWidth, mapHeight);
+    vector<int>& occupancy = world.occupancy;
+    
+    // One search for all players instead of one distance per player and enemy
+    if (playerCount > 1) {
+        buildPlayerField(world, players, playerCount, isWalkable, mapWidth, mapHeight);
+    }
     
     for (auto& enemy : enemies) {
         if (!enemy.active) continue;
         
+        const Entity& player = playerCount > 1
+            ? nearestPlayer(world, players, playerCount, enemy, mapWidth, mapHeight)
+            : players[0];
         int newX = enemy.x;
         int newY = enemy.y;
         bool shouldMove = false;
@@ -131,30 +165,27 @@ void moveEnemies(vector<Entity>& enemies, const Entity& player,
         
         switch (enemy.type) {
             case 'T': 
-                shouldMove = moveTA(enemy, player, newX, newY, distance);
+                shouldMove = moveTA(world.rng, enemy, player, newX, newY, distance);
                 break;
             case 'F': 
                 shouldMove = moveProfessor(enemy, player, newX, newY, distance);
                 break;
             case 'S': 
-                shouldMove = moveStudent(enemy, player, newX, newY, distance);
+                shouldMove = moveStudent(world.rng, enemy, player, newX, newY, distance);
                 break;
         }
         
         if (shouldMove && newX >= 0 && newX < mapWidth && 
             newY >= 0 && newY < mapHeight && 
-            isValidEnemyPosition(newX, newY, isWalkable)) {
+            isValidEnemyPosition(world, newX, newY, isWalkable)) {
             
-            bool positionOccupied = false;
-            for (const auto& other : enemies) {
-                if (&other != &enemy && other.active && 
-                    other.x == newX && other.y == newY) {
-                    positionOccupied = true;
-                    break;
-                }
-            }
+            bool stays = newX == enemy.x && newY == enemy.y;
+            bool positionOccupied = !stays && occupancy[(size_t)newY * mapWidth + newX] > 0;
             
-            if (!positionOccupied) {
+            if (!positionOccupied && !stays) {
+                int& from = occupancy[(size_t)enemy.y * mapWidth + enemy.x];
+                if (from > 0) --from;
+                ++occupancy[(size_t)newY * mapWidth + newX];
                 enemy.x = newX;
                 enemy.y = newY;
             }
@@ -162,9 +193,89 @@ void moveEnemies(vector<Entity>& enemies, const Entity& player,
     }
 }
 
+// Count the active enemies on every cell
+void countEnemies(World& world, const vector<Entity>& enemies, int mapWidth, int mapHeight) {
+    // Kept in the world between calls; it only reallocates when the map grows
+    vector<int>& occupancy = world.occupancy;
+    occupancy.assign((size_t)mapWidth * mapHeight, 0);
+    world.playerField.reserve(occupancy.size());
+    world.fieldQueue.reserve(occupancy.size());
+    for (const auto& enemy : enemies) {
+        if (enemy.active && enemy.x >= 0 && enemy.x < mapWidth && enemy.y >= 0 && enemy.y < mapHeight) {
+            ++occupancy[(size_t)enemy.y * mapWidth + enemy.x];
+        }
+    }
+}
+
+// Label every reachable cell with its nearest player, all players searched at once
+void buildPlayerField(World& world, const Entity* players, int playerCount,
+                      WalkableFn isWalkable, int mapWidth, int mapHeight) {
+    vector<int>& field = world.playerField;
+    vector<int>& queue = world.fieldQueue;
+    field.assign((size_t)mapWidth * mapHeight, -1);
+    queue.clear();
+    
+    // Every player's cell is a source; a cell shared by two players goes to the first
+    for (int i = 0; i < playerCount; ++i) {
+        const Entity& p = players[i];
+        if (!p.active || p.x < 0 || p.x >= mapWidth || p.y < 0 || p.y >= mapHeight) continue;
+        int cell = p.y * mapWidth + p.x;
+        if (field[cell] >= 0) continue;
+        field[cell] = i;
+        queue.push_back(cell);
+    }
+    
+    static const int dx[4] = {0, 0, -1, 1};
+    static const int dy[4] = {-1, 1, 0, 0};
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int x = cell % mapWidth;
+        int y = cell / mapWidth;
+        for (int d = 0; d < 4; ++d) {
+            int nx = x + dx[d];
+            int ny = y + dy[d];
+            if (nx < 0 || nx >= mapWidth || ny < 0 || ny >= mapHeight) continue;
+            int next = ny * mapWidth + nx;
+            if (field[next] >= 0 || !isWalkable(world, nx, ny)) continue;
+            field[next] = field[cell];
+            queue.push_back(next);
+        }
+    }
+}
+
+// Look up the enemy's cell in the player field
+const Entity& nearestPlayer(const World& world, const Entity* players, int playerCount,
+                            const Entity& enemy, int mapWidth, int mapHeight) {
+    if (enemy.x >= 0 && enemy.x < mapWidth && enemy.y >= 0 && enemy.y < mapHeight &&
+        world.playerField.size() == (size_t)mapWidth * mapHeight) {
+        int owner = world.playerField[(size_t)enemy.y * mapWidth + enemy.x];
+        if (owner >= 0 && owner < playerCount) {
+            return players[owner];
+        }
+    }
+    for (int i = 0; i < playerCount; ++i) {
+        if (players[i].active) return players[i];
+    }
+    return players[0];
+}
+
+// Players whose cell holds at least one enemy after the last move
+void findEncounters(const World& world, const Entity* players, int playerCount,
+                    int mapWidth, int mapHeight, vector<int>& playerIndices) {
+    playerIndices.clear();
+    if (world.occupancy.size() != (size_t)mapWidth * mapHeight) return;
+    for (int i = 0; i < playerCount; ++i) {
+        const Entity& p = players[i];
+        if (!p.active || p.x < 0 || p.x >= mapWidth || p.y < 0 || p.y >= mapHeight) continue;
+        if (world.occupancy[(size_t)p.y * mapWidth + p.x] > 0) {
+            playerIndices.push_back(i);
+        }
+    }
+}
+
 // TA movement with strategic chasing
-bool moveTA(Entity& ta, const Entity& player, int& newX, int& newY, int distance) {
-    int randomChoice = rand() % 100;
+bool moveTA(RandomStream& rng, Entity& ta, const Entity& player, int& newX, int& newY, int distance) {
+    int randomChoice = game_rand(rng) % 100;
     int dx = player.x - ta.x;
     int dy = player.y - ta.y;
     
@@ -180,7 +291,7 @@ bool moveTA(Entity& ta, const Entity& player, int& newX, int& newY, int distance
             case 1: 
                 if (distance > 2) {
                     if (dx != 0) newX += (dx > 0) ? 1 : -1;
-                    if (dy != 0 && rand() % 2 == 0) newY += (dy > 0) ? 1 : -1;
+                    if (dy != 0 && game_rand(rng) % 2 == 0) newY += (dy > 0) ? 1 : -1;
                 } else {
                     if (abs(dx) > abs(dy)) {
                         newX += (dx > 0) ? 1 : -1;
@@ -196,7 +307,7 @@ bool moveTA(Entity& ta, const Entity& player, int& newX, int& newY, int distance
         }
         return true;
     } else {
-        int direction = rand() % 4;
+        int direction = game_rand(rng) % 4;
         switch (direction) {
             case 0: newY--; break;
             case 1: newY++; break;
@@ -258,8 +369,8 @@ bool moveProfessor(Entity& professor, const Entity& player, int& newX, int& newY
     }
 }
 // Student movement with random behaviors
-bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, int distance) {
-    int randomChoice = rand() % 100;
+bool moveStudent(RandomStream& rng, Entity& student, const Entity& player, int& newX, int& newY, int distance) {
+    int randomChoice = game_rand(rng) % 100;
     
     if (distance <= 3 && randomChoice < student.chaseProbability) {
         int dx = player.x - student.x;
@@ -273,7 +384,7 @@ bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, in
     } else {
         switch (student.movementStrategy) {
             case 0: {
-                int direction = rand() % 4;
+                int direction = game_rand(rng) % 4;
                 switch (direction) {
                     case 0: newY--; break;
                     case 1: newY++; break;
@@ -283,9 +394,9 @@ bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, in
                 break;
             }
             case 1: 
-                if (rand() % 100 < student.distractionFactor) {
-                    int direction = rand() % 4;
-                    int steps = 1 + (rand() % 2);
+                if (game_rand(rng) % 100 < student.distractionFactor) {
+                    int direction = game_rand(rng) % 4;
+                    int steps = 1 + (game_rand(rng) % 2);
                     switch (direction) {
                         case 0: newY -= steps; break;
                         case 1: newY += steps; break;
@@ -293,7 +404,7 @@ bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, in
                         case 3: newX += steps; break;
                     }
                 } else {
-                    int direction = rand() % 4;
+                    int direction = game_rand(rng) % 4;
                     switch (direction) {
                         case 0: newY--; break;
                         case 1: newY++; break;
@@ -312,7 +423,7 @@ bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, in
                         newY += (dy > 0) ? -1 : 1;
                     }
                 } else {
-                    int direction = rand() % 4;
+                    int direction = game_rand(rng) % 4;
                     switch (direction) {
                         case 0: newY--; break;
                         case 1: newY++; break;
@@ -345,13 +456,24 @@ Entity* checkPlayerCollision(const Entity& player, vector<Entity>& enemies) {
     return nullptr;
 }
 
+// Skip the scan when the occupancy shows no enemy on the player's cell
+Entity* findPlayerCollision(const World& world, const Entity& player, vector<Entity>& enemies,
+                            int mapWidth, int mapHeight) {
+    if (world.occupancy.size() == (size_t)mapWidth * mapHeight &&
+        player.x >= 0 && player.x < mapWidth && player.y >= 0 && player.y < mapHeight &&
+        world.occupancy[(size_t)player.y * mapWidth + player.x] == 0) {
+        return nullptr;
+    }
+    return checkPlayerCollision(player, enemies);
+}
+
 // Deactivate enemy when question is answered correctly
 void deactivateEnemy(Entity& enemy) {
     enemy.active = false;
 }
 
 // Get readable name for entity type
-string getEntityTypeName(char type) {
+const char* getEntityTypeName(char type) {
     switch (type) {
         case 'P': return "Player";
         case 'T': return "TA";
@@ -3,8 +3,8 @@
 
 #include <vector>
 #include <string>
-#include <functional>
 #include "save.h"
+#include "world.h"
 
 using namespace std;
 
@@ -17,41 +17,82 @@ struct GameConfig {
     int studentCount;
 };
 
+// Walkability test in entity coordinates (x = column, y = row) on a world's map.
+// A plain function pointer so per-turn calls never allocate.
+typedef bool (*WalkableFn)(const World& world, int x, int y);
+
 // Initialize player at specified position
 Entity initPlayer(int startX, int startY);
 
 // Initialize enemies based on difficulty configuration
 vector<Entity> initEnemies(const GameConfig& config);
 
+// Set an enemy's behavior modifiers from its type, the difficulty and stage,
+// and its index among enemies of the same type
+void initEnemyBehavior(Entity& enemy, int level, int stage, int enemyIndex);
+
 // Move player in specified direction with collision checking
-bool movePlayer(Entity& player, char direction, 
-                function<bool(int, int)> isWalkable,
+bool movePlayer(const World& world, Entity& player, char direction, 
+                WalkableFn isWalkable,
                 int mapWidth, int mapHeight);
 
-// Move all enemies based on their behavior patterns
-void moveEnemies(vector<Entity>& enemies, const Entity& player,
-                 function<bool(int, int)> isWalkable,
+// Move all enemies based on their behavior patterns, drawing from the world's random stream
+void moveEnemies(World& world, vector<Entity>& enemies, const Entity& player,
+                 WalkableFn isWalkable,
                  int mapWidth, int mapHeight);
 
+// Move all enemies, each chasing the active player nearest to it (co-op games).
+// With several players the nearest one comes from buildPlayerField(), so the
+// cost is one pass over the map plus one lookup per enemy.
+void moveEnemies(World& world, vector<Entity>& enemies, const Entity* players, int playerCount,
+                 WalkableFn isWalkable,
+                 int mapWidth, int mapHeight);
+
+// Rebuild world.occupancy, the number of active enemies on each cell; moveEnemies()
+// keeps it up to date, deactivating an enemy only leaves its count too high.
+// Also reserves the co-op field buffers for the map, so calling it when a level
+// loads keeps buildPlayerField() from allocating during turns
+void countEnemies(World& world, const vector<Entity>& enemies, int mapWidth, int mapHeight);
+
+// Multi-source breadth-first search from every active player's cell over walkable
+// cells; stores in world.playerField the index of the player nearest to each cell
+void buildPlayerField(World& world, const Entity* players, int playerCount,
+                      WalkableFn isWalkable, int mapWidth, int mapHeight);
+
+// Player nearest to an enemy according to the last buildPlayerField()
+// (the first active player if the field does not cover the enemy's cell)
+const Entity& nearestPlayer(const World& world, const Entity* players, int playerCount,
+                            const Entity& enemy, int mapWidth, int mapHeight);
+
+// Indices of the players standing on an enemy's cell, in player order, read from
+// the occupancy left by the last moveEnemies() (one lookup per player)
+void findEncounters(const World& world, const Entity* players, int playerCount,
+                    int mapWidth, int mapHeight, vector<int>& playerIndices);
+
 // Check if two entities are colliding
 bool isCollide(const Entity& entity1, const Entity& entity2);
 
 // Check if player collides with any active enemy
 Entity* checkPlayerCollision(const Entity& player, vector<Entity>& enemies);
 
+// Same as checkPlayerCollision(), but only scans the enemies when world.occupancy
+// counts one on the player's cell (countEnemies() must have run for this level)
+Entity* findPlayerCollision(const World& world, const Entity& player, vector<Entity>& enemies,
+                            int mapWidth, int mapHeight);
+
 // Deactivate enemy when question is answered correctly
 void deactivateEnemy(Entity& enemy);
 
 // Get readable name for entity type
-string getEntityTypeName(char type);
+const char* getEntityTypeName(char type);
 
 // Check if position is valid for enemy movement
-bool isValidEnemyPosition(int x, int y, function<bool(int, int)> isWalkable);
+bool isValidEnemyPosition(const World& world, int x, int y, WalkableFn isWalkable);
 
 // Enemy movement helper functions
-bool moveTA(Entity& ta, const Entity& player, int& newX, int& newY, int distance);
+bool moveTA(RandomStream& rng, Entity& ta, const Entity& player, int& newX, int& newY, int distance);
 bool moveProfessor(Entity& professor, const Entity& player, int& newX, int& newY, int distance);
-bool moveStudent(Entity& student, const Entity& player, int& newX, int& newY, int distance);
+bool moveStudent(RandomStream& rng, Entity& student, const Entity& player, int& newX, int& newY, int distance);
 
 // Behavior calculation functions
 int calculateTAChaseProbability(int level, int stage, int enemyIndex);
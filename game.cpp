@@ -1,11 +1,17 @@
 #include "game.h"
+#include "alloc_counter.h"
+#include "input.h"
+#include "rng.h"
+#include "spectate.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
-#include <ctime>
 #include <vector>
 #include <limits>
 #include <cmath>
+#include <random>
+#include <chrono>
+#include <cctype>
 
 using namespace std;
 
@@ -15,14 +21,98 @@ using namespace std;
  * Sets up random number generation, initial game state, default difficulty,
  * and prepares the game for the main menu.
  */
-Game::Game() {
-    srand(time(0)); // Initialize random seed for game events
+Game::Game() : out(cout.rdbuf()) {
+    // Seconds-resolution time would give sessions started together the same games
+    random_device rd;
+    game_srand(world.rng, ((uint64_t)rd() << 32) ^ rd()); // Initialize random seed for game events
     currentState = GameState::MAIN_MENU;
     gameRunning = true;
     currentLevel = 1;
     currentGPA = 0.0;
+    savedThisStep = false;
+    autosaveTurns = 0;
+    turnsSinceSave = 0;
+    journalCommitted = false;
+    playerCount = 1;
+    turnPlayer = 0;
+    answeringPlayer = 0;
+    enemyPhase = false;
+    encounterNext = 0;
+    waitingFor = GameInput::NONE;
+    answerPenalty = 0.0;
+    stepAllocs = 0;
+    rawInput = false;
+    adaptiveQuestions = true;
+    prefetching = true;
+    answerTimeoutMs = 0;
+    realtimeMode = false;
+    spectator = nullptr;
+    tickRate = 5;
+    renderRate = 20;
+    droppedTicks = 0;
+    correctRate = 1.0;
+    questionsAsked = 0;
+    questionsCorrect = 0;
     gameConfig = {2, 0, 0, 0, 0}; // Default to NORMAL difficulty (level 2)
     currentDifficulty = normal(); // Set default difficulty settings
+    seedSamplers();
+}
+
+/**
+ * @brief Seeds one question sampler per enemy bank from a random device
+ * 
+ * Each session walks its own random order through every bank, so a
+ * question is not repeated until the whole bank has been asked.
+ */
+void Game::seedSamplers() {
+    random_device rd;
+    for (int i = 0; i < 3; ++i) {
+        uint64_t seed = ((uint64_t)rd() << 32) ^ rd();
+        sampler_init(samplers[i], seed);
+    }
+}
+
+// Per-question mastery levels persist across sessions in this side file
+static const char* const STATS_FILE = "hku_gpa_escape_stats.bin";
+
+/**
+ * @brief Keeps the mastery trackers in step with the session's question banks
+ * 
+ * Runs at level load. Trackers are only rebuilt when a bank's contents
+ * changed (first game, or a hot reload picked up at a level boundary);
+ * saved levels are then reapplied from the stats file. Rebuilding sizes
+ * the weight trees here, so answers during the level do not allocate.
+ */
+void Game::syncAdaptive() {
+    if (!adaptiveQuestions || world.questions == nullptr) return;
+    // Checksums read every question: only a new snapshot can change them
+    if (world.questions == adaptiveSource) return;
+    adaptiveSource = world.questions;
+    
+    const QsBank* banks[3] = {&world.questions->ta, &world.questions->prof, &world.questions->stu};
+    uint32_t ids[3];
+    bool changed = false;
+    for (int i = 0; i < 3; ++i) {
+        ids[i] = world.questions->checksum(*banks[i]);
+        if (adaptive[i].size() != banks[i]->size() || adaptive[i].id() != ids[i]) changed = true;
+    }
+    if (!changed) return;
+    
+    random_device rd;
+    for (int i = 0; i < 3; ++i) {
+        adaptive[i].reset((uint32_t)banks[i]->size(), ids[i], ((uint64_t)rd() << 32) ^ rd());
+    }
+    load_Qs_stats(STATS_FILE, adaptive);
+}
+
+/**
+ * @brief Persists the mastery trackers so the next session continues from them
+ */
+void Game::saveAdaptive() {
+    if (!adaptiveQuestions) return;
+    if (!save_Qs_stats(STATS_FILE, adaptive)) {
+        out << "Warning: could not write question stats to " << STATS_FILE << endl;
+    }
 }
 
 /**
@@ -36,42 +126,189 @@ Game::Game() {
  * @param y Y-coordinate from entity system (vertical position)
  * @return True if the position is walkable, false if blocked by wall
  */
-bool Game::isWalkableAdapter(int x, int y) {
-    return position_walkable(y, x); // Convert (x,y) to (row,col) for map system
+bool Game::isWalkableAdapter(const World& world, int x, int y) {
+    return position_walkable(world, y, x); // Convert (x,y) to (row,col) for map system
+}
+
+/**
+ * @brief Sets the time allowed to answer each question
+ * 
+ * @param seconds Seconds per question, or 0 for no limit
+ */
+void Game::setAnswerTimeout(int seconds) {
+    answerTimeoutMs = seconds > 0 ? seconds * 1000 : 0;
+}
+
+/**
+ * @brief Sets how many players share the map in new games
+ * 
+ * @param count Players, clamped to 1-9
+ */
+void Game::setPlayers(int count) {
+    playerCount = count < 1 ? 1 : (count > 9 ? 9 : count);
 }
 
 /**
- * @brief Main game execution loop that manages state transitions
+ * @brief Enables real-time mode, where enemies move on their own clock
  * 
- * Continuously runs the game, transitioning between different states
- * (menu, gameplay, level completion, game over, victory) until the
- * player chooses to exit the game.
+ * @param ticksPerSecond Enemy simulation rate
+ * @param framesPerSecond Screen refresh rate
+ */
+void Game::setRealtime(int ticksPerSecond, int framesPerSecond) {
+    realtimeMode = true;
+    tickRate = ticksPerSecond > 0 ? ticksPerSecond : 5;
+    renderRate = framesPerSecond > 0 ? framesPerSecond : 20;
+}
+
+/**
+ * @brief Runs the game in the terminal until the player exits
+ * 
+ * Reads one key at a time and feeds it to the game. Answer time limits
+ * and held-key coalescing only apply to single-key terminal input.
  */
 void Game::run() {
+    rawInput = input_is_raw();
+    start();
+    while (gameRunning) {
+        GameInput request = waitingFor;
+        int waitMs = rawInput ? inputTimeoutMs() : -1;
+        
+        // A held key moves once per turn instead of queueing up moves
+        int key = input_read_key(waitMs, request == GameInput::MOVE);
+        feed(key);
+        
+        // Keys typed ahead (e.g. a held movement key) must not answer the question
+        if (waitingFor == GameInput::ANSWER && request != GameInput::ANSWER) {
+            input_flush();
+        }
+    }
+}
+
+/**
+ * @brief Echoes a key read in single-key terminal mode
+ * 
+ * @param key Key returned by input_read_key()
+ * 
+ * Line input is echoed by the terminal itself, and keys fed by other
+ * drivers are not echoed at all.
+ */
+void Game::echoKey(int key) {
+    if (rawInput) {
+        out << (char)key << endl;
+    }
+}
+
+/**
+ * @brief Starts the game at the main menu
+ */
+void Game::start() {
+    currentState = GameState::MAIN_MENU;
+    gameRunning = true;
+    advance();
+}
+
+/**
+ * @brief Resumes the game with one input
+ * 
+ * @param key Key returned by input_read_key()
+ * 
+ * Dispatches the key to the handler of the prompt the game stopped at.
+ * Each handler runs the game on until the next prompt. A turn spans
+ * several calls (the move, then each answer), so the allocation check
+ * covers the steps inside each call and never the caller's work or
+ * input waits between them.
+ */
+void Game::feed(int key) {
+    if (key == INPUT_TIMEOUT && waitingFor != GameInput::ANSWER) {
+        return; // Only answers have a time limit
+    }
+    switch (waitingFor) {
+        case GameInput::NONE:
+            break;
+        case GameInput::MENU:
+            handleMenuKey(key);
+            break;
+        case GameInput::DIFFICULTY:
+            handleDifficultyKey(key);
+            break;
+        case GameInput::MOVE:
+            beginStep();
+            handleMoveKey(key);
+            break;
+        case GameInput::ANSWER:
+            beginStep();
+            handleAnswerKey(key);
+            break;
+        case GameInput::AFTER_GAME:
+            handleAfterGameKey(key);
+            break;
+    }
+    // A step that ends in a question stops here; endTurn() checks the others
+    if (waitingFor == GameInput::ANSWER) {
+        endStep();
+    }
+}
+
+/**
+ * @brief Time left to answer the pending question
+ * 
+ * @return Milliseconds left (0 once expired), or -1 without a limit
+ */
+int Game::inputTimeoutMs() const {
+    if (waitingFor != GameInput::ANSWER || answerTimeoutMs <= 0) {
+        return -1;
+    }
+    auto left = chrono::duration_cast<chrono::milliseconds>(answerDeadline - chrono::steady_clock::now());
+    return left.count() > 0 ? (int)left.count() : 0;
+}
+
+/**
+ * @brief Moves through the game states until one needs input
+ * 
+ * Transitions that need no input (level completion, loading the next
+ * level) happen here; the states that do print their prompt and set
+ * waitingFor. Real-time levels run their own loop from here, since
+ * they read the terminal directly.
+ */
+void Game::advance() {
+    waitingFor = GameInput::NONE;
     while (gameRunning) {
         switch (currentState) {
             case GameState::MAIN_MENU:
                 showMainMenu();
-                handleMenuInput();
-                break;
+                waitingFor = GameInput::MENU;
+                return;
             case GameState::PLAYING:
-                gameLoop();
-                break;
+                if (realtimeMode && players.size() > 1) {
+                    out << "Real-time mode is single-player; playing turn-based." << endl;
+                    realtimeMode = false;
+                }
+                if (realtimeMode) {
+                    if (rawInput) {
+                        realtimeLoop();
+                        break;
+                    }
+                    out << "Real-time mode needs a terminal; playing turn-based." << endl;
+                    realtimeMode = false;
+                }
+                beginTurn();
+                return;
             case GameState::LEVEL_COMPLETE:
+                saveAdaptive();
                 if (currentLevel < 3) {
                     currentLevel++;
                     loadLevel(currentLevel);
                     currentState = GameState::PLAYING;
                 } else {
-                    gameOver(true); // Player completed all 3 levels
+                    currentState = GameState::VICTORY; // Player completed all 3 levels
                 }
                 break;
             case GameState::GAME_OVER:
                 gameOver(false);
-                break;
+                return;
             case GameState::VICTORY:
                 gameOver(true);
-                break;
+                return;
         }
     }
 }
@@ -85,69 +322,86 @@ void Game::run() {
  * 3. Exit Game
  */
 void Game::showMainMenu() {
-    cout << "\n==================================" << endl;
-    cout << "        HKU GPA Escape           " << endl;
-    cout << "==================================" << endl;
-    cout << "  Escape Academic Zombies!       " << endl;
-    cout << "==================================" << endl;
-    cout << "1. Start New Game" << endl;
-    cout << "2. Load Game" << endl;
-    cout << "3. Exit Game" << endl;
-    cout << "Enter choice (1-3): ";
+    out << "\n==================================" << endl;
+    out << "        HKU GPA Escape           " << endl;
+    out << "==================================" << endl;
+    out << "  Escape Academic Zombies!       " << endl;
+    out << "==================================" << endl;
+    out << "1. Start New Game" << endl;
+    out << "2. Load Game" << endl;
+    out << "3. Exit Game" << endl;
+    out << "Enter choice (1-3): ";
 }
 
 /**
- * @brief Processes user input from the main menu
+ * @brief Processes the player's main menu choice
+ * 
+ * @param key Key returned by input_read_key()
  * 
- * Reads player's menu selection and transitions to the appropriate
- * game state or exits the application.
+ * Transitions to the appropriate game state or exits the application.
  */
-void Game::handleMenuInput() {
-    int choice;
-    cin >> choice;
+void Game::handleMenuKey(int key) {
+    if (key == INPUT_EOF) {
+        gameRunning = false;
+        waitingFor = GameInput::NONE;
+        return;
+    }
+    echoKey(key);
     
-    switch (choice) {
-        case 1:
+    switch (key) {
+        case '1':
             selectDifficulty();
-            break;
-        case 2:
+            return;
+        case '2':
             if (loadGameState()) {
                 currentState = GameState::PLAYING;
             }
             break;
-        case 3:
+        case '3':
             gameRunning = false;
             break;
         default:
-            cout << "Invalid choice, please try again!" << endl;
+            out << "Invalid choice, please try again!" << endl;
             break;
     }
+    advance();
 }
 
 /**
- * @brief Displays difficulty selection screen and processes choice
+ * @brief Displays difficulty selection screen
  * 
  * Presents three difficulty options with their starting GPA values:
  * - Easy: 4.0 GPA
  * - Normal: 3.5 GPA  
  * - Hard: 3.0 GPA
- * 
- * After selection, initializes the game with chosen difficulty.
  */
 void Game::selectDifficulty() {
-    cout << "\n==================================" << endl;
-    cout << "        Select Difficulty        " << endl;
-    cout << "==================================" << endl;
-    cout << "1. Easy   (Initial GPA: 4.0)" << endl;
-    cout << "2. Normal (Initial GPA: 3.5)" << endl;
-    cout << "3. Hard   (Initial GPA: 3.0)" << endl;
-    cout << "Enter difficulty (1-3): ";
-    
-    int choice;
-    cin >> choice;
-    setDifficulty(choice);
-    cout << "\nDifficulty set! Starting game..." << endl;
+    out << "\n==================================" << endl;
+    out << "        Select Difficulty        " << endl;
+    out << "==================================" << endl;
+    out << "1. Easy   (Initial GPA: 4.0)" << endl;
+    out << "2. Normal (Initial GPA: 3.5)" << endl;
+    out << "3. Hard   (Initial GPA: 3.0)" << endl;
+    out << "Enter difficulty (1-3): ";
+    waitingFor = GameInput::DIFFICULTY;
+}
+
+/**
+ * @brief Processes the difficulty choice and starts the game
+ * 
+ * @param key Key returned by input_read_key()
+ */
+void Game::handleDifficultyKey(int key) {
+    if (key == INPUT_EOF) {
+        gameRunning = false;
+        waitingFor = GameInput::NONE;
+        return;
+    }
+    echoKey(key);
+    setDifficulty(key - '0');
+    out << "\nDifficulty set! Starting game..." << endl;
     initializeGame();
+    advance();
 }
 
 /**
@@ -170,7 +424,7 @@ void Game::setDifficulty(int difficultyChoice) {
             gameConfig.level = 3; // HARD
             break;
         default:
-            cout << "Invalid choice, using Normal difficulty" << endl;
+            out << "Invalid choice, using Normal difficulty" << endl;
             currentDifficulty = normal();
             gameConfig.level = 2; // NORMAL
             break;
@@ -213,9 +467,10 @@ void Game::setupGameConfig() {
  * and starts the first level of the game.
  */
 void Game::initializeGame() {
-    // Initialize question system with all question files
-    load_All_Qs();
-    initQsRandom();
+    // Question bank is loaded once per process and shared read-only
+    load_All_Qs(out);
+    world.questions = current_Qs();
+    seedSamplers();
     
     currentLevel = 1;
     loadLevel(currentLevel);
@@ -232,21 +487,37 @@ void Game::initializeGame() {
  * map to initialize all enemy entities.
  */
 void Game::loadLevel(int level) {
-    cout << "\n==================================" << endl;
-    cout << "        Entering Level " << level << "         " << endl;
-    cout << "==================================" << endl;
+    out << "\n==================================" << endl;
+    out << "        Entering Level " << level << "         " << endl;
+    out << "==================================" << endl;
+    
+    // Pick up the latest question bank snapshot at level boundaries
+    world.questions = current_Qs();
+    syncAdaptive();
+    prefetcher.clear();
+    if (prefetching) {
+        prefetcher.start();
+    }
     
     // Load map with current difficulty and level
-    load_map(gameConfig.level, level);
+    load_map(world, gameConfig.level, level);
     
-    // Initialize player at the map's starting position
-    player = initPlayer(map_player_start_col, map_player_start_row);
+    // Initialize players at the map's starting position
+    placePlayers();
     
     // Scan map and initialize all enemy entities
     initializeEnemiesFromMap();
+    prefetchQuestions();
     
-    cout << "Level " << level << " loaded successfully!" << endl;
-    cout << "Objective: Find the exit (E) and escape!" << endl;
+    out << "This level has " << enemies.size() << " enemies" << endl;
+    out << "Level " << level << " loaded successfully!" << endl;
+    out << "Objective: Find the exit (E) and escape!" << endl;
+    
+    // Journal records only describe turns on one map: a new level starts from a checkpoint
+    if (autosaveTurns > 0 && players.size() == 1) {
+        journal.close();
+        saveGameState(true);
+    }
 }
 
 /**
@@ -260,9 +531,9 @@ void Game::initializeEnemiesFromMap() {
     enemies.clear();
     
     // Scan entire map for enemy characters
-    for (int row = 0; row < map_rows; ++row) {
-        for (int col = 0; col < map_cols; ++col) {
-            char cell = get_map_char_at(row, col);
+    for (int row = 0; row < world.map_rows; ++row) {
+        for (int col = 0; col < world.map_cols; ++col) {
+            char cell = get_map_char_at(world, row, col);
             if (cell == 'T' || cell == 'F' || cell == 'S') {
                 Entity enemy;
                 enemy.x = col;      // Entity system: x = column
@@ -273,117 +544,603 @@ void Game::initializeEnemiesFromMap() {
                 enemies.push_back(enemy);
                 
                 // 关键：清掉地图上的敌人字符，防止"幽灵敌人"
-                map_data[row][col] = '.';
+                world.map_data[row][col] = '.';
             }
         }
     }
     
-    cout << "This level has " << enemies.size() << " enemies" << endl;
+    assignEnemyBehaviors();
+    countEnemies(world, enemies, world.map_cols, world.map_rows);
+}
+
+/**
+ * @brief Places every player at the map's start, the first one to move next
+ */
+void Game::placePlayers() {
+    players.assign(playerCount, initPlayer(world.map_player_start_col, world.map_player_start_row));
+    // Every player can be caught in one move; keeps queueEncounters() from allocating mid-turn
+    encounterQueue.reserve(players.size());
+    turnPlayer = 0;
+    answeringPlayer = 0;
 }
 
 /**
- * @brief Main gameplay loop for active level progression
+ * @brief Gives every enemy the behavior of its type, difficulty and stage
  * 
- * Repeatedly cycles through displaying game info, processing
- * player turns, enemy turns, and checking game state until
- * the level is completed or the game ends.
+ * Enemies are numbered per type in map order. Saves store the resulting
+ * modifiers with each enemy, so loaded games do not call this.
  */
-void Game::gameLoop() {
-    while (currentState == GameState::PLAYING) {
-        displayGameInfo();
-        
-        bool playerMoved = playerTurn();
+void Game::assignEnemyBehaviors() {
+    int typeIndex[3] = {0, 0, 0};
+    for (Entity& enemy : enemies) {
+        int bank = enemy.type == 'T' ? 0 : (enemy.type == 'F' ? 1 : 2);
+        initEnemyBehavior(enemy, gameConfig.level, currentLevel, typeIndex[bank]++);
+    }
+}
 
-        if (!playerMoved) {
-            continue;
-        }
+/**
+ * @brief Shows the game status and prompts for the player's move
+ */
+void Game::beginTurn() {
+    beginStep();
+    print_Qs_reload_notice(out);
+    reportSaves();
+    if (autosaveTurns > 0 && players.size() == 1) {
+        journalTurn();
+    }
+    displayGameInfo();
+    publishSpectator();
+    if (players.size() > 1) {
+        out << "\nPlayer " << turnPlayer + 1 << "'s turn - Enter movement direction (W/A/S/D): ";
+    } else {
+        out << "\nYour turn - Enter movement direction (W/A/S/D) or P to save game: ";
+    }
+    waitingFor = GameInput::MOVE;
+    endStep();
+}
 
-        if (at_exit_position(player.y, player.x)) {
-            cout << "\nCongratulations! You found the exit!" << endl;
-            currentState = GameState::LEVEL_COMPLETE;
-            continue;
-        }
+/**
+ * @brief Finishes the current turn and continues to the next prompt
+ */
+void Game::endTurn() {
+    // Checked before advance(), which may load the next level
+    endStep();
+    advance();
+}
 
-        {
-            Entity* collidedEnemy = checkPlayerCollision(player, enemies);
-            if (collidedEnemy != nullptr) {
-                handleQuestion(collidedEnemy->type);
+/**
+ * @brief Starts the allocation check of one step of a turn
+ * 
+ * A step is the game's own work inside one feed() call: the prompt
+ * (beginTurn()), the move, or an answer, each up to the next prompt.
+ */
+void Game::beginStep() {
+    stepAllocs = alloc_count();
+    savedThisStep = false;
+}
 
-                if (currentGPA <= 0) {
-                    currentState = GameState::GAME_OVER;
-                    continue;
-                }
-                continue;
-            }
+/**
+ * @brief Reports heap allocations made since beginStep() (allocation counter builds)
+ */
+void Game::endStep() {
+    // Steady-state steps must not touch the heap; saving is the only exception
+    if (alloc_counter_enabled() && currentState == GameState::PLAYING && !savedThisStep) {
+        size_t allocs = alloc_count() - stepAllocs;
+        if (allocs != 0) {
+            cerr << "[alloc] turn made " << allocs << " heap allocation(s)" << endl;
         }
+    }
+}
+
+/**
+ * @brief Plays a player's move, then the encounters and enemy moves it leads to
+ * 
+ * @param key Key returned by input_read_key()
+ * 
+ * A blocked move or a save ends the turn without moving enemies, and the
+ * same player moves again. Walking into an enemy asks its question
+ * before the enemies move; an enemy reaching a player afterwards asks
+ * its question too. Either way the turn then waits for the answer.
+ * In co-op games the enemies move once every player has moved.
+ */
+void Game::handleMoveKey(int key) {
+    if (key == INPUT_EOF) {
+        out << endl << "Input closed, leaving the game." << endl;
+        currentState = GameState::MAIN_MENU;
+        gameRunning = false;
+        waitingFor = GameInput::NONE;
+        return;
+    }
+    echoKey(key);
+    char input = toupper(key);
 
-        enemyTurn();
+    if (input == 'P') {
+        saveGameState();
+        savedThisStep = true;
+        endTurn();
+        return;
+    }
 
-        {
-            Entity* collidedEnemy = checkPlayerCollision(player, enemies);
-            if (collidedEnemy != nullptr) {
-                handleQuestion(collidedEnemy->type);
+    const Entity& player = players[turnPlayer];
+    MoveOutcome outcome = playMove(input);
+    if (outcome == MoveOutcome::BLOCKED) {
+        out << "Cannot move in that direction! There is an obstacle or invalid direction." << endl;
+        endTurn();
+        return;
+    }
+    out << "Movement successful! New position: (" 
+         << player.x << ", " << player.y << ")" << endl;
 
-                if (currentGPA <= 0) {
-                    currentState = GameState::GAME_OVER;
-                    continue;
-                }
-            }
+    if (outcome == MoveOutcome::EXIT) {
+        out << "\nCongratulations! You found the exit!" << endl;
+        endTurn();
+        return;
+    }
+    if (outcome == MoveOutcome::ENCOUNTER) {
+        if (!poseQuestion()) {
+            finishMove(false);
         }
-        checkGameState();
+        return;
     }
+    finishMove(true);
 }
 
-bool Game::playerTurn() {
-    cout << "\nYour turn - Enter movement direction (W/A/S/D) or P to save game: ";
-    char input;
-    cin >> input;
-    input = toupper(input);
+/**
+ * @brief Moves the player whose turn it is, without any I/O
+ * 
+ * @param move Direction key (W/A/S/D)
+ * @return What the move led to
+ * 
+ * The rules every mode shares: a blocked move or any other key moves
+ * nothing, one player reaching the exit completes the level for the whole
+ * team, and walking into an enemy makes that player answer its question
+ * (answeringPlayer is set) before anything else happens. The caller then
+ * ends the move with endMove(), after the answer if there was a question.
+ */
+MoveOutcome Game::playMove(char move) {
+    Entity& player = players[turnPlayer];
+    int newX = player.x + (move == 'D') - (move == 'A');
+    int newY = player.y + (move == 'S') - (move == 'W');
+    if ((newX == player.x && newY == player.y) || !isWalkableAdapter(world, newX, newY)) {
+        return MoveOutcome::BLOCKED;
+    }
+    player.x = newX;
+    player.y = newY;
+    
+    if (at_exit_position(world, player.y, player.x)) {
+        currentState = GameState::LEVEL_COMPLETE;
+        return MoveOutcome::EXIT;
+    }
+    if (findPlayerCollision(world, player, enemies, world.map_cols, world.map_rows) != nullptr) {
+        answeringPlayer = turnPlayer;
+        enemyPhase = false;
+        return MoveOutcome::ENCOUNTER;
+    }
+    return MoveOutcome::MOVED;
+}
 
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+/**
+ * @brief Passes the turn on; once every player has moved, moves the enemies
+ * 
+ * @param enemiesMayMove False if the move ended in an encounter, which
+ *                       skips the enemies' move
+ * @return True if the enemies moved; nextEncounter() then yields the
+ *         players they reached, in turn order
+ * 
+ * Enemy AI by type:
+ * - TAs: 65% chance to track player, 35% random movement
+ * - Professors: Always track player directly
+ * - Students: Always move randomly
+ * 
+ * In co-op games each enemy chases the player nearest to it. Prints
+ * nothing, so every mode shares it.
+ */
+bool Game::endMove(bool enemiesMayMove) {
+    if (!endOfRound() || !enemiesMayMove) {
+        return false;
+    }
+    moveEnemies(world, enemies, players.data(), (int)players.size(),
+                &Game::isWalkableAdapter, world.map_cols, world.map_rows);
+    queueEncounters();
+    enemyPhase = true;
+    return true;
+}
 
-    if (input == 'P') {
-        saveGameState();
+/**
+ * @brief Passes the turn to the next player; after the last one, moves the enemies
+ * 
+ * @param enemiesMayMove False if the move ended in an encounter, which
+ *                       skips the enemies' move as in single-player games
+ */
+void Game::finishMove(bool enemiesMayMove) {
+    if (!endMove(enemiesMayMove)) {
+        checkGameState();
+        endTurn();
+        return;
+    }
+    
+    out << "\nEnemy turn..." << endl;
+    prefetchQuestions();
+    out << "Enemy movement completed" << endl;
+    askQueuedEncounters();
+}
+
+/**
+ * @brief Asks the question of every player an enemy reached, in turn order
+ * 
+ * Returns while a question waits for its answer; handleAnswerKey()
+ * calls it again for the next one. The turn ends once none is left.
+ */
+void Game::askQueuedEncounters() {
+    while (currentState == GameState::PLAYING) {
+        int playerIndex = nextEncounter();
+        if (playerIndex < 0) break;
+        answeringPlayer = (size_t)playerIndex;
+        if (poseQuestion()) {
+            return;
+        }
+    }
+    checkGameState();
+    endTurn();
+}
+
+/**
+ * @brief Advances turnPlayer to the next player
+ * 
+ * @return True if every player has now moved this round
+ */
+bool Game::endOfRound() {
+    if (++turnPlayer < players.size()) {
         return false;
     }
+    turnPlayer = 0;
+    return true;
+}
 
-    bool moved = movePlayer(
-        player,
-        input,
-        [this](int x, int y) { return this->isWalkableAdapter(x, y); },
-        map_cols,
-        map_rows
-    );
+/**
+ * @brief Queues the players standing on an enemy's cell after the enemies moved
+ * 
+ * Reads the occupancy moveEnemies() left behind, so this is one lookup
+ * per player rather than a scan of the enemies for each of them.
+ */
+void Game::queueEncounters() {
+    findEncounters(world, players.data(), (int)players.size(), world.map_cols, world.map_rows, encounterQueue);
+    encounterNext = 0;
+}
 
-    if (moved) {
-        cout << "Movement successful! New position: (" 
-             << player.x << ", " << player.y << ")" << endl;
-        return true;
+/**
+ * @brief Takes the next queued player who still shares a cell with an active enemy
+ * 
+ * @return Player index, or -1 once the queue is empty
+ * 
+ * An earlier correct answer may have removed the enemy two players shared.
+ */
+int Game::nextEncounter() {
+    while (encounterNext < encounterQueue.size()) {
+        int playerIndex = encounterQueue[encounterNext++];
+        if (checkPlayerCollision(players[playerIndex], enemies) != nullptr) {
+            return playerIndex;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Puts the question of the enemy on answeringPlayer's cell
+ * 
+ * @return True if the game now waits for the answer
+ * 
+ * The question is printed and the turn waits in waitingFor == ANSWER.
+ * An empty bank lets the player pass at once and returns false.
+ */
+bool Game::poseQuestion() {
+    Entity* collidedEnemy = checkPlayerCollision(players[answeringPlayer], enemies);
+    if (collidedEnemy == nullptr) {
+        return false;
+    }
+    
+    // A question prefetched for this type is used if it finished formatting
+    char enemyType = collidedEnemy->type;
+    int bankIndex = enemyType == 'T' ? 0 : (enemyType == 'F' ? 1 : 2);
+    if (players.size() > 1) {
+        out << "\nPlayer " << answeringPlayer + 1 << " meets an enemy!" << endl;
+    }
+    const PreparedQuestion* prepared = prefetcher.acquire(bankIndex);
+    bool posed = pose_question(enemyType, *world.questions, samplers[bankIndex],
+                               adaptiveQuestions ? &adaptive[bankIndex] : nullptr, prepared, pendingQuestion, out);
+    if (prepared != nullptr) {
+        prefetcher.release(bankIndex);
+    }
+    if (!posed) {
+        applyAnswer(0.0);
+        return false;
+    }
+    
+    answerDeadline = chrono::steady_clock::now() + chrono::milliseconds(answerTimeoutMs);
+    if (answerTimeoutMs > 0 && rawInput) {
+        out << "(Time limit: " << (answerTimeoutMs + 999) / 1000 << "s)" << endl;
+    }
+    out << "Your answer (enter A/B/C/D): ";
+    waitingFor = GameInput::ANSWER;
+    publishSpectator();
+    return true;
+}
+
+/**
+ * @brief Evaluates the answer to the pending question and continues the turn
+ * 
+ * @param key Key returned by input_read_key()
+ * 
+ * An invalid key asks again. Running out of time or input counts as a
+ * wrong answer.
+ */
+void Game::handleAnswerKey(int key) {
+    int answer = 0;
+    bool timedOut = key == INPUT_TIMEOUT;
+    if (key != INPUT_TIMEOUT && key != INPUT_EOF) {
+        answer = toupper(key); // Convert to uppercase for case-insensitive comparison
+        if (answer != 'A' && answer != 'B' && answer != 'C' && answer != 'D') {
+            if (rawInput) out << endl;
+            out << "✗ Invalid input! Please enter A, B, C, or D." << endl;
+            out << "Your answer (enter A/B/C/D): ";
+            return;
+        }
+        echoKey(answer);
+    }
+    
+    int bankIndex = pendingQuestion.enemyType == 'T' ? 0 : (pendingQuestion.enemyType == 'F' ? 1 : 2);
+    double penalty = answer_question(pendingQuestion, questionDifficulty(),
+                                     adaptiveQuestions ? &adaptive[bankIndex] : nullptr, answer, timedOut, out);
+    applyAnswer(penalty);
+    if (enemyPhase) {
+        askQueuedEncounters();
     } else {
-        cout << "Cannot move in that direction! There is an obstacle or invalid direction." << endl;
+        finishMove(false);
+    }
+}
+
+/**
+ * @brief Asks the question of an enemy on the player's cell, if any
+ * 
+ * Blocks until the question is answered; used by real-time mode.
+ * 
+ * @return True if there was an encounter
+ */
+bool Game::resolveEncounter() {
+    Entity* collidedEnemy = checkPlayerCollision(players[0], enemies);
+    if (collidedEnemy == nullptr) {
         return false;
     }
+    
+    handleQuestion(collidedEnemy->type);
+    return true;
 }
 
+// Most ticks run back to back when the loop falls behind; older ones are dropped
+static const int MAX_CATCHUP_TICKS = 5;
+
 /**
- * @brief Processes all enemy movements for the current turn
+ * @brief Real-time loop with a fixed simulation timestep
  * 
- * Applies enemy AI behaviors based on enemy type:
- * - TAs: 65% chance to track player, 35% random movement
- * - Professors: Always track player directly
- * - Students: Always move randomly
+ * Enemies advance every 1/tickRate seconds whatever the player does, and
+ * key presses are applied as soon as poll() reports them. After every
+ * change the loop publishes a frame snapshot to the render thread, which
+ * draws at its own rate; the loop itself never writes the map to the
+ * terminal. It sleeps in poll() until the next tick or key, so it does
+ * not spin. Questions pause the clock; it restarts from the time they end.
+ */
+void Game::realtimeLoop() {
+    typedef chrono::steady_clock Clock;
+    const Clock::duration tickStep = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / tickRate));
+    
+    Clock::time_point nextTick = Clock::now() + tickStep;
+    renderer.start(renderRate);
+    publishFrame();
+    
+    while (currentState == GameState::PLAYING && gameRunning) {
+        Clock::time_point now = Clock::now();
+        
+        // Fixed timestep: run every tick that is due, in order
+        int ticks = 0;
+        while (now >= nextTick && ticks < MAX_CATCHUP_TICKS && currentState == GameState::PLAYING) {
+            Clock::time_point start = Clock::now();
+            bool encounter = simulateTick();
+            Clock::time_point end = Clock::now();
+            ++ticks;
+            if (encounter) {
+                // The question paused the game; restart the clock from now
+                nextTick = end + tickStep;
+                now = end;
+                continue;
+            }
+            tickStats.add(chrono::duration<double, milli>(end - start).count());
+            nextTick += tickStep;
+        }
+        if (now >= nextTick) {
+            // Too far behind to catch up: skip the backlog instead of spiralling
+            droppedTicks += (unsigned long)((now - nextTick) / tickStep) + 1;
+            nextTick = now + tickStep;
+        }
+        if (currentState != GameState::PLAYING) break;
+        if (ticks > 0) publishFrame();
+        
+        // Sleep in poll() until the next tick is due or a key arrives
+        now = Clock::now();
+        int waitMs = nextTick > now ? (int)chrono::duration_cast<chrono::milliseconds>(nextTick - now).count() : 0;
+        int key = input_read_key(waitMs, true);
+        if (key == INPUT_TIMEOUT) continue;
+        
+        Clock::time_point before = Clock::now();
+        applyRealtimeKey(key);
+        Clock::time_point after = Clock::now();
+        publishFrame();
+        
+        // Time spent in a question or save prompt does not count against the clock
+        if (after - before > tickStep) {
+            nextTick = after + tickStep;
+        }
+    }
+    
+    renderer.stop();
+    out << "\033[2J\033[H";
+    if (currentState == GameState::LEVEL_COMPLETE) {
+        out << "Congratulations! You found the exit!" << endl;
+    }
+    reportFrameStats();
+}
+
+/**
+ * @brief Advances the enemies by one real-time tick and resolves encounters
+ * 
+ * @return True if an enemy reached the player and a question was asked
+ */
+bool Game::simulateTick() {
+    endMove(true); // A single player completes a round every tick
+    prefetchQuestions();
+    bool encounter = realtimeEncounter();
+    checkGameState();
+    return encounter;
+}
+
+/**
+ * @brief Resolves an encounter in real-time mode with drawing paused
+ * 
+ * The question and its result stay on screen until a key is pressed.
+ * 
+ * @return True if there was an encounter
+ */
+bool Game::realtimeEncounter() {
+    if (checkPlayerCollision(players[0], enemies) == nullptr) {
+        return false;
+    }
+    
+    renderer.pause();
+    out << "\033[2J\033[H";
+    resolveEncounter();
+    if (currentState == GameState::PLAYING) {
+        out << "Press any key to continue...";
+        if (input_read_key() == INPUT_EOF) {
+            currentState = GameState::MAIN_MENU;
+            gameRunning = false;
+        }
+    }
+    renderer.resume();
+    return true;
+}
+
+/**
+ * @brief Applies one key press in real-time mode
  * 
- * Validates movements against map boundaries and obstacles.
+ * @param key Key returned by input_read_key()
  */
-void Game::enemyTurn() {
-    cout << "\nEnemy turn..." << endl;
+void Game::applyRealtimeKey(int key) {
+    if (key == INPUT_EOF) {
+        currentState = GameState::MAIN_MENU;
+        gameRunning = false;
+        return;
+    }
     
-    // Process all enemy movements using entity system
-    moveEnemies(enemies, player,
-               [this](int x, int y) { return this->isWalkableAdapter(x, y); },
-               map_cols, map_rows);
+    char input = toupper(key);
+    if (input == 'P') {
+        renderer.pause();
+        out << "\033[2J\033[H";
+        saveGameState();
+        renderer.resume();
+        return;
+    }
     
-    cout << "Enemy movement completed" << endl;
+    // Blocked moves are ignored silently; enemies move on ticks, not on moves
+    if (playMove(input) == MoveOutcome::ENCOUNTER) {
+        realtimeEncounter();
+    }
+}
+
+/**
+ * @brief Publishes the current state to the render thread
+ * 
+ * Copies the player, the active enemies and the HUD figures into the
+ * renderer's free snapshot slot; nothing here waits for the terminal.
+ */
+void Game::publishFrame() {
+    FrameSnapshot& frame = renderer.back();
+    frame.world = &world;
+    frame.level = currentLevel;
+    frame.gpa = currentGPA;
+    frame.difficulty = currentDifficulty.name;
+    frame.playerRow = players[0].y;
+    frame.playerCol = players[0].x;
+    frame.enemies.clear();
+    for (const Entity& enemy : enemies) {
+        if (enemy.active) frame.enemies.push_back(enemy);
+    }
+    frame.enemyTotal = enemies.size();
+    frame.tickRate = tickRate;
+    frame.ticks = tickStats.count;
+    frame.tickAvgMs = tickStats.averageMs();
+    frame.tickMaxMs = tickStats.maxMs;
+    frame.droppedTicks = droppedTicks;
+    renderer.publish();
+    publishSpectator();
+}
+
+/**
+ * @brief Publishes the current state to the spectator feed, if there is one
+ * 
+ * Costs a copy of the active enemies; the map is only copied when a new
+ * level was loaded. Nothing waits for the viewers.
+ */
+void Game::publishSpectator() {
+    if (spectator == nullptr) return;
+    spectator->publish(world, currentLevel, currentGPA, currentDifficulty.name,
+                       players.data(), (int)players.size(), enemies);
+}
+
+/**
+ * @brief Prints tick and frame timing statistics of the real-time loop
+ */
+void Game::reportFrameStats() {
+    const FrameStats& frames = renderer.stats();
+    cerr << "[realtime] " << tickStats.count << " ticks at " << tickRate << " Hz: "
+         << tickStats.averageMs() << " ms avg, " << tickStats.maxMs << " ms max; "
+         << droppedTicks << " tick(s) dropped; " << frames.count << " frames drawn: "
+         << frames.averageMs() << " ms avg, " << frames.maxMs << " ms max; "
+         << renderer.superseded() << " stale frame(s) skipped" << endl;
+}
+
+// Enemies this close (Manhattan distance) can reach a player by the next turn
+static const int PREFETCH_DISTANCE = 2;
+
+/**
+ * @brief Prefetches a question for each enemy type about to reach a player
+ * 
+ * The next question is peeked here, on the game thread, without advancing
+ * the sampler or the weights: an enemy that never arrives costs nothing.
+ * Only the text lookup and formatting move to the prefetch thread, and
+ * the encounter's own draw decides whether the prepared text is used.
+ */
+void Game::prefetchQuestions() {
+    if (!prefetching || world.questions == nullptr) return;
+    
+    for (const Entity& enemy : enemies) {
+        if (!enemy.active) continue;
+        const Entity& player = players.size() > 1
+            ? nearestPlayer(world, players.data(), (int)players.size(), enemy, world.map_cols, world.map_rows)
+            : players[0];
+        if (abs(enemy.x - player.x) + abs(enemy.y - player.y) > PREFETCH_DISTANCE) continue;
+        
+        int bankIndex = enemy.type == 'T' ? 0 : (enemy.type == 'F' ? 1 : 2);
+        if (!prefetcher.isEmpty(bankIndex)) continue;
+        
+        const QsBank* bank = world.questions->bank(enemy.type);
+        uint32_t index;
+        bool weighted;
+        if (bank == nullptr || !peek_question(*bank, samplers[bankIndex],
+                                              adaptiveQuestions ? &adaptive[bankIndex] : nullptr,
+                                              index, weighted)) {
+            continue;
+        }
+        prefetcher.request(bankIndex, enemy.type, world.questions, index, weighted);
+    }
 }
 
 /**
@@ -392,52 +1149,57 @@ void Game::enemyTurn() {
  * @param enemyType Type of enemy encountered ('T', 'F', or 'S')
  * 
  * Retrieves an appropriate question based on enemy type and difficulty,
- * evaluates the player's answer, and applies GPA penalties for incorrect
- * answers. Deactivates enemy if answer is correct.
+ * waits for the player's answer and applies it. Only real-time mode
+ * asks this way; turn-based play poses the question and returns.
  */
 void Game::handleQuestion(char enemyType) {
-    // Prepare difficulty settings for question system
-    set_difficulty qsDiff{};
-    qsDiff.initialGPA = currentDifficulty.initialGPA;
-    
-    // Set penalty multipliers based on enemy type
-    if (enemyType == 'T') {
-        qsDiff.ta_penalty_k = currentDifficulty.ta_k;
-    } else if (enemyType == 'F') {
-        qsDiff.prof_penalty_k = currentDifficulty.prof_k;
-    } else if (enemyType == 'S') {
-        qsDiff.stu_penalty_k = currentDifficulty.stu_k;
-    }
+    set_difficulty qsDiff = questionDifficulty();
     
     // Present question and get result
-    double penalty = ask(enemyType, qsDiff);
-    
-    if (penalty > 0) {
-        // Apply GPA penalty for incorrect answer
-        updateGPA(-penalty);
-    } else {
-        // Correct answer - deactivate the enemy
-        Entity* collidedEnemy = checkPlayerCollision(player, enemies);
-        if (collidedEnemy != nullptr) {
-            deactivateEnemy(*collidedEnemy);
-            cout << "Enemy deactivated! You can pass through." << endl;
-        }
+    // Each enemy type draws from its own bank with its own sampler
+    // A question prefetched for this type is used if it finished formatting
+    int bankIndex = enemyType == 'T' ? 0 : (enemyType == 'F' ? 1 : 2);
+    const PreparedQuestion* prepared = prefetcher.acquire(bankIndex);
+    double penalty = ask(enemyType, qsDiff, *world.questions, samplers[bankIndex],
+                         adaptiveQuestions ? &adaptive[bankIndex] : nullptr, prepared, out);
+    if (prepared != nullptr) {
+        prefetcher.release(bankIndex);
     }
+    applyAnswer(penalty);
 }
 
 /**
- * @brief Updates the player's GPA with the specified change
+ * @brief Applies an answered question and reports it
  * 
- * @param change Amount to change GPA by (positive or negative)
+ * @param penalty GPA penalty of the answer (0 if it was correct)
+ * 
+ * A wrong answer costs the penalty; a correct one (or an empty bank)
+ * deactivates the enemy on answeringPlayer's cell. The GPA is shared by
+ * the whole team; a GPA of zero ends the game.
+ */
+void Game::applyAnswer(double penalty) {
+    bool removed = resolveAnswer(penalty);
+    if (penalty > 0) {
+        out << "GPA decreased by " << penalty << endl;
+        out << "Current GPA: " << currentGPA << endl;
+    } else if (removed) {
+        out << "Enemy deactivated! You can pass through." << endl;
+    }
+}
+
+/**
+ * @brief Difficulty settings in the form the question system takes
  * 
- * Applies the change to current GPA, ensures GPA doesn't go below zero,
- * and displays the result to the player.
+ * @return Penalty multipliers of all enemy types and the answer time limit
  */
-void Game::updateGPA(double change) {
-    currentGPA += change;
-    if (currentGPA < 0) currentGPA = 0;
-    cout << "GPA " << (change > 0 ? "increased" : "decreased") << " by " << std::fabs(change) << endl; // 使用std::fabs
-    cout << "Current GPA: " << currentGPA << endl;
+set_difficulty Game::questionDifficulty() const {
+    set_difficulty qsDiff{};
+    qsDiff.initialGPA = currentDifficulty.initialGPA;
+    qsDiff.ta_penalty_k = currentDifficulty.ta_k;
+    qsDiff.prof_penalty_k = currentDifficulty.prof_k;
+    qsDiff.stu_penalty_k = currentDifficulty.stu_k;
+    qsDiff.answerTimeoutMs = answerTimeoutMs;
+    return qsDiff;
 }
 
 /**
@@ -459,34 +1221,138 @@ void Game::checkGameState() {
  * complete game map with all entities, walls, and the exit.
  */
 void Game::displayGameInfo() {
-    cout << "\n==================================" << endl;
-    cout << "       Level " << currentLevel << " - Game Status       " << endl;
-    cout << "==================================" << endl;
+    // Drawing the map is most of a turn's work; skip it when nobody sees it
+    if (out.rdbuf() == nullptr) return;
     
-    cout << "Difficulty: " << currentDifficulty.name << " | GPA: " << currentGPA << endl;
-    cout << "Player position: (" << player.x << ", " << player.y << ")" << endl;
+    out << "\n==================================" << endl;
+    out << "       Level " << currentLevel << " - Game Status       " << endl;
+    out << "==================================" << endl;
     
-    // Prepare active enemies for map display
-    vector<Entity> activeEnemies;
-    for (const auto& enemy : enemies) {
-        if (enemy.active) {
-            activeEnemies.push_back(enemy);
+    out << "Difficulty: " << currentDifficulty.name << " | GPA: " << currentGPA << endl;
+    if (players.size() > 1) {
+        for (size_t i = 0; i < players.size(); ++i) {
+            out << "Player " << i + 1 << " position: (" << players[i].x << ", " << players[i].y << ")" << endl;
         }
+        print_map(out, world, players.data(), (int)players.size(), enemies.data(), (int)enemies.size());
+        out << "Symbols: 1-" << players.size() << "=Players, T=TA, F=Professor, S=Student, #=Wall, .=Empty, E=Exit" << endl;
+        return;
+    }
+    
+    const Entity& player = players[0];
+    out << "Player position: (" << player.x << ", " << player.y << ")" << endl;
+    
+    // Display map with current positions (print_map skips inactive enemies)
+    print_map(out, world, player.y, player.x, enemies.data(), (int)enemies.size());
+    
+    out << "Symbols: P=Player, T=TA, F=Professor, S=Student, #=Wall, .=Empty, E=Exit" << endl;
+}
+
+/**
+ * @brief Snapshots the game state and hands it to the background writer
+ * 
+ * @param autosave True for a periodic autosave
+ * 
+ * Only copies the state on the game thread; serializing, writing and
+ * syncing the file happen on the writer thread, so a save does not
+ * delay the turn. The outcome is reported at the start of a later turn.
+ */
+void Game::saveGameState(bool autosave) {
+    if (players.size() > 1) {
+        out << "Co-op games cannot be saved." << endl;
+        return;
+    }
+    if (!saveWriter) {
+        saveWriter.reset(new SaveWriter());
     }
     
-    // Display map with current positions
-    print_map(player.y, player.x, activeEnemies);
+    // With autosave every save is a checkpoint of the turn journal, and a
+    // checkpoint may only start once the previous one is on disk
+    bool journaling = autosaveTurns > 0;
+    if (journaling) {
+        if (saveWriter->busy()) {
+            if (autosave && journal.isOpen()) return; // Due again next turn
+            saveWriter->wait();
+        }
+        reportSaves();
+    }
+    uint64_t checkpointId = journaling ? new_checkpoint_id() : 0;
     
-    cout << "Symbols: P=Player, T=TA, F=Professor, S=Student, #=Wall, .=Empty, E=Exit" << endl;
+    SaveSnapshot& snapshot = saveWriter->spare();
+    snapshot_game(world, currentLevel, currentGPA, players[0], enemies, currentDifficulty, samplers, snapshot);
+    snapshot.autosave = autosave;
+    snapshot.journalId = checkpointId;
+    saveWriter->submit();
+    turnsSinceSave = 0;
+    if (!autosave) {
+        saveAdaptive();
+        out << "Saving game in the background..." << endl;
+    }
+    if (journaling) {
+        startJournal(checkpointId);
+    }
 }
 
-void Game::saveGameState() {
-    bool success = saveGame(currentLevel, currentGPA, player, enemies, currentDifficulty);
+/**
+ * @brief Starts journaling turns after the checkpoint just submitted
+ * 
+ * @param checkpointId Id stored in the checkpoint
+ * 
+ * The new journal goes to the other journal file, so until the
+ * checkpoint is written the previous journal still leads from the save
+ * on disk. When there is no such journal (new level, loaded game, or the
+ * previous checkpoint failed) the checkpoint is committed first.
+ */
+void Game::startJournal(uint64_t checkpointId) {
+    bool committed = false;
+    if (!journal.isOpen() || !journalCommitted) {
+        saveWriter->wait();
+        committed = reportSaves();
+        if (!committed) {
+            journal.close();
+            return;
+        }
+    }
+    string error;
+    if (!journal.start(checkpointId, players[0], currentGPA, enemies, samplers, error)) {
+        out << "Turn journal disabled until the next autosave (" << error << ")" << endl;
+        return;
+    }
+    journalCommitted = committed;
+}
+
+/**
+ * @brief Appends the last turn to the journal and checkpoints when due
+ * 
+ * A checkpoint is due every autosaveTurns turns, or sooner once the
+ * journal grows past JOURNAL_CHECKPOINT_BYTES.
+ */
+void Game::journalTurn() {
+    if (journal.isOpen() && !journal.append(players[0], currentGPA, enemies, samplers)) {
+        out << "Turn journal disabled until the next autosave (cannot write it)" << endl;
+        journal.close();
+    }
+    if (++turnsSinceSave >= autosaveTurns || journal.size() >= JOURNAL_CHECKPOINT_BYTES) {
+        saveGameState(true);
+        savedThisStep = true;
+    }
+}
+
+/**
+ * @brief Reports the outcome of the last background save, if one finished
+ * 
+ * Successful autosaves stay quiet; failures are always reported.
+ */
+bool Game::reportSaves() {
+    bool success, autosave;
+    string error;
+    if (!saveWriter || !saveWriter->takeResult(success, autosave, error)) return false;
     if (success) {
-        cout << "Game saved successfully!" << endl;
+        journalCommitted = true;
+        if (!autosave) out << "Game saved successfully!" << endl;
     } else {
-        cout << "Game save failed! Please try again." << endl;
+        out << "Game save failed (" << error << ")! Please try again." << endl;
     }
+    return success;
 }
 
 /**
@@ -505,18 +1371,51 @@ bool Game::loadGameState() {
     vector<Entity> loadedEnemies;
     GameDifficultySettings loadedDifficulty;
     
-    bool success = loadGame(loadedLevel, loadedGPA, loadedPlayer, loadedEnemies, loadedDifficulty);
+    // Saves without sampler state keep freshly seeded samplers
+    QsSampler loadedSamplers[3];
+    seedSamplers();
+    for (int i = 0; i < 3; ++i) {
+        loadedSamplers[i] = samplers[i];
+    }
+    
+    // A save still being written must land before it is read back
+    if (saveWriter) {
+        saveWriter->wait();
+    }
+    uint64_t checkpointId;
+    bool success = loadGame(world, loadedLevel, loadedGPA, loadedPlayer, loadedEnemies, loadedDifficulty, loadedSamplers,
+                            checkpointId, out);
     
     if (success) {
-        load_All_Qs();
-        initQsRandom();
+        // Turns played after the save was taken
+        int replayed = replay_journal(checkpointId, world.map_rows, world.map_cols,
+                                      loadedPlayer, loadedGPA, loadedEnemies, loadedSamplers);
+        if (replayed > 0) {
+            out << "Recovered " << replayed << " turn(s) from the turn journal" << endl;
+        }
+        
+        load_All_Qs(out);
+        world.questions = current_Qs();
         
         // Restore all game state from loaded data
         currentLevel = loadedLevel;
         currentGPA = loadedGPA;
-        player = loadedPlayer;
+        // Saves hold one player, so the loaded game continues single-player
+        playerCount = 1;
+        players.assign(1, loadedPlayer);
+        encounterQueue.reserve(players.size());
+        turnPlayer = 0;
+        answeringPlayer = 0;
         enemies = loadedEnemies;
         currentDifficulty = loadedDifficulty;
+        syncAdaptive();
+        for (int i = 0; i < 3; ++i) {
+            samplers[i] = loadedSamplers[i];
+        }
+        prefetcher.clear();
+        if (prefetching) {
+            prefetcher.start();
+        }
         
         // Update game configuration based on loaded difficulty
         if (currentDifficulty.name == "EASY") {
@@ -527,13 +1426,18 @@ bool Game::loadGameState() {
             gameConfig.level = 3;
         }
         setupGameConfig();
+        countEnemies(world, enemies, world.map_cols, world.map_rows);
         
-        // load_map(gameConfig.level, currentLevel);
+        // Journal on from the loaded state, replayed turns included
+        if (autosaveTurns > 0) {
+            journal.close();
+            saveGameState(true);
+        }
         
-        cout << "Game loaded successfully!" << endl;
+        out << "Game loaded successfully!" << endl;
         return true;
     } else {
-        cout << "Game load failed!" << endl;
+        out << "Game load failed!" << endl;
         return false;
     }
 }
@@ -545,34 +1449,391 @@ bool Game::loadGameState() {
  *                false if game ended due to failure
  * 
  * Displays appropriate ending message based on outcome, frees
- * map resources, and offers options to return to main menu or exit.
+ * map resources, and prompts for returning to main menu or exiting.
  */
 void Game::gameOver(bool victory) {
-    cout << "\n==================================" << endl;
+    out << "\n==================================" << endl;
     if (victory) {
-        cout << "          VICTORY!              " << endl;
-        cout << "You successfully escaped the building!" << endl;
-        cout << "Final GPA: " << currentGPA << endl;
+        out << "          VICTORY!              " << endl;
+        out << "You successfully escaped the building!" << endl;
+        out << "Final GPA: " << currentGPA << endl;
     } else {
-        cout << "          GAME OVER             " << endl;
-        cout << "GPA dropped to zero, academic failure..." << endl;
+        out << "          GAME OVER             " << endl;
+        out << "GPA dropped to zero, academic failure..." << endl;
     }
-    cout << "==================================" << endl;
+    out << "==================================" << endl;
+    
+    // Keep what the player learned for the next session
+    saveAdaptive();
     
     // Free dynamically allocated map memory
-    free_map();
+    free_map(world);
     
     // Offer post-game options
-    cout << "\n1. Return to Main Menu" << endl;
-    cout << "2. Exit Game" << endl;
-    cout << "Enter choice (1-2): ";
-    
-    int choice;
-    cin >> choice;
+    out << "\n1. Return to Main Menu" << endl;
+    out << "2. Exit Game" << endl;
+    out << "Enter choice (1-2): ";
+    waitingFor = GameInput::AFTER_GAME;
+}
+
+/**
+ * @brief Processes the post-game choice
+ * 
+ * @param key Key returned by input_read_key()
+ */
+void Game::handleAfterGameKey(int key) {
+    if (key != INPUT_EOF) {
+        echoKey(key);
+    }
     
-    if (choice == 1) {
+    if (key == '1') {
         currentState = GameState::MAIN_MENU;
+        advance();
     } else {
         gameRunning = false;
+        waitingFor = GameInput::NONE;
+    }
+}
+
+// Mixed into a game's seed for its answer stream, so answers do not replay the map and enemy draws
+static const uint64_t ANSWER_STREAM_SALT = 0xA5A5A5A5A5A5A5A5ULL;
+
+/**
+ * @brief Plays a whole game without a terminal, as fast as possible
+ * 
+ * @param options Seed, difficulty, rule overrides and how moves and answers are chosen
+ * @return Outcome and statistics of the game
+ * 
+ * Turns run the same playMove()/endMove() step as every other mode: a
+ * blocked move costs the turn without moving enemies, reaching the exit completes the level,
+ * and enemies reaching a player ask a question. Moves come from the
+ * script or the autopilot; answers are correct with the given
+ * probability. Nothing is formatted or printed during the game, and all
+ * random draws come from this session's world, so games may run on
+ * several threads at once (each with its own Game). The question bank
+ * should already be loaded, since loading it reports to out. Turns that
+ * allocate (counted only in builds with the allocation counter) are
+ * tallied in allocTurns; level loads are not turns and may allocate.
+ */
+HeadlessResult Game::runHeadless(const HeadlessOptions& options) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    
+    startSeeded(options.difficulty, options.seed);
+    game_srand(answerRng, (uint64_t)options.seed ^ ANSWER_STREAM_SALT);
+    correctRate = options.correctRate;
+    setPlayers(options.players);
+    setMapSize(options.mapRows, options.mapCols);
+    setMapDensity(options.wallPercent, options.enemyPercent);
+    
+    // Balance sweeps may replace the difficulty's GPA rules
+    if (options.initialGPA > 0) currentDifficulty.initialGPA = options.initialGPA;
+    if (options.taK >= 0) currentDifficulty.ta_k = options.taK;
+    if (options.profK >= 0) currentDifficulty.prof_k = options.profK;
+    if (options.stuK >= 0) currentDifficulty.stu_k = options.stuK;
+    currentGPA = currentDifficulty.initialGPA;
+    questionsAsked = 0;
+    questionsCorrect = 0;
+    
+    headlessLoadLevel(currentLevel, options.autopilot);
+    currentState = GameState::PLAYING;
+    
+    HeadlessResult result{};
+    size_t scriptPos = 0;
+    long turns = 0;
+    while (result.outcome == nullptr) {
+        if (currentState == GameState::LEVEL_COMPLETE) {
+            if (currentLevel < 3) {
+                headlessLoadLevel(++currentLevel, options.autopilot);
+                currentState = GameState::PLAYING;
+            } else {
+                result.outcome = "win";
+            }
+            continue;
+        }
+        if (currentState == GameState::GAME_OVER) {
+            result.outcome = "lose";
+            continue;
+        }
+        if (turns >= options.maxTurns) {
+            result.outcome = "turn_limit";
+            continue;
+        }
+        
+        char move;
+        if (options.autopilot) {
+            move = autopilotMove();
+        } else {
+            while (scriptPos < options.script.size() && isspace((unsigned char)options.script[scriptPos])) {
+                ++scriptPos;
+            }
+            if (scriptPos == options.script.size()) {
+                result.outcome = "script_end";
+                continue;
+            }
+            move = toupper((unsigned char)options.script[scriptPos++]);
+        }
+        
+        ++turns;
+        size_t allocsBefore = alloc_count();
+        headlessTurn(move);
+        if (alloc_count() != allocsBefore) {
+            ++result.allocTurns;
+        }
+    }
+    
+    free_map(world);
+    
+    result.level = currentLevel;
+    result.turns = turns;
+    result.gpa = currentGPA;
+    result.questions = questionsAsked;
+    result.correct = questionsCorrect;
+    result.elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/**
+ * @brief Sets up a silent, seeded game at level 1 (no level loaded yet)
+ * 
+ * @param difficulty 1 = Easy, 2 = Normal, 3 = Hard (anything else = Normal)
+ * @param seed Seeds map generation, enemy moves and question order
+ */
+void Game::startSeeded(int difficulty, unsigned long seed) {
+    switch (difficulty) {
+        case 1: currentDifficulty = easy(); break;
+        case 3: currentDifficulty = hard(); break;
+        default: currentDifficulty = normal(); break;
+    }
+    gameConfig.level = difficulty >= 1 && difficulty <= 3 ? difficulty : 2;
+    currentGPA = currentDifficulty.initialGPA;
+    
+    // The question order depends on the seed alone: no mastery weights, no stats file
+    adaptiveQuestions = false;
+    world.questions = current_Qs();
+    
+    game_srand(world.rng, seed);
+    for (int i = 0; i < 3; ++i) {
+        sampler_init(samplers[i], ((uint64_t)seed << 2) | (uint64_t)i);
+    }
+    currentLevel = 1;
+}
+
+/**
+ * @brief Loads a level without printing anything
+ * 
+ * @param level Level number to load (1-3)
+ * @param autopilot Also compute the distances the autopilot follows
+ */
+void Game::headlessLoadLevel(int level, bool autopilot) {
+    load_map(world, gameConfig.level, level);
+    placePlayers();
+    initializeEnemiesFromMap();
+    if (autopilot) {
+        computeExitDistances();
+    }
+}
+
+/**
+ * @brief Applies an answered question without any I/O
+ * 
+ * @param penalty GPA penalty of the answer (0 if it was correct)
+ * @return True if an enemy was removed
+ * 
+ * A wrong answer costs the penalty; a correct one (or an empty bank)
+ * removes the enemy from answeringPlayer's cell. The GPA is shared by
+ * the whole team; a GPA of zero ends the game.
+ */
+bool Game::resolveAnswer(double penalty) {
+    bool removed = false;
+    answerPenalty = penalty;
+    if (penalty > 0) {
+        currentGPA -= penalty;
+        if (currentGPA < 0) currentGPA = 0;
+    } else {
+        Entity* collidedEnemy = checkPlayerCollision(players[answeringPlayer], enemies);
+        if (collidedEnemy != nullptr) {
+            deactivateEnemy(*collidedEnemy);
+            removed = true;
+        }
+    }
+    checkGameState();
+    return removed;
+}
+
+/**
+ * @brief Plays one player's turn with a given move and no I/O
+ * 
+ * @param move Direction key (W/A/S/D)
+ * 
+ * Runs the playMove()/endMove() step every mode shares: a blocked move
+ * costs the turn and the same player moves again, walking into an enemy
+ * asks its question and skips the enemies' move, and otherwise the
+ * enemies move once every player has moved, asking everyone they reached
+ * in turn order.
+ */
+void Game::headlessTurn(char move) {
+    MoveOutcome outcome = playMove(move);
+    if (outcome == MoveOutcome::BLOCKED || outcome == MoveOutcome::EXIT) {
+        return;
+    }
+    if (outcome == MoveOutcome::ENCOUNTER) {
+        headlessQuestion(answeringPlayer);
+        endMove(false);
+        return;
+    }
+    if (endMove(true)) {
+        int playerIndex;
+        while (currentState == GameState::PLAYING && (playerIndex = nextEncounter()) >= 0) {
+            headlessQuestion((size_t)playerIndex);
+        }
+    }
+    checkGameState();
+}
+
+/**
+ * @brief Answers the question of the enemy on a player's cell without I/O
+ * 
+ * @param playerIndex Player standing on the enemy's cell
+ * 
+ * Draws from the same per-type sampler as ask(); a correct answer (or an
+ * empty bank) deactivates the enemy, a wrong one costs the scaled penalty.
+ */
+void Game::headlessQuestion(size_t playerIndex) {
+    answeringPlayer = playerIndex;
+    char enemyType = checkPlayerCollision(players[playerIndex], enemies)->type;
+    int bankIndex = enemyType == 'T' ? 0 : (enemyType == 'F' ? 1 : 2);
+    const QsBank* bank = world.questions->bank(enemyType);
+    ++questionsAsked;
+    
+    double penalty = 0.0;
+    uint32_t index;
+    bool weighted;
+    if (bank != nullptr && draw_question(*bank, samplers[bankIndex], nullptr, index, weighted)) {
+        bool correct = game_rand(answerRng) / 2147483648.0 < correctRate;
+        if (correct) {
+            ++questionsCorrect;
+        } else {
+            penalty = question_penalty(enemyType, questionDifficulty(), (*bank)[index].basePenalty);
+        }
+    }
+    resolveAnswer(penalty);
+}
+
+/**
+ * @brief Computes every cell's walking distance to the exit (breadth-first search)
+ * 
+ * Walls block; enemies do not, since walking into one only asks a
+ * question. The map does not change during a level, so this runs once
+ * per level and each autopilot move is a lookup.
+ */
+void Game::computeExitDistances() {
+    size_t cells = (size_t)world.map_rows * world.map_cols;
+    exitDistance.assign(cells, -1);
+    bfsQueue.clear();
+    
+    for (int row = 0; row < world.map_rows; ++row) {
+        for (int col = 0; col < world.map_cols; ++col) {
+            if (at_exit_position(world, row, col)) {
+                exitDistance[(size_t)row * world.map_cols + col] = 0;
+                bfsQueue.push_back(row * world.map_cols + col);
+            }
+        }
+    }
+    
+    static const int dRow[4] = {-1, 1, 0, 0};
+    static const int dCol[4] = {0, 0, -1, 1};
+    for (size_t head = 0; head < bfsQueue.size(); ++head) {
+        int cell = bfsQueue[head];
+        int row = cell / world.map_cols;
+        int col = cell % world.map_cols;
+        for (int d = 0; d < 4; ++d) {
+            int r = row + dRow[d];
+            int c = col + dCol[d];
+            if (r < 0 || r >= world.map_rows || c < 0 || c >= world.map_cols) continue;
+            int& dist = exitDistance[(size_t)r * world.map_cols + c];
+            if (dist >= 0 || !position_walkable(world, r, c)) continue;
+            dist = exitDistance[cell] + 1;
+            bfsQueue.push_back(r * world.map_cols + c);
+        }
+    }
+}
+
+/**
+ * @brief Next move on a shortest path to the exit
+ * 
+ * @return Direction key (W/A/S/D) for the player whose turn it is; 'W' if no neighbour is closer
+ */
+char Game::autopilotMove() const {
+    const Entity& player = players[turnPlayer];
+    static const char keys[4] = {'W', 'S', 'A', 'D'};
+    static const int dRow[4] = {-1, 1, 0, 0};
+    static const int dCol[4] = {0, 0, -1, 1};
+    
+    char best = 'W';
+    int bestDistance = exitDistance[(size_t)player.y * world.map_cols + player.x];
+    for (int d = 0; d < 4; ++d) {
+        int r = player.y + dRow[d];
+        int c = player.x + dCol[d];
+        if (r < 0 || r >= world.map_rows || c < 0 || c >= world.map_cols) continue;
+        int dist = exitDistance[(size_t)r * world.map_cols + c];
+        if (dist >= 0 && (bestDistance < 0 || dist < bestDistance)) {
+            best = keys[d];
+            bestDistance = dist;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Starts a new seeded game at level 1 and waits for the first move
+ * 
+ * @param difficulty 1 = Easy, 2 = Normal, 3 = Hard
+ * @param seed Seeds map generation, enemy moves and question order
+ * 
+ * From here the game is played with feed() like any other. Without the
+ * prefetch thread a server with many sessions starts no thread per game.
+ */
+void Game::remoteStart(int difficulty, unsigned long seed) {
+    startSeeded(difficulty, seed);
+    prefetching = false;
+    gameRunning = true;
+    loadLevel(currentLevel);
+    currentState = GameState::PLAYING;
+    advance();
+}
+
+/**
+ * @brief Writes the current map as plain text, one line per row
+ * 
+ * @param text Output text; its capacity is reused
+ * 
+ * Shows the player as P and active enemies by type on top of the map
+ * tiles, without colours.
+ */
+void Game::remoteMap(string& text) const {
+    text.clear();
+    size_t lineLength = (size_t)world.map_cols + 1;
+    for (int row = 0; row < world.map_rows; ++row) {
+        text.append(world.map_data[row], world.map_cols);
+        text.push_back('\n');
+    }
+    for (const Entity& enemy : enemies) {
+        if (enemy.active && enemy.y >= 0 && enemy.y < world.map_rows && enemy.x >= 0 && enemy.x < world.map_cols) {
+            text[enemy.y * lineLength + enemy.x] = enemy.type;
+        }
+    }
+    if (!text.empty()) {
+        text[players[0].y * lineLength + players[0].x] = 'P';
+    }
+}
+
+/**
+ * @brief Number of enemies still active on the current level
+ */
+int Game::activeEnemyCount() const {
+    int count = 0;
+    for (const Entity& enemy : enemies) {
+        if (enemy.active) ++count;
     }
+    return count;
 }
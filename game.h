@@ -2,13 +2,55 @@
 #define GAME_H
 #include <string>
 #include <vector>
-#include <functional>
+#include <memory>
+#include <chrono>
 #include "map.h"
 #include "question.h"
+#include "prefetch.h"
+#include "render.h"
 #include "save.h"
 #include "entity.h"
+#include "save_writer.h"
+#include "journal.h"
+
+class SpectatorFeed;
 using namespace std;
 
+/**
+ * @brief Settings of one headless (batch) game
+ */
+struct HeadlessOptions {
+    unsigned long seed;  ///< Seeds map generation, enemy moves, question order and answers
+    int difficulty;      ///< 1 = Easy, 2 = Normal, 3 = Hard
+    string script;       ///< Moves to play (W/A/S/D; other characters are skipped)
+    bool autopilot;      ///< Walk the shortest path to each exit instead of following the script
+    double correctRate;  ///< Probability of answering a question correctly
+    long maxTurns;       ///< Turn limit over the whole game
+    int players;         ///< Players sharing the map and moving in turn (1-9)
+    int mapRows;         ///< Size of every level (0 = the difficulty's size)
+    int mapCols;
+    int wallPercent;     ///< Chance (0-100) that a cell off the safe path is a wall (-1 = the difficulty's)
+    int enemyPercent;    ///< Chance (0-100) that a remaining cell holds an enemy (-1 = the difficulty's)
+    double initialGPA;   ///< GPA the game starts with (0 = the difficulty's)
+    double taK;          ///< Penalty multiplier of TA questions (negative = the difficulty's)
+    double profK;        ///< Penalty multiplier of Professor questions (negative = the difficulty's)
+    double stuK;         ///< Penalty multiplier of Student questions (negative = the difficulty's)
+};
+
+/**
+ * @brief Outcome of one headless game
+ */
+struct HeadlessResult {
+    const char* outcome; ///< "win", "lose", "script_end" or "turn_limit"
+    int level;           ///< Level reached
+    long turns;          ///< Turns played (one per player move)
+    double gpa;          ///< Final GPA
+    int questions;       ///< Questions asked
+    int correct;         ///< Questions answered correctly
+    double elapsedMs;    ///< Wall-clock time of the game
+    long allocTurns;     ///< Turns that touched the heap (always 0 unless the allocation counter is built in)
+};
+
 /**
  * @brief Enumeration representing the different states of the game
  */
@@ -20,6 +62,28 @@ enum class GameState {
     VICTORY         ///< Game completed successfully
 };
 
+/**
+ * @brief Input a resumable game is waiting for before it can continue
+ */
+enum class GameInput {
+    NONE,           ///< Nothing: the game has ended
+    MENU,           ///< Main menu choice (1-3)
+    DIFFICULTY,     ///< Difficulty choice (1-3)
+    MOVE,           ///< Movement direction (W/A/S/D) or P to save
+    ANSWER,         ///< Answer to the pending question (A-D)
+    AFTER_GAME      ///< Post-game choice (1 = main menu, 2 = exit)
+};
+
+/**
+ * @brief What a player's move led to
+ */
+enum class MoveOutcome {
+    BLOCKED,        ///< Wall or no direction: nothing moved, the same player moves again
+    EXIT,           ///< The player reached the exit and the level is complete
+    ENCOUNTER,      ///< The player walked into an enemy, whose question comes first
+    MOVED           ///< The player moved to a free cell
+};
+
 /**
  * @brief Main game controller class that manages the entire game flow
  * 
@@ -29,15 +93,57 @@ enum class GameState {
  */
 class Game {
 private:
+    World world;                              ///< Map, random stream and question snapshot of this session
+    ostream out;                              ///< Where this session prints (cout unless setOutput() changed it)
+    bool rawInput;                            ///< Keys come one at a time from a terminal (set by run())
     GameDifficultySettings currentDifficulty; ///< Current difficulty settings
     GameState currentState;                   ///< Current state of the game
     double currentGPA;                        ///< Player's current GPA value
     int currentLevel;                         ///< Current level (1-3)
     bool gameRunning;                         ///< Flag indicating if game is active
+    bool savedThisStep;                       ///< Set when the current step saved the game
+    unique_ptr<SaveWriter> saveWriter;        ///< Writes saves in the background (created by the first save)
+    int autosaveTurns;                        ///< Turns between autosaves (0 = off)
+    int turnsSinceSave;                       ///< Turns since the last save or autosave
+    TurnJournal journal;                      ///< Turns since the last checkpoint (autosave only)
+    bool journalCommitted;                    ///< The checkpoint the journal follows is on disk
+    GameInput waitingFor;                     ///< Input the game stopped for
+    PendingQuestion pendingQuestion;          ///< Question awaiting an answer (waitingFor == ANSWER)
+    double answerPenalty;                     ///< GPA the last answer cost (0 if it was correct)
+    chrono::steady_clock::time_point answerDeadline; ///< When the pending question times out
+    size_t stepAllocs;                        ///< Heap allocation count when the current step began
     
     GameConfig gameConfig;                    ///< Configuration for current game
-    Entity player;                            ///< Player entity with position and status
+    vector<Entity> players;                   ///< Players sharing the map (one unless co-op)
+    int playerCount;                          ///< Players in each new game (1-9)
+    size_t turnPlayer;                        ///< Player who moves next
+    size_t answeringPlayer;                   ///< Player the current question is for
+    bool enemyPhase;                          ///< The current question follows the enemies' move
+    vector<int> encounterQueue;               ///< Players the enemies' move caught, in turn order
+    size_t encounterNext;                     ///< Next entry of encounterQueue to ask
     vector<Entity> enemies;                   ///< List of all enemy entities in current level
+    QsSampler samplers[3];                    ///< Question samplers for TA, Professor, Student banks
+    QsAdaptive adaptive[3];                   ///< Mastery weights for TA, Professor, Student banks
+    shared_ptr<const QuestionSet> adaptiveSource; ///< Bank snapshot the trackers were last matched to
+    bool adaptiveQuestions;                   ///< Pick questions by mastery weight instead of cycling
+    QuestionPrefetcher prefetcher;            ///< Prepares questions for enemies close to the player
+    bool prefetching;                         ///< Use the prefetcher (off for remote games)
+    int answerTimeoutMs;                      ///< Time allowed per question in milliseconds (0 = unlimited)
+    bool realtimeMode;                        ///< Enemies move on a fixed timestep instead of per turn
+    int tickRate;                             ///< Enemy simulation ticks per second in real-time mode
+    int renderRate;                           ///< Frames drawn per second in real-time mode
+    FrameStats tickStats;                     ///< Time spent simulating each tick
+    FrameRenderer renderer;                   ///< Render thread used in real-time mode
+    SpectatorFeed* spectator;                 ///< Shared-memory feed for external viewers (not owned, may be null)
+    
+    // Headless mode
+    RandomStream answerRng;                   ///< Decides whether a headless answer is correct
+    double correctRate;                       ///< Probability of a correct headless answer
+    int questionsAsked;                       ///< Questions asked in the headless game
+    int questionsCorrect;                     ///< Questions answered correctly in the headless game
+    vector<int> exitDistance;                 ///< Steps from each cell to the exit (-1 = unreachable)
+    vector<int> bfsQueue;                     ///< Scratch queue for computing exitDistance
+    unsigned long droppedTicks;               ///< Ticks skipped because the loop fell behind
     
     // Core game flow methods
     
@@ -52,15 +158,28 @@ private:
     void showMainMenu();
     
     /**
-     * @brief Handles user input from the main menu
+     * @brief Echoes a key read in single-key terminal mode, which the terminal does not show
+     * @param key Key returned by input_read_key()
      */
-    void handleMenuInput();
+    void echoKey(int key);
     
     /**
-     * @brief Shows difficulty selection screen and processes choice
+     * @brief Handles the main menu choice
+     * @param key Key returned by input_read_key()
+     */
+    void handleMenuKey(int key);
+    
+    /**
+     * @brief Shows the difficulty selection screen
      */
     void selectDifficulty();
     
+    /**
+     * @brief Handles the difficulty choice and starts the game
+     * @param key Key returned by input_read_key()
+     */
+    void handleDifficultyKey(int key);
+    
     /**
      * @brief Sets game difficulty based on user selection
      * @param difficultyChoice User's difficulty selection (1-3)
@@ -84,32 +203,215 @@ private:
     void initializeEnemiesFromMap();
     
     /**
-     * @brief Main game loop for active gameplay
+     * @brief Sets the behavior modifiers of all enemies for the current difficulty and stage
      */
-    void gameLoop();
+    void assignEnemyBehaviors();
     
-   /**
-    * @brief Processes the player's turn including movement and actions
-    * @return true if player saved the game, false if player moved
-    */
-    bool playerTurn();    
+    /**
+     * @brief Runs the game forward until it needs input, and prompts for it
+     */
+    void advance();
     
     /**
-     * @brief Processes all enemy movements and AI behavior
+     * @brief Shows the game status and prompts for a move
      */
-    void enemyTurn();
+    void beginTurn();
     
     /**
-     * @brief Handles question/answer sequence when encountering enemies
-     * @param enemyType Type of enemy encountered ('T', 'F', or 'S')
+     * @brief Finishes the current turn and continues to the next prompt
      */
-    void handleQuestion(char enemyType);
+    void endTurn();
+    
+    /**
+     * @brief Starts the allocation check of one step of a turn
+     */
+    void beginStep();
+    
+    /**
+     * @brief Reports heap allocations made since beginStep() (allocation counter builds)
+     */
+    void endStep();
+    
+    /**
+     * @brief Plays a player's move: movement, encounters and enemy moves
+     * @param key Key returned by input_read_key()
+     */
+    void handleMoveKey(int key);
+    
+    /**
+     * @brief Moves the player whose turn it is; the step every mode shares
+     * @param move Direction key (W/A/S/D)
+     * @return What the move led to (ENCOUNTER sets answeringPlayer)
+     */
+    MoveOutcome playMove(char move);
+    
+    /**
+     * @brief Passes the turn on; after the last player, moves the enemies (no I/O)
+     * @param enemiesMayMove False if the move ended in an encounter, which skips the enemies' move
+     * @return True if the enemies moved and nextEncounter() yields who they reached
+     */
+    bool endMove(bool enemiesMayMove);
+    
+    /**
+     * @brief Ends a terminal move with endMove() and asks who the enemies reached
+     * @param enemiesMayMove False if the move ended in an encounter, which skips the enemies' move
+     */
+    void finishMove(bool enemiesMayMove);
+    
+    /**
+     * @brief Asks the queued encounters one by one, then ends the round
+     */
+    void askQueuedEncounters();
+    
+    /**
+     * @brief Puts the question of the enemy on answeringPlayer's cell
+     * @return True if the game now waits for the answer, false if there was nothing to ask
+     */
+    bool poseQuestion();
+    
+    /**
+     * @brief Evaluates the answer to the pending question
+     * @param key Key returned by input_read_key()
+     */
+    void handleAnswerKey(int key);
+    
+    /**
+     * @brief Applies answeringPlayer's answer with messages: the penalty, or removing the enemy
+     * @param penalty GPA penalty of the answer (0 if it was correct)
+     */
+    void applyAnswer(double penalty);
+    
+    /**
+     * @brief Places every player at the map's start for a new level
+     */
+    void placePlayers();
+    
+    /**
+     * @brief Advances turnPlayer to the next player
+     * @return True if that completed a round (every player has moved)
+     */
+    bool endOfRound();
+    
+    /**
+     * @brief Queues the players the enemies' last move caught
+     */
+    void queueEncounters();
+    
+    /**
+     * @brief Takes the next queued player still on an active enemy's cell
+     * @return Player index, or -1 if none is left
+     */
+    int nextEncounter();
+    
+    /**
+     * @brief Handles the post-game choice
+     * @param key Key returned by input_read_key()
+     */
+    void handleAfterGameKey(int key);
+    
+    /**
+     * @brief Real-time loop: fixed-timestep enemy ticks, input as it arrives, rendering at its own rate
+     */
+    void realtimeLoop();
+    
+    /**
+     * @brief Advances the enemies by one real-time tick and resolves encounters
+     * @return True if an enemy reached the player and a question was asked
+     */
+    bool simulateTick();
+    
+    /**
+     * @brief Resolves an encounter in real-time mode with drawing paused
+     * @return True if there was an encounter
+     */
+    bool realtimeEncounter();
+    
+    /**
+     * @brief Applies one key press in real-time mode
+     * @param key Key returned by input_read_key()
+     */
+    void applyRealtimeKey(int key);
+    
+    /**
+     * @brief Publishes the current state to the render thread
+     */
+    void publishFrame();
+    
+    /**
+     * @brief Prints tick and frame timing statistics of the real-time loop
+     */
+    void reportFrameStats();
+    
+    /**
+     * @brief Publishes the current state to the spectator feed, if there is one
+     */
+    void publishSpectator();
+    
+    /**
+     * @brief Asks the question of an enemy on the player's cell and waits for the answer
+     * @return True if there was an encounter
+     */
+    bool resolveEncounter();
+    
+    /**
+     * @brief Difficulty settings in the form the question system takes
+     */
+    set_difficulty questionDifficulty() const;
+    
+    /**
+     * @brief Sets up a silent, seeded game at level 1 (no level loaded yet)
+     * @param difficulty 1 = Easy, 2 = Normal, 3 = Hard
+     * @param seed Seeds map generation, enemy moves and question order
+     */
+    void startSeeded(int difficulty, unsigned long seed);
+    
+    /**
+     * @brief Loads a level without printing anything
+     * @param level Level number to load (1-3)
+     * @param autopilot Also compute the distances the autopilot follows
+     */
+    void headlessLoadLevel(int level, bool autopilot);
+    
+    /**
+     * @brief Applies answeringPlayer's answer: the penalty, or removing the enemy (no I/O)
+     * @param penalty GPA penalty of the answer (0 if it was correct)
+     * @return True if an enemy was removed
+     */
+    bool resolveAnswer(double penalty);
+    
+    /**
+     * @brief Plays one turn with a given move and no I/O
+     * @param move Direction key (W/A/S/D)
+     */
+    void headlessTurn(char move);
+    
+    /**
+     * @brief Answers the question of the enemy on a player's cell without I/O
+     * @param playerIndex Player standing on the enemy's cell
+     */
+    void headlessQuestion(size_t playerIndex);
     
     /**
-     * @brief Updates player's GPA with specified change
-     * @param change Amount to change GPA by (positive or negative)
+     * @brief Computes every cell's walking distance to the exit (breadth-first search)
      */
-    void updateGPA(double change);
+    void computeExitDistances();
+    
+    /**
+     * @brief Next move on a shortest path to the exit
+     * @return Direction key (W/A/S/D)
+     */
+    char autopilotMove() const;
+    
+    /**
+     * @brief Prefetches a question for each enemy type about to reach the player
+     */
+    void prefetchQuestions();
+    
+    /**
+     * @brief Asks an enemy's question and waits for the answer (real-time mode)
+     * @param enemyType Type of enemy encountered ('T', 'F', or 'S')
+     */
+    void handleQuestion(char enemyType);
     
     /**
      * @brief Checks if game should end due to victory or failure
@@ -122,15 +424,33 @@ private:
     void displayGameInfo();
     
     /**
-     * @brief Handles game completion (both victory and failure)
+     * @brief Shows the end of the game (victory or failure) and the post-game menu
      * @param victory True if player won, false if game over
      */
     void gameOver(bool victory);
     
     /**
-     * @brief Saves current game state to file
+     * @brief Snapshots the game state and saves it in the background
+     * @param autosave True for a periodic autosave, which only reports failures
      */
-    void saveGameState();
+    void saveGameState(bool autosave = false);
+    
+    /**
+     * @brief Reports background saves that finished since the last turn
+     * @return True if a save finished and was committed
+     */
+    bool reportSaves();
+    
+    /**
+     * @brief Starts journaling turns after the checkpoint just submitted
+     * @param checkpointId Id stored in the checkpoint
+     */
+    void startJournal(uint64_t checkpointId);
+    
+    /**
+     * @brief Journals the turn just played and takes a checkpoint when one is due
+     */
+    void journalTurn();
     
     /**
      * @brief Loads game state from saved file
@@ -138,13 +458,31 @@ private:
      */
     bool loadGameState();
     
+    /**
+     * @brief Starts fresh question samplers for a new session
+     */
+    void seedSamplers();
+    
+    /**
+     * @brief Matches the mastery trackers to the current question banks
+     * 
+     * Resets and reloads them from the stats file when a bank changed size.
+     */
+    void syncAdaptive();
+    
+    /**
+     * @brief Writes the mastery trackers to the stats side file
+     */
+    void saveAdaptive();
+    
     /**
      * @brief Adapter function to bridge entity system with map system
+     * @param world World whose map is checked
      * @param x X-coordinate (entity system)
      * @param y Y-coordinate (entity system)
      * @return True if position is walkable
      */
-    bool isWalkableAdapter(int x, int y);
+    static bool isWalkableAdapter(const World& world, int x, int y);
 
 public:
     /**
@@ -154,8 +492,161 @@ public:
     
     /**
      * @brief Main entry point that runs the complete game from start to finish
+     * 
+     * Drives start() and feed() with keys from the terminal (or piped
+     * standard input) until the player exits.
      */
     void run();
+    
+    // Resumable play: the game runs until it needs input, then returns.
+    // Between inputs a session is only this object; no thread or stack
+    // waits on it, so one thread can drive any number of sessions.
+    
+    /**
+     * @brief Shows the main menu and waits for the first input
+     */
+    void start();
+    
+    /**
+     * @brief Resumes the game with one input
+     * @param key Key returned by input_read_key(), including INPUT_EOF and INPUT_TIMEOUT
+     * 
+     * Runs until the game needs the next input and prompts for it;
+     * awaiting() then tells which. Ignored once the game has ended.
+     */
+    void feed(int key);
+    
+    /**
+     * @brief Input the game is waiting for (NONE once it has ended)
+     */
+    GameInput awaiting() const { return waitingFor; }
+    
+    /**
+     * @brief Question waiting for its answer (valid while awaiting() is ANSWER)
+     */
+    const PendingQuestion& question() const { return pendingQuestion; }
+    
+    /**
+     * @brief GPA penalty of the last answer fed to the game (0 if it was correct)
+     */
+    double lastPenalty() const { return answerPenalty; }
+    
+    /**
+     * @brief Sends everything this session prints to a stream buffer
+     * @param sink Buffer to write to, or nullptr to discard the output
+     * 
+     * Prompts, maps and results all go through it, so sessions sharing a
+     * process do not share the terminal. Discarded output costs little:
+     * the stream is in a failed state and formats nothing.
+     */
+    void setOutput(streambuf* sink) { out.rdbuf(sink); }
+    
+    /**
+     * @brief Milliseconds left to answer the pending question
+     * @return -1 if there is no time limit or no question
+     * 
+     * feed(INPUT_TIMEOUT) once this reaches 0 counts as a wrong answer.
+     */
+    int inputTimeoutMs() const;
+    
+    /**
+     * @brief Sets the time allowed to answer each question
+     * @param seconds Seconds per question, or 0 for no limit
+     * 
+     * Only enforced when keys are read from a terminal.
+     */
+    void setAnswerTimeout(int seconds);
+    
+    /**
+     * @brief Saves the game in the background every few turns
+     * 
+     * Autosaves are checkpoints: every turn in between is appended to a
+     * turn journal, which loading replays after the checkpoint.
+     * 
+     * @param turns Turns between autosaves, or 0 to turn autosave off
+     */
+    void setAutosave(int turns) { autosaveTurns = turns > 0 ? turns : 0; }
+    
+    /**
+     * @brief Sets how many players share the map in new games (co-op)
+     * @param count Players, 1-9; they move in turn and enemies chase the nearest
+     * 
+     * Co-op games are turn-based and cannot be saved.
+     */
+    void setPlayers(int count);
+    
+    /**
+     * @brief Generates every following level of this session at a fixed size
+     * @param rows Map height (at least 3), or 0 for the difficulty's sizes
+     * @param cols Map width (at least 3), or 0 for the difficulty's sizes
+     */
+    void setMapSize(int rows, int cols) { set_map_size_override(world, rows, cols); }
+    
+    /**
+     * @brief Generates every following level of this session with fixed wall and enemy percentages
+     * @param wallPercent Chance (0-100) that a cell off the safe path is a wall, or -1 for the difficulty's
+     * @param enemyPercent Chance (0-100) that a remaining cell holds an enemy, or -1 for the difficulty's
+     */
+    void setMapDensity(int wallPercent, int enemyPercent) { set_map_density_override(world, wallPercent, enemyPercent); }
+    
+    /**
+     * @brief Publishes every turn (or real-time frame) of interactive games to a feed
+     * @param feed Open feed, or nullptr to stop; must outlive the game
+     */
+    void setSpectator(SpectatorFeed* feed) { spectator = feed; }
+    
+    /**
+     * @brief Enables real-time mode, where enemies move on their own clock
+     * @param ticksPerSecond Enemy simulation rate
+     * @param framesPerSecond Screen refresh rate
+     * 
+     * Needs single-key terminal input; without it the game stays turn-based.
+     */
+    void setRealtime(int ticksPerSecond, int framesPerSecond);
+    
+    /**
+     * @brief Plays a whole game without a terminal, as fast as possible
+     * @param options Seed, difficulty, rule overrides and how moves and answers are chosen
+     * @return Outcome and statistics of the game
+     * 
+     * Runs the same map generation, enemy movement and question logic as
+     * an interactive game but prints nothing, and neither saves nor
+     * updates the mastery stats file. The same options always produce
+     * the same game. Several threads may each run games on their own
+     * Game at once, once the question bank is loaded.
+     */
+    HeadlessResult runHeadless(const HeadlessOptions& options);
+    
+    // Remote play: a server session drives the game with feed() and
+    // reads the outcome through the accessors; nothing blocks on input.
+    
+    /**
+     * @brief Starts a new seeded game at level 1 and waits for the first move
+     * @param difficulty 1 = Easy, 2 = Normal, 3 = Hard
+     * @param seed Seeds map generation, enemy moves and question order
+     * 
+     * The game then plays as a terminal game would, through feed(), but
+     * without mastery weights, saves or a prefetch thread, so the same
+     * seed and inputs always produce the same game.
+     */
+    void remoteStart(int difficulty, unsigned long seed);
+    
+    /**
+     * @brief Writes the current map with the player and active enemies on it, one line per row
+     * @param text Output text; its capacity is reused
+     */
+    void remoteMap(string& text) const;
+    
+    GameState getState() const { return currentState; }
+    int getLevel() const { return currentLevel; }
+    double getGPA() const { return currentGPA; }
+    const Entity& getPlayer() const { return players[0]; }
+    const World& getWorld() const { return world; }
+    
+    /**
+     * @brief Number of enemies still active on the current level
+     */
+    int activeEnemyCount() const;
 };
 
 #endif
@@ -0,0 +1,122 @@
+// Reference spectator: follows a game started with --spectate NAME from shared memory
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include "spectate.h"
+
+using namespace std;
+
+// Largest part of the map drawn around the first player
+static const int VIEW_ROWS = 40;
+static const int VIEW_COLS = 100;
+
+static void print_usage(const char* program) {
+    cerr << "Usage: " << program << " NAME [options]" << endl;
+    cerr << "  --hz N     polls per second (default 20)" << endl;
+    cerr << "  --once     print the current frame and exit" << endl;
+}
+
+// Draw one frame as plain text, cropped around the first player on large maps
+static void draw(const SpectatorFrame& frame, bool clear, string& out) {
+    int viewRows = frame.rows < VIEW_ROWS ? frame.rows : VIEW_ROWS;
+    int viewCols = frame.cols < VIEW_COLS ? frame.cols : VIEW_COLS;
+    int centerRow = frame.players.empty() ? 0 : frame.players[0];
+    int centerCol = frame.players.empty() ? 0 : frame.players[1];
+    int top = centerRow - viewRows / 2;
+    int left = centerCol - viewCols / 2;
+    if (top > frame.rows - viewRows) top = frame.rows - viewRows;
+    if (left > frame.cols - viewCols) left = frame.cols - viewCols;
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+
+    // Cells of the view, then enemies and players on top (players win a shared cell)
+    vector<char> view((size_t)viewRows * viewCols);
+    for (int r = 0; r < viewRows; ++r) {
+        memcpy(&view[(size_t)r * viewCols], &frame.grid[(size_t)(top + r) * frame.cols + left], viewCols);
+    }
+    for (const SpectatorEnemy& enemy : frame.enemies) {
+        int r = enemy.row - top;
+        int c = enemy.col - left;
+        if (r >= 0 && r < viewRows && c >= 0 && c < viewCols) view[(size_t)r * viewCols + c] = enemy.type;
+    }
+    size_t playerCount = frame.players.size() / 2;
+    for (size_t i = playerCount; i-- > 0;) {
+        int r = frame.players[i * 2] - top;
+        int c = frame.players[i * 2 + 1] - left;
+        if (r >= 0 && r < viewRows && c >= 0 && c < viewCols) {
+            view[(size_t)r * viewCols + c] = playerCount > 1 ? (char)('1' + i) : 'P';
+        }
+    }
+
+    out.clear();
+    if (clear) out += "\033[2J\033[H";
+    out += "Level " + to_string(frame.level) + " | " + frame.difficulty + " | GPA: ";
+    char gpa[32];
+    snprintf(gpa, sizeof(gpa), "%.2f", frame.gpa);
+    out += gpa;
+    out += " | Enemies: " + to_string(frame.enemies.size()) + "/" + to_string(frame.enemyTotal);
+    out += " | Frame " + to_string(frame.frame) + "\n";
+    for (int r = 0; r < viewRows; ++r) {
+        out.append(&view[(size_t)r * viewCols], viewCols);
+        out += '\n';
+    }
+    cout << out << flush;
+}
+
+int main(int argc, char* argv[]) {
+    string name;
+    int hz = 20;
+    bool once = false;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--hz") == 0 && hasValue) {
+            hz = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--once") == 0) {
+            once = true;
+        } else if (argv[i][0] != '-' && name.empty()) {
+            name = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (name.empty() || hz < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    SpectatorView view;
+    SpectatorFrame frame;
+    string out;
+    chrono::milliseconds period(1000 / hz);
+    bool waiting = false;
+    while (true) {
+        if (view.closed()) {
+            // Not started yet, ended, or moved to a larger segment: (re)open by name
+            if (!view.open(name)) {
+                if (once) {
+                    cerr << "Error: No game is publishing to " << name << endl;
+                    return 1;
+                }
+                if (!waiting) {
+                    cout << "Waiting for a game started with --spectate " << name << "..." << endl;
+                    waiting = true;
+                }
+                this_thread::sleep_for(chrono::milliseconds(500));
+                continue;
+            }
+            frame = SpectatorFrame();
+            waiting = false;
+        }
+        if (view.poll(frame)) {
+            draw(frame, !once, out);
+            if (once) return 0;
+        }
+        this_thread::sleep_for(period);
+    }
+}
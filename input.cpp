@@ -0,0 +1,200 @@
+#include "input.h"
+#include <iostream>
+#include <limits>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+using namespace std;
+
+static bool rawMode = false;
+static struct termios savedTermios;
+
+// Bytes read from the terminal but not yet returned as keys
+static unsigned char pending[64];
+static size_t pendingStart = 0;
+static size_t pendingEnd = 0;
+
+// How long to wait for the rest of an arrow-key sequence after ESC
+static const int ESCAPE_WAIT_MS = 10;
+
+static void restore_terminal() {
+    if (rawMode) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedTermios);
+        rawMode = false;
+    }
+}
+
+// Restore the terminal before an interrupt ends the process
+static void restore_and_reraise(int sig) {
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedTermios);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+bool input_init() {
+    if (rawMode) return true;
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &savedTermios) != 0) {
+        return false;
+    }
+
+    // Keep signal keys (Ctrl-C) and output processing; drop line buffering and echo
+    struct termios raw = savedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) {
+        return false;
+    }
+    rawMode = true;
+
+    static bool handlersInstalled = false;
+    if (!handlersInstalled) {
+        handlersInstalled = true;
+        atexit(restore_terminal);
+        const int signals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+        for (int sig : signals) {
+            struct sigaction action;
+            action.sa_handler = restore_and_reraise;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = 0;
+            sigaction(sig, &action, nullptr);
+        }
+    }
+    return true;
+}
+
+void input_shutdown() {
+    restore_terminal();
+    pendingStart = pendingEnd = 0;
+}
+
+bool input_is_raw() {
+    return rawMode;
+}
+
+// Wait up to timeoutMs for more terminal bytes; 1 = got some, 0 = timeout, -1 = EOF
+static int fill_pending(int timeoutMs) {
+    if (pendingStart == pendingEnd) {
+        pendingStart = pendingEnd = 0;
+    } else if (pendingEnd == sizeof(pending)) {
+        if (pendingStart == 0) return 1;
+        memmove(pending, pending + pendingStart, pendingEnd - pendingStart);
+        pendingEnd -= pendingStart;
+        pendingStart = 0;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return 0;
+    }
+    ssize_t n = read(STDIN_FILENO, pending + pendingEnd, sizeof(pending) - pendingEnd);
+    if (n <= 0) {
+        return -1;
+    }
+    pendingEnd += (size_t)n;
+    return 1;
+}
+
+// Decode one key from the pending bytes (arrow escape sequences become W/A/S/D)
+static int take_key() {
+    unsigned char c = pending[pendingStart++];
+    if (c != 0x1b) {
+        return c;
+    }
+
+    while (pendingEnd - pendingStart < 2 && fill_pending(ESCAPE_WAIT_MS) > 0) {
+    }
+    if (pendingEnd - pendingStart >= 2 && (pending[pendingStart] == '[' || pending[pendingStart] == 'O')) {
+        switch (pending[pendingStart + 1]) {
+            case 'A': pendingStart += 2; return 'W';
+            case 'B': pendingStart += 2; return 'S';
+            case 'C': pendingStart += 2; return 'D';
+            case 'D': pendingStart += 2; return 'A';
+            default: break;
+        }
+    }
+    return c;
+}
+
+// Line-based input for pipes and files: first character of the next line
+static int read_line_key() {
+    char c;
+    if (!(cin >> c)) {
+        return INPUT_EOF;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    return (unsigned char)c;
+}
+
+int input_read_key(int timeoutMs, bool coalesceRepeats) {
+    cout.flush();
+    if (!rawMode) {
+        return read_line_key();
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    for (;;) {
+        if (pendingStart == pendingEnd) {
+            int wait = -1;
+            if (timeoutMs >= 0) {
+                auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+                wait = left.count() > 0 ? (int)left.count() : 0;
+            }
+            int got = fill_pending(wait);
+            if (got < 0) return INPUT_EOF;
+            if (got == 0) return INPUT_TIMEOUT;
+        }
+
+        int key = take_key();
+        if (key == 0x04) {
+            return INPUT_EOF; // Ctrl-D
+        }
+        if (key == ' ' || key == '\n' || key == '\r' || key == '\t') {
+            continue; // Whitespace is skipped, as with cin >>
+        }
+
+        if (coalesceRepeats) {
+            // Drain what the terminal already has, then drop queued copies of this key
+            fill_pending(0);
+            while (pendingStart < pendingEnd) {
+                if (pending[pendingStart] == 0x1b && pendingEnd - pendingStart < 3) break;
+                size_t mark = pendingStart;
+                if (take_key() != key) {
+                    pendingStart = mark;
+                    break;
+                }
+            }
+        }
+        return key;
+    }
+}
+
+void input_flush() {
+    if (!rawMode) return;
+    pendingStart = pendingEnd = 0;
+    tcflush(STDIN_FILENO, TCIFLUSH);
+}
+
+void input_echo_key(int key) {
+    if (!rawMode) return;
+    cout << (char)key << endl;
+}
+
+bool input_terminal_size(int& rows, int& cols) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_row == 0 || ws.ws_col == 0) {
+        return false;
+    }
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+    return true;
+}
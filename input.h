@@ -0,0 +1,68 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+using namespace std;
+
+// Special results of input_read_key()
+const int INPUT_TIMEOUT = -1; ///< No key arrived before the timeout
+const int INPUT_EOF = -2;     ///< Input is closed
+
+/**
+ * @brief Switches the terminal to raw mode if stdin is a TTY
+ *
+ * In raw mode keys are delivered one at a time without waiting for
+ * Enter and without echo. The previous terminal settings are restored
+ * by input_shutdown(), at exit, or when the game is interrupted.
+ * When stdin is not a TTY (piped input, scripts) nothing changes and
+ * input stays line-based.
+ *
+ * @return True if raw mode is active
+ */
+bool input_init();
+
+/**
+ * @brief Restores the terminal settings saved by input_init()
+ */
+void input_shutdown();
+
+/**
+ * @brief True if keys are read from a raw-mode terminal
+ */
+bool input_is_raw();
+
+/**
+ * @brief Waits for the next key press
+ *
+ * In raw mode the wait uses poll(), so a caller can pass a timeout and
+ * do other work between calls. Arrow keys are reported as W/A/S/D.
+ * Without a TTY this reads the first character of the next input line
+ * and ignores the timeout, as the game always did.
+ *
+ * @param timeoutMs Milliseconds to wait, or -1 to wait indefinitely
+ * @param coalesceRepeats Collapse a backlog of the same key (auto-repeat
+ *        from a held key) into one press, so holding a key does not
+ *        queue up moves
+ * @return The key, INPUT_TIMEOUT, or INPUT_EOF
+ */
+int input_read_key(int timeoutMs = -1, bool coalesceRepeats = false);
+
+/**
+ * @brief Discards keys typed ahead, e.g. a held movement key before a question
+ */
+void input_flush();
+
+/**
+ * @brief Echoes an accepted key and ends the line (raw mode only)
+ * @param key Key returned by input_read_key()
+ */
+void input_echo_key(int key);
+
+/**
+ * @brief Size of the terminal attached to stdout
+ * @param rows Output number of lines (unchanged if unknown)
+ * @param cols Output number of columns (unchanged if unknown)
+ * @return True if the size is known
+ */
+bool input_terminal_size(int& rows, int& cols);
+
+#endif
@@ -0,0 +1,276 @@
+#include "journal.h"
+#include <cstring>
+#include <cerrno>
+#include <random>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static_assert(sizeof(JournalHeader) == 24, "JournalHeader is part of the journal file layout");
+static_assert(sizeof(JournalTurnRecord) == 40, "JournalTurnRecord is part of the journal file layout");
+static_assert(sizeof(JournalEnemyChange) == 16, "JournalEnemyChange is part of the journal file layout");
+
+// Checkpoints alternate between these, so the previous journal survives until the next save lands
+static const char* const JOURNAL_FILES[2] = {
+    "hku_gpa_escape_save.journal.0",
+    "hku_gpa_escape_save.journal.1"
+};
+
+// Write the whole buffer, continuing after partial writes and signals
+static bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static bool same_sampler(const QsSampler& a, const QsSampler& b) {
+    return a.key == b.key && a.cycle == b.cycle && a.position == b.position && a.size == b.size;
+}
+
+TurnJournal::TurnJournal() : fd(-1), file(0), checkpoint(0), turns(0), bytes(0), player(), gpa(0.0), samplers() {}
+
+TurnJournal::~TurnJournal() {
+    close();
+}
+
+bool TurnJournal::start(uint64_t checkpointId, const Entity& player, double gpa,
+                        const vector<Entity>& enemies, const QsSampler samplers[3], string& error) {
+    // The other file keeps the turns after the previous checkpoint
+    uint64_t previous = fd >= 0 ? checkpoint : 0;
+    int next = fd >= 0 ? 1 - file : 0;
+    close();
+
+    int newFd = open(JOURNAL_FILES[next], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (newFd < 0) {
+        error = string("cannot create ") + JOURNAL_FILES[next] + ": " + strerror(errno);
+        return false;
+    }
+    JournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HKJN", 4);
+    header.version = JOURNAL_VERSION;
+    header.checkpoint = checkpointId;
+    header.previous = previous;
+    if (!write_all(newFd, reinterpret_cast<const char*>(&header), sizeof(header))) {
+        error = string("cannot write ") + JOURNAL_FILES[next] + ": " + strerror(errno);
+        ::close(newFd);
+        return false;
+    }
+
+    fd = newFd;
+    file = next;
+    checkpoint = checkpointId;
+    turns = 0;
+    bytes = sizeof(header);
+    this->player = player;
+    this->gpa = gpa;
+    this->enemies.assign(enemies.begin(), enemies.end());
+    for (int i = 0; i < 3; ++i) {
+        this->samplers[i] = samplers[i];
+    }
+
+    // Room for a turn that changes everything, so append() never allocates
+    record.reserve(sizeof(JournalTurnRecord) + 3 * sizeof(SaveSamplerRecord) +
+                   enemies.size() * sizeof(JournalEnemyChange));
+    return true;
+}
+
+bool TurnJournal::append(const Entity& player, double gpa, const vector<Entity>& enemies, const QsSampler samplers[3]) {
+    if (fd < 0) return false;
+
+    bool samplersChanged = false;
+    for (int i = 0; i < 3; ++i) {
+        if (!same_sampler(samplers[i], this->samplers[i])) samplersChanged = true;
+    }
+    record.resize(sizeof(JournalTurnRecord));
+    if (samplersChanged) {
+        for (int i = 0; i < 3; ++i) {
+            SaveSamplerRecord sampler;
+            memset(&sampler, 0, sizeof(sampler));
+            sampler.key = samplers[i].key;
+            sampler.cycle = samplers[i].cycle;
+            sampler.position = samplers[i].position;
+            sampler.size = samplers[i].size;
+            record.insert(record.end(), reinterpret_cast<const char*>(&sampler),
+                          reinterpret_cast<const char*>(&sampler) + sizeof(sampler));
+            this->samplers[i] = samplers[i];
+        }
+    }
+
+    // The enemy list of a level never changes length; compare what moves
+    uint32_t changes = 0;
+    size_t count = enemies.size() < this->enemies.size() ? enemies.size() : this->enemies.size();
+    for (size_t i = 0; i < count; ++i) {
+        Entity& last = this->enemies[i];
+        const Entity& enemy = enemies[i];
+        if (enemy.x == last.x && enemy.y == last.y && enemy.active == last.active) continue;
+        JournalEnemyChange change;
+        memset(&change, 0, sizeof(change));
+        change.index = (uint32_t)i;
+        change.x = enemy.x;
+        change.y = enemy.y;
+        change.active = enemy.active ? 1 : 0;
+        record.insert(record.end(), reinterpret_cast<const char*>(&change),
+                      reinterpret_cast<const char*>(&change) + sizeof(change));
+        last.x = enemy.x;
+        last.y = enemy.y;
+        last.active = enemy.active;
+        ++changes;
+    }
+
+    if (changes == 0 && !samplersChanged && gpa == this->gpa &&
+        player.x == this->player.x && player.y == this->player.y) {
+        return true;
+    }
+    this->player = player;
+    this->gpa = gpa;
+
+    JournalTurnRecord turn;
+    memset(&turn, 0, sizeof(turn));
+    turn.size = (uint32_t)record.size();
+    turn.turn = ++turns;
+    turn.flags = samplersChanged ? JOURNAL_SAMPLERS : 0;
+    turn.enemyChanges = changes;
+    turn.playerX = player.x;
+    turn.playerY = player.y;
+    turn.gpa = gpa;
+    memcpy(record.data(), &turn, sizeof(turn));
+    turn.crc = save_crc32(record.data() + 2 * sizeof(uint32_t), record.size() - 2 * sizeof(uint32_t));
+    memcpy(record.data() + sizeof(uint32_t), &turn.crc, sizeof(turn.crc));
+
+    // One write per turn: a crash leaves at most this record torn, which replay skips
+    if (!write_all(fd, record.data(), record.size())) {
+        return false;
+    }
+    bytes += record.size();
+    return true;
+}
+
+void TurnJournal::close() {
+    if (fd < 0) return;
+    ::close(fd);
+    fd = -1;
+}
+
+uint64_t new_checkpoint_id() {
+    random_device rd;
+    uint64_t id = 0;
+    while (id == 0) {
+        id = ((uint64_t)rd() << 32) ^ rd();
+    }
+    return id;
+}
+
+// Read one journal file; false if it is missing or not a journal
+static bool read_journal(const char* path, vector<char>& data, JournalHeader& header) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(JournalHeader);
+    if (ok) {
+        data.resize((size_t)st.st_size);
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t got = read(fd, data.data() + done, data.size() - done);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) break;
+            done += (size_t)got;
+        }
+        data.resize(done);
+        ok = done >= sizeof(JournalHeader);
+    }
+    close(fd);
+    if (!ok) return false;
+    memcpy(&header, data.data(), sizeof(header));
+    return memcmp(header.magic, "HKJN", 4) == 0 && header.version == JOURNAL_VERSION;
+}
+
+// Apply the records of one journal in order; complete is set if none was torn or damaged
+static int replay_records(const vector<char>& data, int rows, int cols, Entity& player, double& gpa,
+                          vector<Entity>& enemies, QsSampler samplers[3], bool& complete) {
+    size_t offset = sizeof(JournalHeader);
+    int replayed = 0;
+    while (offset + sizeof(JournalTurnRecord) <= data.size()) {
+        const char* in = data.data() + offset;
+        JournalTurnRecord turn;
+        memcpy(&turn, in, sizeof(turn));
+        size_t expected = sizeof(JournalTurnRecord) + ((turn.flags & JOURNAL_SAMPLERS) ? 3 * sizeof(SaveSamplerRecord) : 0) +
+                          (size_t)turn.enemyChanges * sizeof(JournalEnemyChange);
+        if (turn.size != expected || offset + expected > data.size() ||
+            turn.turn != (uint32_t)replayed + 1 ||
+            save_crc32(in + 2 * sizeof(uint32_t), expected - 2 * sizeof(uint32_t)) != turn.crc) {
+            break;
+        }
+
+        const char* changesIn = in + sizeof(JournalTurnRecord) + ((turn.flags & JOURNAL_SAMPLERS) ? 3 * sizeof(SaveSamplerRecord) : 0);
+        // A record that would put anything off the map is treated as damaged
+        bool fits = turn.playerX >= 0 && turn.playerX < cols && turn.playerY >= 0 && turn.playerY < rows;
+        for (uint32_t i = 0; i < turn.enemyChanges && fits; ++i) {
+            JournalEnemyChange change;
+            memcpy(&change, changesIn + i * sizeof(change), sizeof(change));
+            fits = change.index < enemies.size() &&
+                   change.x >= 0 && change.x < cols && change.y >= 0 && change.y < rows;
+        }
+        if (!fits) break;
+
+        player.x = turn.playerX;
+        player.y = turn.playerY;
+        gpa = turn.gpa;
+        if (turn.flags & JOURNAL_SAMPLERS) {
+            for (int i = 0; i < 3; ++i) {
+                SaveSamplerRecord sampler;
+                memcpy(&sampler, in + sizeof(JournalTurnRecord) + i * sizeof(sampler), sizeof(sampler));
+                samplers[i].key = sampler.key;
+                samplers[i].cycle = sampler.cycle;
+                samplers[i].position = sampler.position;
+                samplers[i].size = sampler.size;
+            }
+        }
+        for (uint32_t i = 0; i < turn.enemyChanges; ++i) {
+            JournalEnemyChange change;
+            memcpy(&change, changesIn + i * sizeof(change), sizeof(change));
+            Entity& enemy = enemies[change.index];
+            enemy.x = change.x;
+            enemy.y = change.y;
+            enemy.active = change.active != 0;
+        }
+        offset += expected;
+        ++replayed;
+    }
+    complete = offset == data.size();
+    return replayed;
+}
+
+int replay_journal(uint64_t checkpointId, int rows, int cols, Entity& player, double& gpa,
+                   vector<Entity>& enemies, QsSampler samplers[3]) {
+    if (checkpointId == 0) return 0;
+
+    vector<char> data[2];
+    JournalHeader headers[2];
+    bool valid[2];
+    for (int i = 0; i < 2; ++i) {
+        valid[i] = read_journal(JOURNAL_FILES[i], data[i], headers[i]);
+    }
+    int first = valid[0] && headers[0].checkpoint == checkpointId ? 0 :
+                (valid[1] && headers[1].checkpoint == checkpointId ? 1 : -1);
+    if (first < 0) return 0;
+
+    bool complete;
+    int replayed = replay_records(data[first], rows, cols, player, gpa, enemies, samplers, complete);
+
+    // A newer checkpoint that never reached the disk continues where this journal ends
+    int second = 1 - first;
+    if (complete && valid[second] && headers[second].previous == checkpointId) {
+        replayed += replay_records(data[second], rows, cols, player, gpa, enemies, samplers, complete);
+    }
+    return replayed;
+}
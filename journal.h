@@ -0,0 +1,159 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "save.h"
+
+using namespace std;
+
+const uint32_t JOURNAL_VERSION = 1;
+
+/// A journal this large asks for a checkpoint even before the autosave interval
+const size_t JOURNAL_CHECKPOINT_BYTES = 256 * 1024;
+
+/**
+ * @brief Start of a journal file
+ */
+struct JournalHeader {
+    char magic[4];          ///< "HKJN"
+    uint32_t version;       ///< JOURNAL_VERSION
+    uint64_t checkpoint;    ///< SaveHeader::journalId of the save these turns follow
+    uint64_t previous;      ///< Checkpoint journaled in the other file before this one (0 = none)
+};
+
+/// JournalTurnRecord::flags: the three samplers follow the fixed part
+const uint32_t JOURNAL_SAMPLERS = 1;
+
+/**
+ * @brief Fixed part of one journaled turn
+ *
+ * Followed by three SaveSamplerRecord if JOURNAL_SAMPLERS is set, then
+ * enemyChanges JournalEnemyChange records. Only what changed since the
+ * previous record is stored; the player position and GPA always are.
+ */
+struct JournalTurnRecord {
+    uint32_t size;          ///< Bytes of the whole record
+    uint32_t crc;           ///< CRC-32 of the record after this field
+    uint32_t turn;          ///< Record number since the checkpoint, from 1
+    uint32_t flags;
+    uint32_t enemyChanges;
+    int32_t playerX;
+    int32_t playerY;
+    uint32_t reserved;
+    double gpa;
+};
+
+/**
+ * @brief New position and state of an enemy that changed during a turn
+ */
+struct JournalEnemyChange {
+    uint32_t index;         ///< Position of the enemy in the save's enemy list
+    int32_t x;
+    int32_t y;
+    uint8_t active;
+    char reserved[3];
+};
+
+/**
+ * @brief Append-only log of turn deltas after the last checkpoint save
+ *
+ * Every save taken while journaling is a checkpoint with a random id
+ * (SaveHeader::journalId). start() opens a journal file for it and
+ * append() adds one record per turn holding only what changed: a single
+ * write() of a few dozen bytes, no sync and no heap allocation. Loading
+ * replays the records after the save's checkpoint, so a crash of the
+ * game loses at most the turn in progress (a power loss can also lose
+ * turns the system had not written back since the checkpoint).
+ *
+ * Checkpoints alternate between two journal files. The journal of the
+ * previous checkpoint stays intact until the next one is written, so
+ * while a checkpoint is still being saved in the background both files
+ * together lead from the save on disk to the latest turn. The caller
+ * must not start a checkpoint before the previous one is on disk.
+ */
+class TurnJournal {
+private:
+    int fd;                  ///< Journal file being appended to, or -1
+    int file;                ///< Which of the two journal files fd is
+    uint64_t checkpoint;     ///< Checkpoint the open journal follows
+    uint32_t turns;          ///< Records appended since the checkpoint
+    size_t bytes;            ///< Size of the open journal file
+
+    // State as of the last record, to find what a turn changed
+    Entity player;
+    double gpa;
+    vector<Entity> enemies;
+    QsSampler samplers[3];
+    vector<char> record;     ///< Record being built (capacity kept)
+
+public:
+    TurnJournal();
+    ~TurnJournal();
+
+    TurnJournal(const TurnJournal&) = delete;
+    TurnJournal& operator=(const TurnJournal&) = delete;
+
+    /**
+     * @brief Starts an empty journal after a checkpoint
+     * @param checkpointId Id stored in the checkpoint save
+     * @param player Player as saved
+     * @param gpa GPA as saved
+     * @param enemies Enemies as saved
+     * @param samplers Question samplers as saved
+     * @param error Output reason when the journal cannot be created
+     * @return False if the journal file could not be written; the journal is then closed
+     */
+    bool start(uint64_t checkpointId, const Entity& player, double gpa,
+               const vector<Entity>& enemies, const QsSampler samplers[3], string& error);
+
+    /**
+     * @brief Appends what changed since the last record, if anything
+     * @return False if the record could not be written
+     */
+    bool append(const Entity& player, double gpa, const vector<Entity>& enemies, const QsSampler samplers[3]);
+
+    /**
+     * @brief Stops journaling; the next start() writes the first journal file
+     */
+    void close();
+
+    /**
+     * @brief True while turns are being journaled
+     */
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Bytes of the open journal file
+     */
+    size_t size() const { return bytes; }
+};
+
+/**
+ * @brief Random non-zero id for a new checkpoint
+ */
+uint64_t new_checkpoint_id();
+
+/**
+ * @brief Replays the journaled turns after a loaded save
+ *
+ * Applies the journal of the given checkpoint and, if it is complete,
+ * the journal of the checkpoint that followed it. Replay stops at the
+ * first record that is truncated, fails its checksum or would put the
+ * player or an enemy off the map.
+ *
+ * @param checkpointId SaveHeader::journalId of the loaded save (0 replays nothing)
+ * @param rows Height of the loaded map
+ * @param cols Width of the loaded map
+ * @param player Player to update
+ * @param gpa GPA to update
+ * @param enemies Enemies to update
+ * @param samplers Question samplers to update
+ * @return Number of turns replayed
+ */
+int replay_journal(uint64_t checkpointId, int rows, int cols, Entity& player, double& gpa,
+                   vector<Entity>& enemies, QsSampler samplers[3]);
+
+#endif
@@ -0,0 +1,396 @@
+// Load generator for the game server: many concurrent sessions from one thread
+#include <iostream>
+#include <vector>
+#include <string>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/**
+ * @brief One simulated player connected to the server
+ */
+struct Player {
+    int fd;
+    string input;              ///< Received bytes not yet handled
+    string output;             ///< Commands not yet sent
+    vector<string> mapRows;    ///< Map of the current level
+    int mapRowsExpected;       ///< Rows still to come after a MAP line
+    deque<char> path;          ///< Planned moves to the exit
+    int row, col;              ///< Position reported by the last STATE
+    int expectRow, expectCol;  ///< Position the planned move should reach
+    int gamesLeft;
+    int movesLeft;             ///< Moves allowed in the current game
+    bool needMap;              ///< Ask for the map before the next move
+    Clock::time_point sentAt;  ///< When the command awaiting its reply was sent
+    bool done;
+};
+
+static void print_usage(const char* program) {
+    cerr << "Usage: " << program << " (--socket PATH | --port N) [options]" << endl;
+    cerr << "  --sessions N     concurrent sessions (default 200)" << endl;
+    cerr << "  --games N        games per session (default 3)" << endl;
+    cerr << "  --difficulty D   1-3 (default 2)" << endl;
+    cerr << "  --max-moves N    give up a game after this many moves (default 2000)" << endl;
+}
+
+static int connect_to(const string& socketPath, int port) {
+    int fd;
+    if (!socketPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((uint16_t)port);
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Shortest path from the player to the exit over the received map; false if there is none
+static bool plan_path(Player& p) {
+    int rows = (int)p.mapRows.size();
+    if (rows == 0) return false;
+    int cols = (int)p.mapRows[0].size();
+    vector<int> from(rows * cols, -1);
+    vector<int> queue;
+    queue.reserve(rows * cols);
+    int start = p.row * cols + p.col;
+    if (p.row < 0 || p.row >= rows || p.col < 0 || p.col >= cols) return false;
+    from[start] = start;
+    queue.push_back(start);
+    static const int dr[4] = {-1, 0, 1, 0};
+    static const int dc[4] = {0, -1, 0, 1};
+    static const char key[4] = {'W', 'A', 'S', 'D'};
+    int goal = -1;
+    for (size_t head = 0; head < queue.size() && goal < 0; ++head) {
+        int cell = queue[head];
+        int r = cell / cols, c = cell % cols;
+        for (int d = 0; d < 4; ++d) {
+            int nr = r + dr[d], nc = c + dc[d];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= (int)p.mapRows[nr].size()) continue;
+            int next = nr * cols + nc;
+            if (from[next] >= 0 || p.mapRows[nr][nc] == '#') continue;
+            from[next] = cell;
+            if (p.mapRows[nr][nc] == 'E') {
+                goal = next;
+                break;
+            }
+            queue.push_back(next);
+        }
+    }
+    if (goal < 0) return false;
+
+    p.path.clear();
+    for (int cell = goal; cell != start; cell = from[cell]) {
+        int prev = from[cell];
+        int d = 0;
+        while (prev / cols + dr[d] != cell / cols || prev % cols + dc[d] != cell % cols) ++d;
+        p.path.push_front(key[d]);
+    }
+    return true;
+}
+
+/**
+ * @brief Drives every session and collects latency and outcome figures
+ */
+class LoadRun {
+public:
+    int epollFd;
+    vector<Player> players;
+    int difficulty;
+    int maxMoves;
+    mt19937 rng;
+
+    vector<double> latencyUs;
+    unsigned long wins, losses, abandoned, errors, commands;
+    int active;
+
+    LoadRun() : epollFd(-1), difficulty(2), maxMoves(2000), rng(12345),
+                wins(0), losses(0), abandoned(0), errors(0), commands(0), active(0) {}
+
+    void send(Player& p, const string& command) {
+        p.output += command;
+        p.output += '\n';
+        p.sentAt = Clock::now();
+        ++commands;
+    }
+
+    void startGame(Player& p) {
+        p.movesLeft = maxMoves;
+        p.path.clear();
+        p.needMap = true;
+        send(p, "NEW " + to_string(difficulty));
+    }
+
+    void nextMove(Player& p) {
+        if (p.movesLeft-- <= 0) {
+            ++abandoned;
+            finishGame(p);
+            return;
+        }
+        if (p.needMap || p.path.empty() || p.row != p.expectRow || p.col != p.expectCol) {
+            p.needMap = false;
+            send(p, "MAP");
+            return;
+        }
+        char move = p.path.front();
+        p.path.pop_front();
+        p.expectRow = p.row + (move == 'S') - (move == 'W');
+        p.expectCol = p.col + (move == 'D') - (move == 'A');
+        send(p, string("MOVE ") + move);
+    }
+
+    void finishGame(Player& p) {
+        if (--p.gamesLeft > 0) {
+            startGame(p);
+        } else {
+            send(p, "QUIT");
+        }
+    }
+
+    // Handle one reply line; a terminal line completes the command's round trip
+    void handleLine(Player& p, const string& line) {
+        if (p.mapRowsExpected > 0) {
+            p.mapRows.push_back(line);
+            --p.mapRowsExpected;
+            return;
+        }
+        const char* text = line.c_str();
+        bool terminal = strncmp(text, "STATE ", 6) == 0 || strncmp(text, "QUESTION ", 9) == 0 ||
+                        strncmp(text, "WIN", 3) == 0 || strncmp(text, "LOSE", 4) == 0 ||
+                        strncmp(text, "ERR", 3) == 0 || strncmp(text, "BYE", 3) == 0;
+        if (terminal && p.sentAt != Clock::time_point()) {
+            latencyUs.push_back(chrono::duration<double, micro>(Clock::now() - p.sentAt).count());
+            p.sentAt = Clock::time_point();
+        }
+
+        if (strncmp(text, "HELLO", 5) == 0) {
+            startGame(p);
+        } else if (strncmp(text, "MAP ", 4) == 0) {
+            int rows = 0, cols = 0;
+            sscanf(text, "MAP %d %d", &rows, &cols);
+            p.mapRows.clear();
+            p.mapRowsExpected = rows;
+        } else if (strncmp(text, "LEVEL ", 6) == 0) {
+            p.needMap = true;
+        } else if (strncmp(text, "STATE ", 6) == 0) {
+            double gpa;
+            int enemies;
+            sscanf(text, "STATE %lf %d %d %d", &gpa, &p.row, &p.col, &enemies);
+            if (p.needMap || p.path.empty() || p.row != p.expectRow || p.col != p.expectCol) {
+                // Off the planned path (or a new map): replan from where the server says we are
+                if (!p.mapRows.empty() && !p.needMap) {
+                    p.expectRow = p.row;
+                    p.expectCol = p.col;
+                    if (!plan_path(p)) {
+                        ++abandoned;
+                        finishGame(p);
+                        return;
+                    }
+                }
+            }
+            nextMove(p);
+        } else if (strncmp(text, "QUESTION ", 9) == 0) {
+            send(p, string("ANSWER ") + (char)('A' + rng() % 4));
+        } else if (strncmp(text, "WIN", 3) == 0) {
+            ++wins;
+            finishGame(p);
+        } else if (strncmp(text, "LOSE", 4) == 0) {
+            ++losses;
+            finishGame(p);
+        } else if (strncmp(text, "ERR", 3) == 0) {
+            ++errors;
+            cerr << "Server error: " << line << endl;
+            finishGame(p);
+        } else if (strncmp(text, "BYE", 3) == 0) {
+            p.done = true;
+        }
+    }
+
+    void flush(Player& p) {
+        while (!p.output.empty()) {
+            ssize_t n = ::send(p.fd, p.output.data(), p.output.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                p.output.erase(0, (size_t)n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            p.done = true;
+            return;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN | (p.output.empty() ? 0u : (uint32_t)EPOLLOUT);
+        ev.data.u32 = (uint32_t)(&p - &players[0]);
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, p.fd, &ev);
+    }
+
+    void readReplies(Player& p) {
+        char buffer[8192];
+        bool closed = false;
+        for (;;) {
+            ssize_t n = read(p.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                p.input.append(buffer, (size_t)n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            closed = true;
+            break;
+        }
+        size_t start = 0;
+        for (;;) {
+            size_t end = p.input.find('\n', start);
+            if (end == string::npos) break;
+            handleLine(p, p.input.substr(start, end - start));
+            start = end + 1;
+        }
+        p.input.erase(0, start);
+        if (closed && !p.done) {
+            ++errors;
+            cerr << "Server closed a session unexpectedly" << endl;
+        }
+        if (closed) p.done = true;
+    }
+
+    void close(Player& p) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, p.fd, nullptr);
+        ::close(p.fd);
+        p.fd = -1;
+        --active;
+    }
+};
+
+static double percentile(vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    string socketPath;
+    int port = 0;
+    int sessions = 200;
+    int games = 3;
+    LoadRun run;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--socket") == 0 && hasValue) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sessions") == 0 && hasValue) {
+            sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--games") == 0 && hasValue) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && hasValue) {
+            run.difficulty = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-moves") == 0 && hasValue) {
+            run.maxMoves = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((socketPath.empty() && port <= 0) || sessions < 1 || games < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    run.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    run.players.resize(sessions);
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < sessions; ++i) {
+        Player& p = run.players[i];
+        p.fd = connect_to(socketPath, port);
+        if (p.fd < 0) {
+            cerr << "Error: Cannot connect session " << i << ": " << strerror(errno) << endl;
+            return 1;
+        }
+        p.mapRowsExpected = 0;
+        p.row = p.col = p.expectRow = p.expectCol = -1;
+        p.gamesLeft = games;
+        p.movesLeft = 0;
+        p.needMap = true;
+        p.done = false;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)i;
+        epoll_ctl(run.epollFd, EPOLL_CTL_ADD, p.fd, &ev);
+        ++run.active;
+    }
+
+    struct epoll_event events[256];
+    while (run.active > 0) {
+        int n = epoll_wait(run.epollFd, events, 256, 10000);
+        if (n == 0) {
+            cerr << "Error: No reply from the server for 10 s" << endl;
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Player& p = run.players[events[i].data.u32];
+            if (p.fd < 0) continue;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                run.readReplies(p);
+            }
+            if (p.done && p.output.empty()) {
+                run.close(p);
+                continue;
+            }
+            run.flush(p);
+            if (p.done) run.close(p);
+        }
+    }
+    double seconds = chrono::duration<double>(Clock::now() - begin).count();
+
+    sort(run.latencyUs.begin(), run.latencyUs.end());
+    printf("%d sessions, %lu games (%lu won, %lu lost, %lu abandoned), %lu errors\n",
+           sessions, run.wins + run.losses + run.abandoned, run.wins, run.losses, run.abandoned, run.errors);
+    printf("%lu commands in %.2f s (%.0f commands/s)\n", run.commands, seconds,
+           seconds > 0 ? run.commands / seconds : 0.0);
+    printf("latency us: p50 %.0f  p90 %.0f  p99 %.0f  max %.0f\n",
+           percentile(run.latencyUs, 0.50), percentile(run.latencyUs, 0.90),
+           percentile(run.latencyUs, 0.99), run.latencyUs.empty() ? 0.0 : run.latencyUs.back());
+    return run.errors > 0 || run.active > 0 ? 1 : 0;
+}
@@ -1,13 +1,241 @@
 #include "game.h"
+#include "input.h"
+#include "server.h"
+#include "spectate.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 using namespace std;
 
-int main() {
+static void print_usage(const char* program) {
+    cerr << "Usage: " << program << " [options]" << endl;
+    cerr << "  --answer-timeout SECONDS  time allowed per question (terminal only)" << endl;
+    cerr << "  --realtime                enemies move on their own clock (terminal only)" << endl;
+    cerr << "  --tick-rate N             enemy moves per second in real-time mode (default 5)" << endl;
+    cerr << "  --fps N                   screen refreshes per second in real-time mode (default 20)" << endl;
+    cerr << "  --map-size ROWSxCOLS      generate every level at this size" << endl;
+    cerr << "  --autosave N              save in the background every N turns" << endl;
+    cerr << "  --players N               co-op: N players (1-9) share the map and move in turn" << endl;
+    cerr << "  --spectate NAME           publish the game to shared memory for ./gpaview NAME" << endl;
+    cerr << "Headless batch mode:" << endl;
+    cerr << "  --headless                play without a terminal and print one result line per game" << endl;
+    cerr << "  --seed N                  seed of the first game (default 1)" << endl;
+    cerr << "  --games N                 number of games, seeds N, N+1, ... (default 1)" << endl;
+    cerr << "  --difficulty 1-3          Easy, Normal or Hard (default 2)" << endl;
+    cerr << "  --script FILE             moves to play (W/A/S/D), one game per run of the script" << endl;
+    cerr << "  --autopilot               walk shortest paths to the exit instead of a script" << endl;
+    cerr << "  --correct-rate P          probability of answering correctly (default 0.75)" << endl;
+    cerr << "  --max-turns N             turn limit per game (default 100000)" << endl;
+    cerr << "  --initial-gpa GPA         starting GPA instead of the difficulty's" << endl;
+    cerr << "  --ta-k K                  TA penalty multiplier instead of the difficulty's" << endl;
+    cerr << "  --prof-k K                Professor penalty multiplier instead of the difficulty's" << endl;
+    cerr << "  --stu-k K                 Student penalty multiplier instead of the difficulty's" << endl;
+    cerr << "  --walls PERCENT           wall chance of a map cell instead of the difficulty's" << endl;
+    cerr << "  --enemies PERCENT         enemy chance of a map cell instead of the difficulty's" << endl;
+    cerr << "Server mode:" << endl;
+    cerr << "  --server PATH             serve games over a Unix domain socket" << endl;
+    cerr << "  --port N                  serve games over TCP on 127.0.0.1 instead" << endl;
+    cerr << "  --workers N               event loop threads (default: cores, at most 4)" << endl;
+}
+
+// Read a whole move script; false if it cannot be opened
+static bool read_script(const char* path, string& script) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        return false;
+    }
+    script.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+// Play the requested headless games back to back, one compact result line each
+static int run_headless(HeadlessOptions options, long games) {
+    // Loading messages go to stderr so stdout carries only results
+    streambuf* screen = cout.rdbuf(cerr.rdbuf());
+    load_All_Qs();
+    cout.rdbuf(screen);
+    
+    long allocTurns = 0;
+    for (long g = 0; g < games; ++g) {
+        Game game;
+        HeadlessResult r = game.runHeadless(options);
+        cout << "seed=" << options.seed << " difficulty=" << options.difficulty
+             << " players=" << options.players << " outcome=" << r.outcome << " level=" << r.level << " turns=" << r.turns
+             << " gpa=" << r.gpa << " questions=" << r.questions << " correct=" << r.correct
+             << " ms=" << r.elapsedMs << '\n';
+        if (r.allocTurns > 0) {
+            cerr << "[alloc] seed " << options.seed << ": " << r.allocTurns << " turn(s) made heap allocations" << endl;
+            allocTurns += r.allocTurns;
+        }
+        ++options.seed;
+    }
+    cout.flush();
+    // Only a build with the allocation counter can fail here ("make check")
+    return allocTurns > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    int answerTimeout = 0;
+    bool realtime = false;
+    int tickRate = 5;
+    int renderRate = 20;
+    int autosaveTurns = 0;
+    bool headless = false;
+    long games = 1;
+    HeadlessOptions options;
+    options.seed = 1;
+    options.difficulty = 2;
+    options.autopilot = false;
+    options.correctRate = 0.75;
+    options.maxTurns = 100000;
+    options.players = 1;
+    options.mapRows = 0;
+    options.mapCols = 0;
+    options.wallPercent = -1;
+    options.enemyPercent = -1;
+    options.initialGPA = 0.0;
+    options.taK = -1.0;
+    options.profK = -1.0;
+    options.stuK = -1.0;
+    const char* scriptPath = nullptr;
+    const char* spectateName = nullptr;
+    bool serve = false;
+    ServerOptions server;
+    server.port = 0;
+    server.workers = 0;
+    server.mapRows = 0;
+    server.mapCols = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--answer-timeout") == 0 && hasValue) {
+            answerTimeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && hasValue) {
+            tickRate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && hasValue) {
+            renderRate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--map-size") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.mapRows, &options.mapCols) != 2 ||
+                options.mapRows < 3 || options.mapCols < 3) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--autosave") == 0 && hasValue) {
+            autosaveTurns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--players") == 0 && hasValue) {
+            options.players = atoi(argv[++i]);
+            if (options.players < 1 || options.players > 9) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--spectate") == 0 && hasValue) {
+            spectateName = argv[++i];
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--games") == 0 && hasValue) {
+            games = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && hasValue) {
+            options.difficulty = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--script") == 0 && hasValue) {
+            scriptPath = argv[++i];
+        } else if (strcmp(argv[i], "--autopilot") == 0) {
+            options.autopilot = true;
+        } else if (strcmp(argv[i], "--correct-rate") == 0 && hasValue) {
+            options.correctRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-turns") == 0 && hasValue) {
+            options.maxTurns = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--initial-gpa") == 0 && hasValue) {
+            options.initialGPA = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ta-k") == 0 && hasValue) {
+            options.taK = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--prof-k") == 0 && hasValue) {
+            options.profK = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--stu-k") == 0 && hasValue) {
+            options.stuK = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--walls") == 0 && hasValue) {
+            options.wallPercent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--enemies") == 0 && hasValue) {
+            options.enemyPercent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--server") == 0 && hasValue) {
+            serve = true;
+            server.socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+            serve = true;
+            server.port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && hasValue) {
+            server.workers = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (headless) {
+        if (scriptPath != nullptr && !read_script(scriptPath, options.script)) {
+            cerr << "Error: Cannot open script file: " << scriptPath << endl;
+            return 1;
+        }
+        if (scriptPath == nullptr && !options.autopilot) {
+            cerr << "Headless mode needs --script FILE or --autopilot" << endl;
+            return 1;
+        }
+        return run_headless(options, games);
+    }
+    
+    if (serve) {
+        if (server.socketPath.empty() && (server.port <= 0 || server.port > 65535)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        server.mapRows = options.mapRows;
+        server.mapCols = options.mapCols;
+        load_All_Qs();
+        start_Qs_watcher();
+        int status = run_server(server);
+        stop_Qs_watcher();
+        return status;
+    }
+    
     cout << "Starting HKU GPA Escape..." << endl;
     
+    // Single-key input when playing in a terminal; line input otherwise
+    input_init();
+    
+    // Reload the question bank in the background when its files change
+    start_Qs_watcher();
+    
+    // Spectators map the feed read-only; it is removed again when the game exits
+    SpectatorFeed feed;
+    if (spectateName != nullptr) {
+        if (feed.open(spectateName)) {
+            cout << "Spectators can watch with: ./gpaview " << spectateName << endl;
+        } else {
+            cout << "Warning: could not create spectator feed " << spectateName << endl;
+        }
+    }
+    
     Game game;
+    game.setAnswerTimeout(answerTimeout);
+    game.setPlayers(options.players);
+    game.setMapSize(options.mapRows, options.mapCols);
+    game.setAutosave(autosaveTurns);
+    if (feed.isOpen()) {
+        game.setSpectator(&feed);
+    }
+    if (realtime) {
+        game.setRealtime(tickRate, renderRate);
+    }
     game.run();
     
+    stop_Qs_watcher();
+    input_shutdown();
+    
     cout << "Thank you for playing HKU GPA Escape!" << endl;
     return 0;
 }
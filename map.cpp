@@ -1,5 +1,6 @@
 #include "map.h"
 #include "entity.h"
+#include "rng.h"
 #include <iostream>
 #include <vector>
 #include <cstdlib>
@@ -14,32 +15,20 @@ using namespace std;
 #define color_wall   "\033[37m"
 #define color_text   "\033[0m"
 
-char** map_data = nullptr;
-int map_rows = 0;
-int map_cols = 0;
-
-int map_player_start_row = 0;
-int map_player_start_col = 0;
-
-//clear_map function frees all dynamic memory used by the map and resets its size.
-//The function has no inputs.
-//Output is that map_data becomes nullptr and map_rows & map_cols are set to 0.
-static void clear_map() {
-    if (map_data != nullptr) {
-        for (int row = 0; row < map_rows; ++row) {
-            delete[] map_data[row];
-        }
-        delete[] map_data;
-        map_data = nullptr;
-    }
-    map_rows = 0;
-    map_cols = 0;
+//clear_map function releases all level memory by resetting the level arena and resets the map size.
+//Input is the world whose level is cleared.
+//Output is that world.map_data becomes nullptr and world.map_rows & world.map_cols are set to 0.
+static void clear_map(World& world) {
+    world.map_arena.reset();
+    world.map_data = nullptr;
+    world.map_rows = 0;
+    world.map_cols = 0;
 }
 
 //get_map_parameters function sets the map size and the percentages of walls and enemies.
-//Inputs are difficulty (1 = easy, 2 = normal, 3 = hard) and level (1–3).
+//Inputs are the world (for its map overrides), difficulty (1 = easy, 2 = normal, 3 = hard) and level (1–3).
 //Outputs are rows, cols, wall_percent, and enemy_percent used to generate the map.
-static void get_map_parameters(int difficulty, int level,
+static void get_map_parameters(const World& world, int difficulty, int level,
                                int& rows, int& cols,
                                int& wall_percent, int& enemy_percent) {
     int base_rows, base_cols;
@@ -74,26 +63,59 @@ static void get_map_parameters(int difficulty, int level,
 
     if (wall_percent > 35)  wall_percent = 35;
     if (enemy_percent > 45) enemy_percent = 45;
+
+    if (world.map_override_rows > 0 && world.map_override_cols > 0) {
+        rows = world.map_override_rows;
+        cols = world.map_override_cols;
+    }
+    if (world.map_override_wall_percent >= 0) {
+        wall_percent = world.map_override_wall_percent;
+    }
+    if (world.map_override_enemy_percent >= 0) {
+        enemy_percent = world.map_override_enemy_percent;
+    }
+}
+
+//set_map_size_override function makes every following load_map on the world generate a map of the given size.
+//Inputs are the world, rows and cols (at least 3 each), or 0 to return to the difficulty's map sizes.
+//Output is the override stored in the world; wall and enemy percentages are set by set_map_density_override.
+void set_map_size_override(World& world, int rows, int cols) {
+    if (rows >= 3 && cols >= 3) {
+        world.map_override_rows = rows;
+        world.map_override_cols = cols;
+    } else {
+        world.map_override_rows = 0;
+        world.map_override_cols = 0;
+    }
+}
+
+//set_map_density_override function makes every following load_map on the world use the given percentages.
+//Inputs are the world, the chance (0-100) that a cell off the safe path becomes a wall, and the chance (0-100)
+//that a remaining cell gets an enemy; -1 (or anything outside 0-100) keeps the difficulty's value.
+//Output is the override stored in the world.
+void set_map_density_override(World& world, int wall_percent, int enemy_percent) {
+    world.map_override_wall_percent = wall_percent >= 0 && wall_percent <= 100 ? wall_percent : -1;
+    world.map_override_enemy_percent = enemy_percent >= 0 && enemy_percent <= 100 ? enemy_percent : -1;
 }
 
 //add_border_walls function sets the outer border cells of the map to walls using "#".
-//The function has no inputs.
-//Output is that the first and last row and column in map_data are all "#"".
-static void add_border_walls() {
-    for (int row = 0; row < map_rows; ++row) {
-        map_data[row][0] = '#';
-        map_data[row][map_cols - 1] = '#';
+//Input is the world whose map gets the border.
+//Output is that the first and last row and column in world.map_data are all "#"".
+static void add_border_walls(World& world) {
+    for (int row = 0; row < world.map_rows; ++row) {
+        world.map_data[row][0] = '#';
+        world.map_data[row][world.map_cols - 1] = '#';
     }
-    for (int col = 0; col < map_cols; ++col) {
-        map_data[0][col] = '#';
-        map_data[map_rows - 1][col] = '#';
+    for (int col = 0; col < world.map_cols; ++col) {
+        world.map_data[0][col] = '#';
+        world.map_data[world.map_rows - 1][col] = '#';
     }
 }
 
 //pick_exit_far_from_player function chooses an exit location on the outer border far from the player.
-//Inputs are start_row, start_col, and difficulty.
+//Inputs are the world, start_row, start_col, and difficulty.
 //Outputs are exit_row and exit_col, which give the exit position on the border.
-static void pick_exit_far_from_player(int start_row, int start_col, int difficulty,
+static void pick_exit_far_from_player(World& world, int start_row, int start_col, int difficulty,
                                       int& exit_row, int& exit_col) {
     struct border_position {
         int row;
@@ -101,15 +123,16 @@ static void pick_exit_far_from_player(int start_row, int start_col, int difficul
         int distance;
     };
 
-    vector<border_position> border_list;
+    ArenaVector<border_position> border_list{ArenaAllocator<border_position>(world.map_arena)};
+    border_list.reserve(2 * (world.map_cols - 2) + 2 * (world.map_rows - 2));
 
-    for (int col = 1; col < map_cols - 1; ++col) {
+    for (int col = 1; col < world.map_cols - 1; ++col) {
         border_list.push_back({0, col, 0});
-        border_list.push_back({map_rows - 1, col, 0});
+        border_list.push_back({world.map_rows - 1, col, 0});
     }
-    for (int row = 1; row < map_rows - 1; ++row) {
+    for (int row = 1; row < world.map_rows - 1; ++row) {
         border_list.push_back({row, 0, 0});
-        border_list.push_back({row, map_cols - 1, 0});
+        border_list.push_back({row, world.map_cols - 1, 0});
     }
 
     if (border_list.empty()) {
@@ -137,7 +160,8 @@ static void pick_exit_far_from_player(int start_row, int start_col, int difficul
     int min_distance = static_cast<int>(max_distance * ratio);
     if (min_distance < 1) min_distance = 1;
 
-    vector<border_position> candidates;
+    ArenaVector<border_position> candidates{ArenaAllocator<border_position>(world.map_arena)};
+    candidates.reserve(border_list.size());
 
     for (const auto& b : border_list) {
         if (b.distance >= min_distance)
@@ -151,56 +175,63 @@ static void pick_exit_far_from_player(int start_row, int start_col, int difficul
         }
     }
 
-    int index = rand() % candidates.size();
+    int index = game_rand(world.rng) % candidates.size();
     exit_row = candidates[index].row;
     exit_col = candidates[index].col;
 }
 
-//create_map_memory function allocates a new 2D array for the map.
-//Inputs are rows and cols specifying the map size.
-//Output is that map_data is allocated as rows × cols and map_rows/map_cols are updated.
-static void create_map_memory(int rows, int cols) {
-    clear_map();
-    map_rows = rows;
-    map_cols = cols;
-
-    map_data = new char*[map_rows];
-    for (int row = 0; row < map_rows; ++row) {
-        map_data[row] = new char[map_cols];
+//allocate_map function resets the level arena and allocates a new 2D array for the map from it.
+//Inputs are the world and rows and cols specifying the map size.
+//Output is that world.map_data is allocated as rows × cols, world.map_rows/world.map_cols are updated and world.map_version is bumped.
+void allocate_map(World& world, int rows, int cols) {
+    clear_map(world);
+    world.map_rows = rows;
+    world.map_cols = cols;
+    ++world.map_version;
+
+    // One contiguous block for all cells; rows point into it
+    world.map_data = world.map_arena.allocate_array<char*>(world.map_rows);
+    char* cells = world.map_arena.allocate_array<char>((size_t)world.map_rows * world.map_cols);
+    for (int row = 0; row < world.map_rows; ++row) {
+        world.map_data[row] = cells + (size_t)row * world.map_cols;
     }
 }
 
 //load_map function generates a map with a random player start, random exit, a safe path, and random obstacles.
-//Inputs are difficulty (1–3) and level (1–3).
-//Outputs are map_data filled with characters, and map_player_start_row/col set.
-void load_map(int difficulty, int level) {
+//Inputs are the world, difficulty (1–3) and level (1–3); random choices come from world.rng.
+//Outputs are world.map_data filled with characters, and world.map_player_start_row/col set.
+void load_map(World& world, int difficulty, int level) {
     int rows, cols;
     int wall_percent, enemy_percent;
-    get_map_parameters(difficulty, level, rows, cols, wall_percent, enemy_percent);
+    get_map_parameters(world, difficulty, level, rows, cols, wall_percent, enemy_percent);
 
-    create_map_memory(rows, cols);
+    allocate_map(world, rows, cols);
     int enemy_count = 0;
 
-    for (int row = 0; row < map_rows; ++row) {
-        for (int col = 0; col < map_cols; ++col) {
-            map_data[row][col] = '.';
+    for (int row = 0; row < world.map_rows; ++row) {
+        for (int col = 0; col < world.map_cols; ++col) {
+            world.map_data[row][col] = '.';
         }
     }
 
-    add_border_walls();
+    add_border_walls(world);
     
-    vector<vector<bool>> safe_route(map_rows, vector<bool>(map_cols, false));
+    ArenaVector<ArenaVector<bool>> safe_route{ArenaAllocator<ArenaVector<bool>>(world.map_arena)};
+    safe_route.reserve(world.map_rows);
+    for (int row = 0; row < world.map_rows; ++row) {
+        safe_route.emplace_back((size_t)world.map_cols, false, ArenaAllocator<bool>(world.map_arena));
+    }
 
-    int start_row = 1 + rand() % (map_rows - 2);
-    int start_col = 1 + rand() % (map_cols - 2);
+    int start_row = 1 + game_rand(world.rng) % (world.map_rows - 2);
+    int start_col = 1 + game_rand(world.rng) % (world.map_cols - 2);
 
-    map_player_start_row = start_row;
-    map_player_start_col = start_col;
+    world.map_player_start_row = start_row;
+    world.map_player_start_col = start_col;
 
     int exit_row, exit_col;
-    pick_exit_far_from_player(start_row, start_col, difficulty, exit_row, exit_col);
+    pick_exit_far_from_player(world, start_row, start_col, difficulty, exit_row, exit_col);
 
-    map_data[exit_row][exit_col] = 'E';
+    world.map_data[exit_row][exit_col] = 'E';
     safe_route[start_row][start_col] = true;
 
     int target_row = exit_row;
@@ -208,12 +239,12 @@ void load_map(int difficulty, int level) {
 
     if (exit_row == 0) {
         target_row = 1;
-    } else if (exit_row == map_rows - 1) {
-        target_row = map_rows - 2;
+    } else if (exit_row == world.map_rows - 1) {
+        target_row = world.map_rows - 2;
     } else if (exit_col == 0) {
         target_col = 1;
-    } else if (exit_col == map_cols - 1) {
-        target_col = map_cols - 2;
+    } else if (exit_col == world.map_cols - 1) {
+        target_col = world.map_cols - 2;
     }
 
     int path_row = start_row;
@@ -221,7 +252,7 @@ void load_map(int difficulty, int level) {
 
     while (path_row != target_row || path_col != target_col) {
         safe_route[path_row][path_col] = true;
-        map_data[path_row][path_col] = '.';
+        world.map_data[path_row][path_col] = '.';
 
         int d_row = target_row - path_row;
         int d_col = target_col - path_col;
@@ -236,25 +267,25 @@ void load_map(int difficulty, int level) {
     }
 
     safe_route[path_row][path_col] = true;
-    map_data[path_row][path_col] = '.';
+    world.map_data[path_row][path_col] = '.';
 
-    for (int row = 1; row < map_rows - 1; ++row) {
-        for (int col = 1; col < map_cols - 1; ++col) {
+    for (int row = 1; row < world.map_rows - 1; ++row) {
+        for (int col = 1; col < world.map_cols - 1; ++col) {
             if (safe_route[row][col]) continue;
             if (row == start_row && col == start_col) continue;
             if (row == exit_row && col == exit_col) continue;
 
-            int r = rand() % 100;
+            int r = game_rand(world.rng) % 100;
 
             if (r < wall_percent) {
-                map_data[row][col] = '#';
+                world.map_data[row][col] = '#';
             } else {
-                int enemy_roll = rand() % 100;
+                int enemy_roll = game_rand(world.rng) % 100;
                 if (enemy_roll < enemy_percent) {
-                    int type = rand() % 3;
-                    if (type == 0)      map_data[row][col] = 'T';
-                    else if (type == 1) map_data[row][col] = 'F';
-                    else                map_data[row][col] = 'S';
+                    int type = game_rand(world.rng) % 3;
+                    if (type == 0)      world.map_data[row][col] = 'T';
+                    else if (type == 1) world.map_data[row][col] = 'F';
+                    else                world.map_data[row][col] = 'S';
 
                     enemy_count++;
                 }
@@ -263,114 +294,201 @@ void load_map(int difficulty, int level) {
     }
 
     if (enemy_count == 0) {
-        vector<pair<int,int>> candidates;
+        ArenaVector<pair<int,int>> candidates{ArenaAllocator<pair<int,int>>(world.map_arena)};
+        candidates.reserve((size_t)(world.map_rows - 2) * (world.map_cols - 2));
 
-        for (int row = 1; row < map_rows - 1; ++row) {
-            for (int col = 1; col < map_cols - 1; ++col) {
+        for (int row = 1; row < world.map_rows - 1; ++row) {
+            for (int col = 1; col < world.map_cols - 1; ++col) {
                 if (row == start_row && col == start_col) continue;
                 if (row == exit_row && col == exit_col) continue;
 
-                if (map_data[row][col] == '.') {
+                if (world.map_data[row][col] == '.') {
                     candidates.push_back({row, col});
                 }
             }
         }
 
         if (!candidates.empty()) {
-            auto chosen = candidates[rand() % candidates.size()];
+            auto chosen = candidates[game_rand(world.rng) % candidates.size()];
             int er = chosen.first;
             int ec = chosen.second;
 
-            int type = rand() % 3;
-            if (type == 0)      map_data[er][ec] = 'T';
-            else if (type == 1) map_data[er][ec] = 'F';
-            else                map_data[er][ec] = 'S';
+            int type = game_rand(world.rng) % 3;
+            if (type == 0)      world.map_data[er][ec] = 'T';
+            else if (type == 1) world.map_data[er][ec] = 'F';
+            else                world.map_data[er][ec] = 'S';
 
             enemy_count = 1;
-            // cout << "[DEBUG] forced spawn one enemy at (" << er << "," << ec << ")\n";
         }
     }
 }
 
 //free_map function frees all memory used by the current map.
-//The function has no inputs.
-//Output is that map_data is cleared and map_rows/map_cols reset.
-void free_map() {
-    clear_map();
+//Input is the world whose map is freed.
+//Output is that world.map_data is cleared and world.map_rows/world.map_cols reset.
+void free_map(World& world) {
+    clear_map(world);
 }
 
 //get_map_char_at function returns the character at a given position on the map.
-//Inputs are row and col.
+//Inputs are the world, row and col.
 //Output is the map character at (row, col), or '#' if out of bounds.
-char get_map_char_at(int row, int col) {
-    if (map_data == nullptr) return '#';
-    if (row < 0 || row >= map_rows || col < 0 || col >= map_cols) return '#';
-    return map_data[row][col];
+char get_map_char_at(const World& world, int row, int col) {
+    if (world.map_data == nullptr) return '#';
+    if (row < 0 || row >= world.map_rows || col < 0 || col >= world.map_cols) return '#';
+    return world.map_data[row][col];
 }
 
 //position_walkable function checks whether a position is not a wall.
-//Inputs are row and col.
+//Inputs are the world, row and col.
 //Output is true if walkable, false otherwise.
-bool position_walkable(int row, int col) {
-    return get_map_char_at(row, col) != '#';
+bool position_walkable(const World& world, int row, int col) {
+    return get_map_char_at(world, row, col) != '#';
 }
 
 //at_exit_position function checks whether a position is an exit tile.
-//Inputs are row and col.
+//Inputs are the world, row and col.
 //Output is true if the tile contains 'E', false otherwise.
-bool at_exit_position(int row, int col) {
-    return get_map_char_at(row, col) == 'E';
+bool at_exit_position(const World& world, int row, int col) {
+    return get_map_char_at(world, row, col) == 'E';
 }
 
-//print_map function prints the map along with the player and enemies displayed on top.
-//Inputs are the player's coordinates and the list of enemies.
-//Output is printed map output to the terminal.
-void print_map(int player_row, int player_col, const vector<Entity>& enemies) {
-    if (map_data == nullptr) {
-        cout << "map not ready" << endl;
-        return;
+// Appends a string literal (escape code) to a frame buffer position
+static char* append_code(char* out, const char* code) {
+    while (*code) *out++ = *code++;
+    return out;
+}
+
+//map_view_origin function finds the top-left map cell of a view centred on the player.
+//Inputs are the world, the player's coordinates and the view size, which is clamped to the map (0 = whole map).
+//Outputs are top and left, plus the clamped view_rows and view_cols.
+void map_view_origin(const World& world, int player_row, int player_col, int& view_rows, int& view_cols, int& top, int& left) {
+    if (view_rows <= 0 || view_rows > world.map_rows) view_rows = world.map_rows;
+    if (view_cols <= 0 || view_cols > world.map_cols) view_cols = world.map_cols;
+
+    // Keep the player centred, clamped to the map edges
+    top = player_row - view_rows / 2;
+    left = player_col - view_cols / 2;
+    if (top > world.map_rows - view_rows) top = world.map_rows - view_rows;
+    if (left > world.map_cols - view_cols) left = world.map_cols - view_cols;
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+}
+
+//map_view_buffer_size function returns how many bytes encode_map_view may write for a view.
+//Inputs are the (clamped) view size.
+//Output is the worst-case size: every cell coloured, plus one newline per row.
+size_t map_view_buffer_size(int view_rows, int view_cols) {
+    const size_t max_cell = sizeof(color_enemy) - 1 + 1 + sizeof(color_reset) - 1;
+    return (size_t)view_rows * view_cols * max_cell + view_rows;
+}
+
+//encode_map_view function writes the coloured rows of a map view, with the player and enemies on top.
+//Inputs are the world, the output buffer (map_view_buffer_size bytes), an overlay scratch buffer (view_rows * view_cols bytes),
+//the player's coordinates, the enemies with their count, the clamped view as given by map_view_origin,
+//and optionally co-op players, drawn as their number (1-9) on top of the enemies.
+//Output is the end of the encoded text; each row ends with a newline.
+char* encode_map_view(const World& world, char* out, char* overlay, int player_row, int player_col,
+                      const Entity* enemies, int enemy_count,
+                      int top, int left, int view_rows, int view_cols,
+                      const Entity* players, int player_count) {
+    // Overlay of enemies inside the view: one pass over the enemies, not one per cell
+    size_t cells = (size_t)view_rows * view_cols;
+    for (size_t i = 0; i < cells; ++i) overlay[i] = 0;
+    for (int i = 0; i < enemy_count; ++i) {
+        const Entity& e = enemies[i];
+        if (!e.active) continue;
+        int r = e.y - top;
+        int c = e.x - left;
+        if (r < 0 || r >= view_rows || c < 0 || c >= view_cols) continue;
+        char& slot = overlay[(size_t)r * view_cols + c];
+        if (slot == 0) slot = e.type; // First enemy in the list wins, as before
+    }
+    for (int i = player_count - 1; i >= 0; --i) {
+        const Entity& p = players[i];
+        int r = p.y - top;
+        int c = p.x - left;
+        if (!p.active || r < 0 || r >= view_rows || c < 0 || c >= view_cols) continue;
+        overlay[(size_t)r * view_cols + c] = (char)('1' + i); // Lowest number wins a shared cell
     }
 
-    for (int row = 0; row < map_rows; ++row) {
-        for (int col = 0; col < map_cols; ++col) {
-            char base_char = map_data[row][col];
-
-            bool player_here = (row == player_row && col == player_col);
-            bool enemy_here = false;
-            char enemy_char = ' ';
-
-            if (!player_here) {
-                for (const auto& e : enemies) {
-                    if (!e.active) continue;
-                    if (e.y == row && e.x == col) {
-                        enemy_here = true;
-                        enemy_char = e.type;
-                        break;
-                    }
-                }
-            }
+    for (int r = 0; r < view_rows; ++r) {
+        int row = top + r;
+        for (int c = 0; c < view_cols; ++c) {
+            int col = left + c;
+            char base_char = world.map_data[row][col];
+            char enemy_char = overlay[(size_t)r * view_cols + c];
 
-            if (player_here) {
-                cout << color_player << 'P' << color_reset;
+            if (row == player_row && col == player_col) {
+                out = append_code(out, color_player);
+                *out++ = 'P';
+            }
+            else if (enemy_char >= '1' && enemy_char <= '9') {
+                out = append_code(out, color_player);
+                *out++ = enemy_char;
             }
-            else if (enemy_here) {
-                cout << color_enemy << enemy_char << color_reset;
+            else if (enemy_char != 0) {
+                out = append_code(out, color_enemy);
+                *out++ = enemy_char;
             }
             else if (base_char == '#') {
-                cout << color_wall << '#' << color_reset;
+                out = append_code(out, color_wall);
+                *out++ = '#';
             }
             else if (base_char == 'E') {
-                cout << color_exit << 'E' << color_reset;
+                out = append_code(out, color_exit);
+                *out++ = 'E';
             }
             else if (base_char == 'T' || base_char == 'F' || base_char == 'S') {
-                cout << color_enemy << base_char << color_reset;
+                out = append_code(out, color_enemy);
+                *out++ = base_char;
             }
             else {
-                cout << color_text << base_char << color_reset;
+                out = append_code(out, color_text);
+                *out++ = base_char;
             }
+            out = append_code(out, color_reset);
         }
-        cout << endl;
+        *out++ = '\n';
     }
+    return out;
+}
+
+//print_map_view function prints part of the map centred on the player, with the player and enemies on top.
+//Inputs are the stream to print to, the world, the player's coordinates, the list of enemies with its length,
+//the view size (0 = whole map) and optionally the co-op players with their count.
+//Output is the frame written to the stream in a single write.
+void print_map_view(ostream& out, World& world, int player_row, int player_col, const Entity* enemies, int enemy_count,
+                    int view_rows, int view_cols, const Entity* players, int player_count) {
+    if (world.map_data == nullptr) {
+        out << "map not ready" << endl;
+        return;
+    }
+
+    int top, left;
+    map_view_origin(world, player_row, player_col, view_rows, view_cols, top, left);
+
+    // Per-frame scratch space comes from the level arena and is released on return
+    ArenaScope scratch(world.map_arena);
+    char* overlay = world.map_arena.allocate_array<char>((size_t)view_rows * view_cols);
+    char* frame = world.map_arena.allocate_array<char>(map_view_buffer_size(view_rows, view_cols));
+    char* end = encode_map_view(world, frame, overlay, player_row, player_col, enemies, enemy_count,
+                                top, left, view_rows, view_cols, players, player_count);
+
+    out.write(frame, end - frame);
+    out << "map size: " << world.map_rows << " x " << world.map_cols << endl;
+}
+
+//print_map function prints the whole map along with the player and enemies displayed on top.
+//Inputs are the stream to print to, the world, the player's coordinates and the list of enemies with its length.
+//Output is printed map output to the stream.
+void print_map(ostream& out, World& world, int player_row, int player_col, const Entity* enemies, int enemy_count) {
+    print_map_view(out, world, player_row, player_col, enemies, enemy_count, 0, 0);
+}
 
-    cout << "map size: " << map_rows << " x " << map_cols << endl;
+//print_map function for co-op games prints the whole map with every player shown as its number.
+//Inputs are the stream to print to, the world, the players with their count and the list of enemies with its length.
+//Output is printed map output to the stream.
+void print_map(ostream& out, World& world, const Entity* players, int player_count, const Entity* enemies, int enemy_count) {
+    print_map_view(out, world, -1, -1, enemies, enemy_count, 0, 0, players, player_count);
 }
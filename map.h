@@ -2,25 +2,42 @@
 #define MAP_H
 
 #include <vector>
+#include <ostream>
+#include "world.h"
 
 struct Entity;
 
-extern char** map_data;
-extern int map_rows;
-extern int map_cols;
-extern int map_player_start_row;
-extern int map_player_start_col;
+void allocate_map(World& world, int rows, int cols);
 
-void load_map(int difficulty, int level);
+void load_map(World& world, int difficulty, int level);
 
-void free_map();
+void set_map_size_override(World& world, int rows, int cols);
 
-char get_map_char_at(int row, int col);
+void set_map_density_override(World& world, int wall_percent, int enemy_percent);
 
-bool position_walkable(int row, int col);
+void free_map(World& world);
 
-bool at_exit_position(int row, int col);
+char get_map_char_at(const World& world, int row, int col);
 
-void print_map(int player_row, int player_col, const std::vector<Entity>& enemies);
+bool position_walkable(const World& world, int row, int col);
+
+bool at_exit_position(const World& world, int row, int col);
+
+void print_map(ostream& out, World& world, int player_row, int player_col, const Entity* enemies, int enemy_count);
+
+void print_map(ostream& out, World& world, const Entity* players, int player_count, const Entity* enemies, int enemy_count);
+
+void print_map_view(ostream& out, World& world, int player_row, int player_col, const Entity* enemies, int enemy_count,
+                    int view_rows, int view_cols, const Entity* players = nullptr, int player_count = 0);
+
+void map_view_origin(const World& world, int player_row, int player_col,
+                     int& view_rows, int& view_cols, int& top, int& left);
+
+size_t map_view_buffer_size(int view_rows, int view_cols);
+
+char* encode_map_view(const World& world, char* out, char* overlay, int player_row, int player_col,
+                      const Entity* enemies, int enemy_count,
+                      int top, int left, int view_rows, int view_cols,
+                      const Entity* players = nullptr, int player_count = 0);
 
 #endif
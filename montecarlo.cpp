@@ -0,0 +1,212 @@
+#include "montecarlo.h"
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+// Games a worker takes from its own share at a time
+static const unsigned long BATCH_GAMES = 16;
+
+BalanceStats::BalanceStats()
+    : games(0), wins(0), losses(0), turnLimits(0),
+      turnSum(0.0), gpaLossSum(0.0), gameMs(0.0) {}
+
+void BalanceStats::add(const HeadlessResult& result, double initialGPA) {
+    ++games;
+    if (strcmp(result.outcome, "win") == 0) {
+        ++wins;
+        if ((size_t)result.turns >= winTurns.size()) {
+            winTurns.resize((size_t)result.turns + 1, 0);
+        }
+        ++winTurns[(size_t)result.turns];
+        turnSum += result.turns;
+    } else if (strcmp(result.outcome, "lose") == 0) {
+        ++losses;
+    } else {
+        ++turnLimits;
+    }
+
+    double lost = initialGPA - result.gpa;
+    if (lost < 0) lost = 0;
+    size_t bucket = (size_t)lround(lost * 100.0);
+    if (bucket >= gpaLoss.size()) {
+        gpaLoss.resize(bucket + 1, 0);
+    }
+    ++gpaLoss[bucket];
+    gpaLossSum += lost;
+    gameMs += result.elapsedMs;
+}
+
+void BalanceStats::merge(const BalanceStats& other) {
+    games += other.games;
+    wins += other.wins;
+    losses += other.losses;
+    turnLimits += other.turnLimits;
+    if (other.winTurns.size() > winTurns.size()) winTurns.resize(other.winTurns.size(), 0);
+    for (size_t i = 0; i < other.winTurns.size(); ++i) winTurns[i] += other.winTurns[i];
+    if (other.gpaLoss.size() > gpaLoss.size()) gpaLoss.resize(other.gpaLoss.size(), 0);
+    for (size_t i = 0; i < other.gpaLoss.size(); ++i) gpaLoss[i] += other.gpaLoss[i];
+    turnSum += other.turnSum;
+    gpaLossSum += other.gpaLossSum;
+    gameMs += other.gameMs;
+}
+
+// Index of the first histogram bucket reaching fraction p of the total; -1 if empty
+static long histogram_percentile(const vector<unsigned long>& histogram, unsigned long total, double p) {
+    if (total == 0) return -1;
+    double target = p * total;
+    unsigned long seen = 0;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        seen += histogram[i];
+        if (seen > 0 && seen >= target) return (long)i;
+    }
+    return (long)histogram.size() - 1;
+}
+
+long BalanceStats::turnsPercentile(double p) const {
+    return histogram_percentile(winTurns, wins, p);
+}
+
+double BalanceStats::gpaLossPercentile(double p) const {
+    long bucket = histogram_percentile(gpaLoss, games, p);
+    return bucket < 0 ? 0.0 : bucket / 100.0;
+}
+
+/**
+ * @brief A worker's remaining share of game numbers, [next, end)
+ *
+ * The owner takes batches from the front; thieves cut off the back half.
+ * Each share sits in its own allocation so workers' locks do not share
+ * a cache line.
+ */
+struct GameShare {
+    mutex lock;
+    unsigned long next;
+    unsigned long end;
+};
+
+// Take the next batch from a worker's own share
+static bool take_batch(GameShare& share, unsigned long& begin, unsigned long& end) {
+    lock_guard<mutex> guard(share.lock);
+    if (share.next >= share.end) return false;
+    begin = share.next;
+    end = share.end - share.next > BATCH_GAMES ? share.next + BATCH_GAMES : share.end;
+    share.next = end;
+    return true;
+}
+
+// Move the upper half of the largest other share into this worker's (empty) share
+static bool steal_batch(vector<unique_ptr<GameShare>>& shares, size_t self) {
+    for (;;) {
+        size_t victim = self;
+        unsigned long most = 0;
+        for (size_t i = 1; i < shares.size(); ++i) {
+            size_t v = (self + i) % shares.size();
+            lock_guard<mutex> guard(shares[v]->lock);
+            unsigned long left = shares[v]->end - shares[v]->next;
+            if (left > most) {
+                most = left;
+                victim = v;
+            }
+        }
+        if (victim == self) return false; // Every share is empty: the run is done
+
+        unsigned long begin, end;
+        {
+            lock_guard<mutex> guard(shares[victim]->lock);
+            unsigned long left = shares[victim]->end - shares[victim]->next;
+            if (left == 0) continue; // Emptied meanwhile; look again
+            unsigned long half = (left + 1) / 2;
+            end = shares[victim]->end;
+            begin = end - half;
+            shares[victim]->end = begin;
+        }
+        lock_guard<mutex> guard(shares[self]->lock);
+        shares[self]->next = begin;
+        shares[self]->end = end;
+        return true;
+    }
+}
+
+// Initial GPA of a configuration, to turn final GPAs into GPA loss
+static double initial_gpa(const BalanceConfig& config) {
+    if (config.initialGPA > 0) return config.initialGPA;
+    switch (config.difficulty) {
+        case 1: return easy().initialGPA;
+        case 3: return hard().initialGPA;
+        default: return normal().initialGPA;
+    }
+}
+
+vector<BalanceStats> run_balance(const BalanceRun& run, double& elapsedMs, unsigned& threadsUsed) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t configCount = run.configs.size();
+    unsigned long total = run.gamesPerConfig * configCount;
+
+    unsigned threads = run.threads;
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (total < threads) threads = total > 0 ? (unsigned)total : 1;
+    threadsUsed = threads;
+
+    vector<double> initialGPA(configCount);
+    for (size_t c = 0; c < configCount; ++c) {
+        initialGPA[c] = initial_gpa(run.configs[c]);
+    }
+
+    // Equal contiguous shares to start with
+    vector<unique_ptr<GameShare>> shares;
+    for (unsigned t = 0; t < threads; ++t) {
+        shares.push_back(unique_ptr<GameShare>(new GameShare()));
+        shares[t]->next = total * t / threads;
+        shares[t]->end = total * (t + 1) / threads;
+    }
+
+    // Each worker counts into its own stats and they are merged at the end
+    vector<vector<BalanceStats>> partial(threads, vector<BalanceStats>(configCount));
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.push_back(thread([&, t] {
+            Game game;
+            HeadlessOptions options;
+            options.autopilot = true;
+            options.maxTurns = run.maxTurns;
+            options.players = 1;
+            unsigned long begin, end;
+            while (take_batch(*shares[t], begin, end) || (steal_batch(shares, t) && take_batch(*shares[t], begin, end))) {
+                for (unsigned long g = begin; g < end; ++g) {
+                    size_t c = g / run.gamesPerConfig;
+                    const BalanceConfig& config = run.configs[c];
+                    options.seed = run.seed + g % run.gamesPerConfig;
+                    options.difficulty = config.difficulty;
+                    options.correctRate = config.correctRate;
+                    options.initialGPA = config.initialGPA;
+                    options.taK = config.taK;
+                    options.profK = config.profK;
+                    options.stuK = config.stuK;
+                    options.mapRows = config.mapRows;
+                    options.mapCols = config.mapCols;
+                    options.wallPercent = config.wallPercent;
+                    options.enemyPercent = config.enemyPercent;
+                    partial[t][c].add(game.runHeadless(options), initialGPA[c]);
+                }
+            }
+        }));
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    vector<BalanceStats> results(configCount);
+    for (unsigned t = 0; t < threads; ++t) {
+        for (size_t c = 0; c < configCount; ++c) {
+            results[c].merge(partial[t][c]);
+        }
+    }
+    elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return results;
+}
@@ -0,0 +1,104 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <vector>
+#include <string>
+#include "game.h"
+
+using namespace std;
+
+/**
+ * @brief One game setup whose balance is measured
+ *
+ * Every rule left at its "difficulty's" value follows the difficulty.
+ */
+struct BalanceConfig {
+    int difficulty;      ///< 1 = Easy, 2 = Normal, 3 = Hard
+    double correctRate;  ///< Probability the simulated player answers correctly
+    double initialGPA;   ///< GPA games start with (0 = the difficulty's)
+    double taK;          ///< Penalty multiplier of TA questions (negative = the difficulty's)
+    double profK;        ///< Penalty multiplier of Professor questions (negative = the difficulty's)
+    double stuK;         ///< Penalty multiplier of Student questions (negative = the difficulty's)
+    int mapRows;         ///< Size of every level (0 = the difficulty's size)
+    int mapCols;
+    int wallPercent;     ///< Wall chance of a map cell (-1 = the difficulty's)
+    int enemyPercent;    ///< Enemy chance of a map cell (-1 = the difficulty's)
+};
+
+/**
+ * @brief Outcome distributions of many games of one configuration
+ *
+ * Turns and GPA loss are kept as histograms (one bucket per turn, one
+ * per 0.01 GPA) so results from different threads merge exactly and
+ * percentiles need no sorting of per-game samples.
+ */
+struct BalanceStats {
+    unsigned long games;
+    unsigned long wins;
+    unsigned long losses;
+    unsigned long turnLimits;
+    vector<unsigned long> winTurns;   ///< Games won in exactly i turns
+    vector<unsigned long> gpaLoss;    ///< Games ending with i hundredths of GPA lost
+    double turnSum;                   ///< Sum of turns over won games
+    double gpaLossSum;                ///< Sum of GPA lost over all games
+    double gameMs;                    ///< Sum of per-game wall-clock time
+
+    BalanceStats();
+
+    /**
+     * @brief Records one finished game
+     * @param result Outcome of the game
+     * @param initialGPA GPA the game started with
+     */
+    void add(const HeadlessResult& result, double initialGPA);
+
+    /**
+     * @brief Adds another thread's counts to these
+     */
+    void merge(const BalanceStats& other);
+
+    /**
+     * @brief Smallest turn count with at least fraction p of won games at or below it
+     */
+    long turnsPercentile(double p) const;
+
+    /**
+     * @brief Smallest GPA loss with at least fraction p of games at or below it
+     */
+    double gpaLossPercentile(double p) const;
+};
+
+/**
+ * @brief Settings of a whole balancing run
+ */
+struct BalanceRun {
+    vector<BalanceConfig> configs;  ///< Setups to measure
+    unsigned long gamesPerConfig;   ///< Games played for each setup
+    unsigned long seed;             ///< Game i of every setup uses seed + i
+    long maxTurns;                  ///< Turn limit per game
+    unsigned threads;               ///< Worker threads (0 = one per core)
+};
+
+/**
+ * @brief Plays every game of a run in parallel and aggregates the results
+ *
+ * Games are numbered config by config. Each worker starts with an equal
+ * contiguous share of the numbers and takes small batches from its own
+ * share; a worker that runs out steals the upper half of the largest
+ * remaining share it finds. Games vary a lot in length (a lost game can
+ * end in a few turns, a won one walks three levels), so stealing keeps
+ * every core busy until the end instead of waiting for the slowest share.
+ *
+ * Each worker plays on its own Game, whose World holds the map and the
+ * random stream, and every game replays from its own seed, so the totals
+ * do not depend on the number of threads or on which worker played
+ * which game.
+ *
+ * @param run Configurations, game count, seed, turn limit and threads
+ * @param elapsedMs Output wall-clock time of the whole run
+ * @param threadsUsed Output number of worker threads started
+ * @return One BalanceStats per configuration, in the same order
+ */
+vector<BalanceStats> run_balance(const BalanceRun& run, double& elapsedMs, unsigned& threadsUsed);
+
+#endif
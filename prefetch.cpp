@@ -0,0 +1,111 @@
+#include "prefetch.h"
+
+using namespace std;
+
+QuestionPrefetcher::QuestionPrefetcher() : stopping(false) {
+    for (int i = 0; i < 3; ++i) {
+        slots[i].state = SLOT_EMPTY;
+        slots[i].prepared.text.reserve(1024);
+    }
+}
+
+QuestionPrefetcher::~QuestionPrefetcher() {
+    {
+        lock_guard<mutex> lock(slotMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void QuestionPrefetcher::start() {
+    if (!worker.joinable()) {
+        worker = thread(&QuestionPrefetcher::run, this);
+    }
+}
+
+bool QuestionPrefetcher::isEmpty(int bankIndex) {
+    lock_guard<mutex> lock(slotMutex);
+    return slots[bankIndex].state == SLOT_EMPTY;
+}
+
+void QuestionPrefetcher::request(int bankIndex, char enemyType, const shared_ptr<const QuestionSet>& questions,
+                                 uint32_t index, bool weighted) {
+    {
+        lock_guard<mutex> lock(slotMutex);
+        Slot& slot = slots[bankIndex];
+        if (slot.state != SLOT_EMPTY) return;
+        slot.questions = questions;
+        slot.prepared.enemyType = enemyType;
+        slot.prepared.index = index;
+        slot.prepared.weighted = weighted;
+        slot.prepared.questions = questions.get();
+        slot.state = SLOT_PENDING;
+    }
+    wake.notify_one();
+}
+
+const PreparedQuestion* QuestionPrefetcher::acquire(int bankIndex) {
+    lock_guard<mutex> lock(slotMutex);
+    Slot& slot = slots[bankIndex];
+    if (slot.state != SLOT_READY) return nullptr;
+    slot.state = SLOT_IN_USE;
+    return &slot.prepared;
+}
+
+void QuestionPrefetcher::release(int bankIndex) {
+    lock_guard<mutex> lock(slotMutex);
+    slots[bankIndex].state = SLOT_EMPTY;
+}
+
+void QuestionPrefetcher::clear() {
+    unique_lock<mutex> lock(slotMutex);
+    for (int i = 0; i < 3; ++i) {
+        // A pending slot may be mid-format on the worker; it is dropped when done
+        if (slots[i].state == SLOT_READY) {
+            slots[i].state = SLOT_EMPTY;
+            slots[i].questions.reset();
+        } else if (slots[i].state == SLOT_PENDING) {
+            slots[i].prepared.questions = nullptr;
+        }
+    }
+}
+
+// Format pending slots outside the lock; only this thread writes a pending slot's text
+void QuestionPrefetcher::run() {
+    unique_lock<mutex> lock(slotMutex);
+    while (!stopping) {
+        int pending = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (slots[i].state == SLOT_PENDING) {
+                pending = i;
+                break;
+            }
+        }
+        if (pending < 0) {
+            wake.wait(lock);
+            continue;
+        }
+
+        Slot& slot = slots[pending];
+        shared_ptr<const QuestionSet> questions = slot.questions;
+        char enemyType = slot.prepared.enemyType;
+        uint32_t index = slot.prepared.index;
+        lock.unlock();
+
+        const QsBank* bank = questions->bank(enemyType);
+        QsView view = questions->view((*bank)[index]);
+        format_question(enemyType, view, slot.prepared.text);
+
+        lock.lock();
+        if (slot.prepared.questions == nullptr) {
+            // Cleared while formatting
+            slot.state = SLOT_EMPTY;
+            slot.questions.reset();
+        } else {
+            slot.state = SLOT_READY;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "question.h"
+
+using namespace std;
+
+/**
+ * @brief Prepares questions for likely encounters on a background thread
+ *
+ * The game peeks at the next question for an enemy type as soon as such
+ * an enemy comes within reach of the player, and hands it to the worker. The
+ * worker reads the question text (paging it in from a mapped pack if
+ * needed) and formats the encounter banner into the type's ready slot.
+ * When the encounter happens the game prints the slot instead of
+ * touching the bank.
+ *
+ * There is one slot per enemy type (TA, Professor, Student). Slot
+ * buffers keep their capacity and the worker is started with the first
+ * level, so steady-state prefetching does not allocate.
+ */
+class QuestionPrefetcher {
+private:
+    enum SlotState {
+        SLOT_EMPTY,    ///< Nothing requested
+        SLOT_PENDING,  ///< Waiting for the worker
+        SLOT_READY,    ///< Formatted and ready to print
+        SLOT_IN_USE    ///< Being printed by an encounter
+    };
+
+    struct Slot {
+        SlotState state;
+        shared_ptr<const QuestionSet> questions; ///< Keeps the drawn-from set alive
+        PreparedQuestion prepared;
+    };
+
+    Slot slots[3];
+    thread worker;
+    mutex slotMutex;
+    condition_variable wake;
+    bool stopping;
+
+    void run();
+
+public:
+    QuestionPrefetcher();
+    ~QuestionPrefetcher();
+
+    QuestionPrefetcher(const QuestionPrefetcher&) = delete;
+    QuestionPrefetcher& operator=(const QuestionPrefetcher&) = delete;
+
+    /**
+     * @brief Starts the worker thread if it is not running yet
+     *
+     * Called when a level loads, so no turn pays for creating the thread.
+     */
+    void start();
+
+    /**
+     * @brief True if the slot has nothing requested, so a new draw is useful
+     * @param bankIndex 0 = TA, 1 = Professor, 2 = Student
+     */
+    bool isEmpty(int bankIndex);
+
+    /**
+     * @brief Queues a peeked question for formatting (start() must have been called)
+     * @param bankIndex 0 = TA, 1 = Professor, 2 = Student
+     * @param enemyType Enemy type the question was drawn for
+     * @param questions Set the index refers to
+     * @param index Index in that type's bank
+     * @param weighted True if peeked from the mastery weights
+     */
+    void request(int bankIndex, char enemyType, const shared_ptr<const QuestionSet>& questions,
+                 uint32_t index, bool weighted);
+
+    /**
+     * @brief Takes the ready question of a slot for an encounter
+     * @param bankIndex 0 = TA, 1 = Professor, 2 = Student
+     * @return The prepared question, or nullptr if it is not ready yet
+     *         (call release() when done with a non-null result)
+     */
+    const PreparedQuestion* acquire(int bankIndex);
+
+    /**
+     * @brief Returns a slot taken with acquire() to the empty state
+     * @param bankIndex 0 = TA, 1 = Professor, 2 = Student
+     */
+    void release(int bankIndex);
+
+    /**
+     * @brief Drops every prepared or pending question (e.g. on level change)
+     */
+    void clear();
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "question_pack.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+
+using namespace std;
+
+/**
+ * @brief Question pack converter
+ *
+ * Parses questions_ta.txt, questions_prof.txt and questions_student.txt
+ * from the current directory and writes them either as a compiled pack
+ * that the game maps at startup, or as a C++ source file that links the
+ * bank into the game binary.
+ *
+ * Usage: qpack [output]              (default output: questions.pack)
+ *        qpack --emit-cpp <output>   (generated source, e.g. questions_builtin.cpp)
+ */
+int main(int argc, char* argv[]) {
+    bool emitSource = argc > 1 && strcmp(argv[1], "--emit-cpp") == 0;
+    int outputArg = emitSource ? 2 : 1;
+    if (emitSource && argc < 3) {
+        cerr << "Usage: qpack --emit-cpp <output>" << endl;
+        return 1;
+    }
+    string output = argc > outputArg ? argv[outputArg] : "questions.pack";
+
+    QsFileResult results[3];
+    read_Qs_files(results);
+
+    bool anyOpened = false;
+    for (int i = 0; i < 3; ++i) {
+        report_Qs_file(QS_FILES[i], QS_LABELS[i], results[i]);
+        anyOpened = anyOpened || results[i].opened;
+    }
+    if (!anyOpened) {
+        cerr << "qpack: no question files could be read" << endl;
+        return 1;
+    }
+
+    vector<QsRecord> records;
+    string text;
+    uint32_t counts[3];
+    merge_Qs_files(results, records, text, counts);
+
+    bool written = emitSource
+        ? write_Qs_source(output, records.data(), counts, text.data(), text.size())
+        : write_Qs_pack(output, records.data(), counts, text.data(), text.size());
+    if (!written) {
+        return 1;
+    }
+
+    cout << "Wrote " << records.size() << " questions (" << text.size() << " bytes of text) to "
+         << output << endl;
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "question_index.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+// Print one question as "[Bank #n] text"
+static void print_question(const QuestionIndex& index, const QsRef& ref) {
+    size_t len;
+    const char* text = index.text(ref, len);
+    cout << "  [" << QS_LABELS[ref.file] << " #" << ref.index + 1 << "] ";
+    cout.write(text, len);
+    cout << '\n';
+}
+
+static double elapsed_ms(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static void run_search(const QuestionIndex& index, const string& query) {
+    auto start = chrono::steady_clock::now();
+    vector<QsRef> matches = index.search(query);
+    double ms = elapsed_ms(start);
+
+    for (const QsRef& ref : matches) {
+        print_question(index, ref);
+    }
+    cout << matches.size() << " match(es) in " << ms << " ms" << endl;
+}
+
+static void run_duplicates(const QuestionIndex& index, double threshold) {
+    auto start = chrono::steady_clock::now();
+    vector<QsDuplicate> pairs = index.duplicates(threshold);
+    double ms = elapsed_ms(start);
+
+    size_t exact = 0;
+    for (const QsDuplicate& d : pairs) {
+        if (d.exact) {
+            ++exact;
+            cout << "Exact duplicate:" << '\n';
+        } else {
+            cout << "Near duplicate (" << (int)(d.similarity * 100 + 0.5) << "% similar):" << '\n';
+        }
+        print_question(index, d.a);
+        print_question(index, d.b);
+    }
+    cout << exact << " exact and " << pairs.size() - exact << " near-duplicate pair(s) in "
+         << ms << " ms" << endl;
+}
+
+// Index (or re-index) changed files and say which ones were rebuilt
+static void refresh_index(QuestionIndex& index) {
+    auto start = chrono::steady_clock::now();
+    bool changed[3];
+    if (index.refresh(changed) == 0) return;
+    double ms = elapsed_ms(start);
+
+    for (int i = 0; i < 3; ++i) {
+        if (!changed[i]) continue;
+        const QsFileResult& result = index.fileResult(i);
+        if (!result.opened) {
+            cout << "Indexed " << QS_FILES[i] << ": file not found" << '\n';
+            continue;
+        }
+        cout << "Indexed " << QS_FILES[i] << ": " << index.count(i) << " questions, "
+             << index.vocabulary(i) << " distinct words";
+        if (result.malformed > 0) {
+            cout << ", " << result.malformed << " malformed line(s) skipped";
+        }
+        cout << '\n';
+    }
+    cout << "(" << ms << " ms)" << endl;
+}
+
+/**
+ * @brief Question bank search and duplicate finder
+ *
+ * Indexes questions_ta.txt, questions_prof.txt and questions_student.txt
+ * from the current directory.
+ *
+ * Usage: qsearch <word>...            (questions containing every word)
+ *        qsearch --dups [threshold]   (exact and near duplicates, default 0.6)
+ *        qsearch                      (interactive; files are re-indexed
+ *                                      when they change between queries)
+ *
+ * In interactive mode a line of words searches, and ":dups [threshold]"
+ * lists duplicates.
+ */
+int main(int argc, char* argv[]) {
+    QuestionIndex index;
+    refresh_index(index);
+
+    if (argc > 1 && strcmp(argv[1], "--dups") == 0) {
+        double threshold = argc > 2 ? atof(argv[2]) : 0.6;
+        run_duplicates(index, threshold);
+        return 0;
+    }
+
+    if (argc > 1) {
+        string query;
+        for (int i = 1; i < argc; ++i) {
+            if (i > 1) query += ' ';
+            query += argv[i];
+        }
+        run_search(index, query);
+        return 0;
+    }
+
+    string line;
+    cout << "search> " << flush;
+    while (getline(cin, line)) {
+        refresh_index(index);
+        if (line.compare(0, 5, ":dups") == 0) {
+            double threshold = line.size() > 5 ? atof(line.c_str() + 5) : 0.6;
+            run_duplicates(index, threshold);
+        } else if (line == ":quit") {
+            break;
+        } else if (!line.empty()) {
+            run_search(index, line);
+        }
+        cout << "search> " << flush;
+    }
+    return 0;
+}
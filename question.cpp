@@ -1,255 +1,485 @@
 #include "question.h"
-#include <fstream>
+#include "input.h"
 #include <iostream>
-#include <sstream>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include <ctime>
 #include <cctype>
 #include <algorithm>
-#include <limits>
-#include <random>  // Added for std::shuffle
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using namespace std;
 
-// Global vectors storing questions for different enemy types
-vector<Qs> taQs;      ///< Questions asked by TAs
-vector<Qs> profQs;    ///< Questions asked by Professors 
-vector<Qs> stuQs;     ///< Questions asked by Students
+static const char* const QS_PACK_FILE = "questions.pack";
+
+// Process-wide question bank; read and replaced only with atomic_load/atomic_store
+static shared_ptr<const QuestionSet> sharedQs;
+static mutex sharedQsLoadMutex;
 
-string trim(const string& str) {
-    if (str.empty()) return "";
-    int start = 0;
-    int end = str.length() - 1;
+// Background watcher state
+static thread watcherThread;
+static mutex watcherMutex;
+static condition_variable watcherWake;
+static bool watcherStop = false;
 
-    // Find first non-whitespace character from the start
-    while (start <= end && (str[start] == ' ' || str[start] == '\t' || str[start] == '\n' || str[start] == '\r')) {
-        start++;
+// What reloads reported, until a game prints it between turns
+static mutex reloadNoticeMutex;
+static string reloadNotice;
+static atomic<bool> reloadNoticePending(false);
+
+QuestionSet::QuestionSet()
+    : mapping(nullptr), mappingSize(0), text(nullptr), textSize(0) {
+    ta.records = prof.records = stu.records = nullptr;
+    ta.count = prof.count = stu.count = 0;
+}
+
+QuestionSet::~QuestionSet() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
     }
+}
+
+// Point the three banks at consecutive slices of one record array
+void QuestionSet::setBanks(const QsRecord* records, const uint32_t counts[3]) {
+    ta.records = records;
+    ta.count = counts[0];
+    prof.records = records + counts[0];
+    prof.count = counts[1];
+    stu.records = records + counts[0] + counts[1];
+    stu.count = counts[2];
+}
 
-    // Find first non-whitespace character from the end
-    while (end >= start && (str[end] == ' ' || str[end] == '\t' || str[end] == '\n' || str[end] == '\r')) {
-        end--;
+const QsBank* QuestionSet::bank(char enemyType) const {
+    switch (enemyType) {
+        case 'T': return &ta;
+        case 'F': return &prof;
+        case 'S': return &stu;
+        default: return nullptr;
     }
+}
 
-    // If string is all whitespace, return empty string
-    if (start > end) return "";
-    return str.substr(start, end - start + 1);
+QsView QuestionSet::view(const QsRecord& record) const {
+    QsView view;
+    // Records of a mapped pack are not validated at load time, so clamp here
+    if ((uint64_t)record.textOffset + record.textLength <= textSize) {
+        view.text = text + record.textOffset;
+        view.textLength = record.textLength;
+    } else {
+        view.text = "";
+        view.textLength = 0;
+    }
+    view.answer = record.answer;
+    view.basePenalty = isfinite(record.basePenalty) ? record.basePenalty : 0.0;
+    return view;
 }
 
-void initQsRandom() {
-    // Removed srand(time(0)) - only keep one srand in the entire program
-    
-    static std::random_device rd; // Non-deterministic random number generator
+// FNV-1a over a byte range, continuing from hash
+static uint32_t fnv1a(const void* data, size_t size, uint32_t hash) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
 
-    static std::mt19937 g(rd());  // Mersenne Twister random number engine
-    
-    // Shuffle questions for each enemy type to ensure random order
-    if (!taQs.empty()) {
-        std::shuffle(taQs.begin(), taQs.end(), g);
+uint32_t QuestionSet::checksum(const QsBank& bank) const {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < bank.size(); ++i) {
+        QsView question = view(bank[i]);
+        hash = fnv1a(question.text, question.textLength, hash);
+        hash = fnv1a(&question.answer, 1, hash);
+        hash = fnv1a(&question.basePenalty, sizeof(question.basePenalty), hash);
     }
-    if (!profQs.empty()) {
-        std::shuffle(profQs.begin(), profQs.end(), g);
+    return hash;
+}
+
+bool QuestionSet::loadTextFiles(ostream& log) {
+    QsFileResult results[3];
+    read_Qs_files(results);
+
+    bool anyOpened = false;
+    for (int i = 0; i < 3; ++i) {
+        report_Qs_file(QS_FILES[i], QS_LABELS[i], results[i], log);
+        anyOpened = anyOpened || results[i].opened;
+    }
+
+    uint32_t counts[3];
+    merge_Qs_files(results, ownedRecords, ownedText, counts);
+
+    text = ownedText.data();
+    textSize = ownedText.size();
+    setBanks(ownedRecords.data(), counts);
+    return anyOpened;
+}
+
+bool QuestionSet::loadPack(const string& filename, ostream& log) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
     }
-    if (!stuQs.empty()) {
-        std::shuffle(stuQs.begin(), stuQs.end(), g);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(QsPackHeader)) {
+        close(fd);
+        log << "Error: Question pack is truncated: " << filename << endl;
+        return false;
     }
-    
-    cout << "Random system initialized." << endl;
+    size_t size = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        log << "Error: Cannot map question pack: " << filename << endl;
+        return false;
+    }
+    // Encounters touch scattered records and strings; skip read-ahead
+    madvise(mapped, size, MADV_RANDOM);
+
+    // Validate the header and section bounds only; nothing is read per question.
+    // Offsets come from the file: compare against what is left after them so a
+    // huge offset or count cannot wrap around and pass.
+    const char* base = static_cast<const char*>(mapped);
+    const QsPackHeader* header = reinterpret_cast<const QsPackHeader*>(base);
+    uint64_t records = (uint64_t)header->counts[0] + header->counts[1] + header->counts[2];
+    bool valid = memcmp(header->magic, "HKQP", 4) == 0 &&
+                 header->version == QS_PACK_VERSION &&
+                 header->recordsOffset % alignof(QsRecord) == 0 &&
+                 header->recordsOffset <= size &&
+                 records <= (size - header->recordsOffset) / sizeof(QsRecord) &&
+                 header->textOffset <= size &&
+                 header->textSize <= size - header->textOffset;
+    if (!valid) {
+        munmap(mapped, size);
+        log << "Error: Invalid or outdated question pack: " << filename << endl;
+        return false;
+    }
+
+    mapping = mapped;
+    mappingSize = size;
+    text = base + header->textOffset;
+    textSize = header->textSize;
+    setBanks(reinterpret_cast<const QsRecord*>(base + header->recordsOffset), header->counts);
+
+    for (int i = 0; i < 3; ++i) {
+        log << "Loaded " << header->counts[i] << " " << QS_LABELS[i] << " questions from " << filename << "." << endl;
+    }
+    return true;
 }
 
-void load_All_Qs() {
-    load_TA_Qs("questions_ta.txt");
-    load_Prof_Qs("questions_prof.txt");
-    load_Stu_Qs("questions_student.txt");
-    cout << "All questions loaded successfully!" << endl;
+void QuestionSet::loadBuiltin(ostream& log) {
+    text = qsBuiltinText;
+    textSize = qsBuiltinTextSize;
+    setBanks(qsBuiltinRecords, qsBuiltinCounts);
+    log << "Loaded " << qsBuiltinCounts[0] << " TA, " << qsBuiltinCounts[1] << " Professor and "
+         << qsBuiltinCounts[2] << " Student questions from the built-in bank." << endl;
 }
 
-void load_TA_Qs(const string& filename) {
-    taQs = vector<Qs>(); // Clear existing questions
-    
-    ifstream file(filename);
-    if (file.fail()) {
-        cout << "Error: Cannot open TA questions file: " << filename << endl;
-        return;
+// True unless a was modified strictly before b, to the nanosecond. File times
+// come from a coarse clock, so an edit right after a pack build can share its stamp.
+static bool mtime_not_before(const struct stat& a, const struct stat& b) {
+    return a.st_mtim.tv_sec != b.st_mtim.tv_sec ? a.st_mtim.tv_sec > b.st_mtim.tv_sec
+                                                : a.st_mtim.tv_nsec >= b.st_mtim.tv_nsec;
+}
+
+// The pack is only used if it is strictly newer than every text file it was built from
+static bool Qs_pack_is_fresh(const char* packFile, ostream& log) {
+    struct stat packStat;
+    if (stat(packFile, &packStat) != 0) {
+        return false;
     }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue; // Skip empty lines
-        
-        istringstream iss(line);
-        string question, answer;
-        double penalty;
-
-        // Parse line using pipe delimiter: Question|Answer|Penalty
-        if (getline(iss, question, '|') && getline(iss, answer, '|') && (iss >> penalty)) {
-            Qs q;
-            q.questionText = trim(question);
-            q.answer = trim(answer);
-            q.basePenalty = penalty;
-            taQs.push_back(q);
+    for (int i = 0; i < 3; ++i) {
+        struct stat textStat;
+        if (stat(QS_FILES[i], &textStat) == 0 && mtime_not_before(textStat, packStat)) {
+            log << "Note: " << QS_FILES[i] << " is newer than " << packFile
+                 << ", loading text files (run 'make pack' to rebuild)." << endl;
+            return false;
         }
     }
-    file.close();
-    
-    cout << "Loaded " << taQs.size() << " TA questions." << endl;
+    return true;
 }
 
-void load_Prof_Qs(const string& filename) {
-    profQs = vector<Qs>(); 
-    
-    ifstream file(filename);
-    if (file.fail()) {
-        cout << "Error: Cannot open Professor questions file: " << filename << endl;
+// True if any external question source exists and should override the built-in bank
+static bool external_Qs_present() {
+    struct stat st;
+    if (stat(QS_PACK_FILE, &st) == 0) return true;
+    for (int i = 0; i < 3; ++i) {
+        if (stat(QS_FILES[i], &st) == 0) return true;
+    }
+    return false;
+}
+
+shared_ptr<const QuestionSet> load_Qs_set(ostream& log) {
+    shared_ptr<QuestionSet> qs = make_shared<QuestionSet>();
+    if (!external_Qs_present()) {
+        qs->loadBuiltin(log);
+    } else if (!(Qs_pack_is_fresh(QS_PACK_FILE, log) && qs->loadPack(QS_PACK_FILE, log))) {
+        qs = make_shared<QuestionSet>(); // Discard a half-tried pack
+        qs->loadTextFiles(log);
+    }
+    return qs;
+}
+
+void load_All_Qs(ostream& log) {
+    // Loaded once per process; later games share the same read-only bank
+    lock_guard<mutex> lock(sharedQsLoadMutex);
+    if (atomic_load(&sharedQs) != nullptr) {
         return;
     }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        
-        istringstream iss(line);
-        string question, answer;
-        double penalty;
-        
-        if (getline(iss, question, '|') && getline(iss, answer, '|') && (iss >> penalty)) { 
-            Qs q;
-            q.questionText = trim(question);
-            q.answer = trim(answer);
-            q.basePenalty = penalty;
-            profQs.push_back(q);
+    atomic_store(&sharedQs, load_Qs_set(log));
+    log << "All questions loaded successfully!" << endl;
+}
+
+shared_ptr<const QuestionSet> current_Qs() {
+    shared_ptr<const QuestionSet> qs = atomic_load(&sharedQs);
+    if (qs == nullptr) {
+        load_All_Qs();
+        qs = atomic_load(&sharedQs);
+    }
+    return qs;
+}
+
+/**
+ * @brief Modification stamp of every file the question bank can come from
+ */
+struct QsSourceStamp {
+    long long mtimeNs[4];
+    long long size[4];
+
+    bool operator!=(const QsSourceStamp& other) const {
+        for (int i = 0; i < 4; ++i) {
+            if (mtimeNs[i] != other.mtimeNs[i] || size[i] != other.size[i]) return true;
         }
+        return false;
     }
-    file.close();
-    
-    cout << "Loaded " << profQs.size() << " Professor questions." << endl;
+};
+
+static QsSourceStamp stamp_Qs_sources() {
+    const char* paths[4] = {QS_PACK_FILE, QS_FILES[0], QS_FILES[1], QS_FILES[2]};
+    QsSourceStamp stamp;
+    for (int i = 0; i < 4; ++i) {
+        struct stat st;
+        if (stat(paths[i], &st) == 0) {
+            stamp.mtimeNs[i] = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+            stamp.size[i] = (long long)st.st_size;
+        } else {
+            stamp.mtimeNs[i] = -1;
+            stamp.size[i] = -1;
+        }
+    }
+    return stamp;
 }
 
-void load_Stu_Qs(const string& filename) {
-    stuQs = vector<Qs>();
-    
-    ifstream file(filename);
-    if (file.fail()) {
-        cout << "Error: Cannot open Student questions file: " << filename << endl;
+// Poll the source files; build a replacement bank off the game thread and swap it in
+static void watch_Qs_sources(unsigned intervalMs) {
+    QsSourceStamp last = stamp_Qs_sources();
+    unique_lock<mutex> lock(watcherMutex);
+    while (!watcherWake.wait_for(lock, chrono::milliseconds(intervalMs), [] { return watcherStop; })) {
+        lock.unlock();
+        QsSourceStamp now = stamp_Qs_sources();
+        if (now != last) {
+            last = now;
+            ostringstream log;
+            shared_ptr<const QuestionSet> fresh = load_Qs_set(log);
+            atomic_store(&sharedQs, fresh);
+            log << "Question bank reloaded (" << fresh->total() << " questions)." << endl;
+            lock_guard<mutex> noticeLock(reloadNoticeMutex);
+            reloadNotice += log.str();
+            reloadNoticePending.store(true, memory_order_release);
+        }
+        lock.lock();
+    }
+}
+
+void start_Qs_watcher(unsigned intervalMs) {
+    lock_guard<mutex> lock(watcherMutex);
+    if (watcherThread.joinable()) {
         return;
     }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) {
-            continue;
-        }
-        
-        istringstream iss(line);
-        string question, answer;
-        double penalty;
-        
-        if (getline(iss, question, '|') && getline(iss, answer, '|') && (iss >> penalty)) {
-            Qs q;
-            q.questionText = trim(question);
-            q.answer = trim(answer);
-            q.basePenalty = penalty;
-            stuQs.push_back(q);
+    watcherStop = false;
+    watcherThread = thread(watch_Qs_sources, intervalMs);
+}
+
+void stop_Qs_watcher() {
+    {
+        lock_guard<mutex> lock(watcherMutex);
+        if (!watcherThread.joinable()) {
+            return;
         }
+        watcherStop = true;
     }
-    file.close();
-    
-    cout << "Loaded " << stuQs.size() << " Student questions." << endl;
+    watcherWake.notify_all();
+    watcherThread.join();
 }
 
-double ask(char enemyType, const set_difficulty& difficulty) {
-    string enemyName;
-    Qs selectedQuestion;
-    double basePenalty = 0.0;
-    bool foundQuestion = false;
+bool print_Qs_reload_notice(ostream& out) {
+    if (!reloadNoticePending.load(memory_order_acquire)) return false;
+    lock_guard<mutex> lock(reloadNoticeMutex);
+    out << reloadNotice << flush;
+    reloadNotice.clear();
+    reloadNoticePending.store(false, memory_order_relaxed);
+    return true;
+}
+
+const char* enemy_display_name(char enemyType) {
+    switch (enemyType) {
+        case 'T': return "TA";
+        case 'F': return "Professor";
+        case 'S': return "Student";
+        default: return nullptr;
+    }
+}
 
-    // Select question based on enemy type
+bool draw_question(const QsBank& bank, QsSampler& sampler, QsAdaptive* adaptive,
+                   uint32_t& index, bool& weighted) {
+    if (bank.empty()) return false;
+    // Draw by mastery weight, or without replacement when weights are off
+    weighted = adaptive != nullptr && adaptive->size() == bank.size();
+    index = weighted ? adaptive->draw() : sampler_next(sampler, (uint32_t)bank.size());
+    return true;
+}
+
+bool peek_question(const QsBank& bank, const QsSampler& sampler, const QsAdaptive* adaptive,
+                   uint32_t& index, bool& weighted) {
+    if (bank.empty()) return false;
+    weighted = adaptive != nullptr && adaptive->size() == bank.size();
+    index = weighted ? adaptive->peek() : sampler_peek(sampler, (uint32_t)bank.size());
+    return true;
+}
+
+void format_question(char enemyType, const QsView& question, string& out) {
+    const char* enemyName = enemy_display_name(enemyType);
+    out.assign("\n=== ");
+    out.append(enemyName != nullptr ? enemyName : "Unknown");
+    out.append(" Encounter! ===\n");
+    out.append(question.text, question.textLength);
+    out.push_back('\n');
+}
+
+double question_penalty(char enemyType, const set_difficulty& difficulty, double basePenalty) {
     if (enemyType == 'T') {
-        enemyName = "TA";
-        if (taQs.empty()) {
-            cout << enemyName << ": No questions available. You're lucky this time!" << endl;
-            return 0.0;
-        }
-        int rd = rand() % taQs.size(); // Randomly select a question
-        selectedQuestion = taQs[rd];
-        basePenalty = selectedQuestion.basePenalty;
-        foundQuestion = true;
-        
+        return basePenalty * difficulty.ta_penalty_k;
     } else if (enemyType == 'F') {
-        enemyName = "Professor";
-        if (profQs.empty()) {
-            cout << enemyName << ": No questions available. You're lucky this time!" << endl;
-            return 0.0;
-        }
-        int rd = rand() % profQs.size(); 
-        selectedQuestion = profQs[rd];
-        basePenalty = selectedQuestion.basePenalty;
-        foundQuestion = true;
-        
+        return basePenalty * difficulty.prof_penalty_k;
     } else if (enemyType == 'S') {
-        enemyName = "Student";
-        if (stuQs.empty()) {
-            cout << enemyName << ": No questions available. You're lucky this time!" << endl;
-            return 0.0;
-        }
-        int rd = rand() % stuQs.size();
-        selectedQuestion = stuQs[rd];
-        basePenalty = selectedQuestion.basePenalty;
-        foundQuestion = true;
-        
+        return basePenalty * difficulty.stu_penalty_k;
+    }
+    return basePenalty;
+}
+
+bool pose_question(char enemyType, const QuestionSet& questions, QsSampler& sampler,
+                   QsAdaptive* adaptive, const PreparedQuestion* prepared, PendingQuestion& pending,
+                   ostream& out) {
+    const char* enemyName = enemy_display_name(enemyType);
+    const QsBank* bank = questions.bank(enemyType);
+
+    // Select question bank based on enemy type
+    if (enemyName == nullptr) {
+        out << "Error: Unknown enemy type: " << enemyType << endl;
+        return false;
+    }
+
+    if (bank->empty()) {
+        out << enemyName << ": No questions available. You're lucky this time!" << endl;
+        return false;
+    }
+
+    pending.enemyType = enemyType;
+    draw_question(*bank, sampler, adaptive, pending.index, pending.weighted);
+    pending.view = questions.view((*bank)[pending.index]);
+    if (prepared != nullptr && prepared->enemyType == enemyType && prepared->questions == &questions
+        && prepared->index == pending.index && prepared->weighted == pending.weighted) {
+        // Prefetched: the draw still lands on the question formatted off the game thread
+        out << prepared->text;
+        out.flush();
     } else {
-        cout << "Error: Unknown enemy type: " << enemyType << endl;
-        return 0.0;
+        // Present question
+        out << "\n=== " << enemyName << " Encounter! ===" << endl;
+        out.write(pending.view.text, pending.view.textLength);
+        out << endl;
     }
-    
-    if (!foundQuestion) {
-        return 0.0;
+    return true;
+}
+
+double answer_question(const PendingQuestion& pending, const set_difficulty& difficulty,
+                       QsAdaptive* adaptive, int answer, bool timedOut, ostream& out) {
+    // Evaluate answer
+    char correctChar = pending.view.answer; // Stored upper-case at load time
+    if (pending.weighted && adaptive != nullptr) {
+        adaptive->recordAnswer(pending.index, answer == correctChar);
     }
 
-    // Present question and get player input
-    cout << "\n=== " << enemyName << " Encounter! ===" << endl;
-    cout << selectedQuestion.questionText << endl;
+    if (timedOut) {
+        out << endl << "⏰ Time's up!" << endl;
+    }
+
+    if (answer == correctChar) {
+        out << "✓ Correct! Well done!" << endl;
+        return 0.0; // No penalty for correct answer
+    } else {
+        // Apply penalty with difficulty multiplier
+        double actualPenalty = question_penalty(pending.enemyType, difficulty, pending.view.basePenalty);
+        
+        out << "✗ Wrong! The correct answer is: " << correctChar << endl;
+        out << "You lost " << actualPenalty << " GPA!" << endl;
+        
+        return actualPenalty; // Return the calculated penalty
+    }
+}
+
+double ask(char enemyType, const set_difficulty& difficulty, const QuestionSet& questions,
+           QsSampler& sampler, QsAdaptive* adaptive, const PreparedQuestion* prepared, ostream& out) {
+    PendingQuestion pending;
+    if (!pose_question(enemyType, questions, sampler, adaptive, prepared, pending, out)) {
+        return 0.0;
+    }
     
-    char playerAnswer;
+    // Keys typed ahead (e.g. a held movement key) must not answer the question
+    input_flush();
+    
+    int playerAnswer = 0;
     bool validInput = false;
+    bool timedOut = false;
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(difficulty.answerTimeoutMs);
+    
+    if (difficulty.answerTimeoutMs > 0 && input_is_raw()) {
+        out << "(Time limit: " << (difficulty.answerTimeoutMs + 999) / 1000 << "s)" << endl;
+    }
 
     // Input validation loop for answer choice
     while (!validInput) {
-        cout << "Your answer (enter A/B/C/D): ";
-        cin >> playerAnswer;
-
-        cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Clear input buffer
+        out << "Your answer (enter A/B/C/D): ";
+        
+        // The timeout only applies to single-key input from a terminal
+        int waitMs = -1;
+        if (difficulty.answerTimeoutMs > 0 && input_is_raw()) {
+            auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            waitMs = left.count() > 0 ? (int)left.count() : 0;
+        }
+        playerAnswer = input_read_key(waitMs);
+        if (playerAnswer == INPUT_TIMEOUT || playerAnswer == INPUT_EOF) {
+            timedOut = playerAnswer == INPUT_TIMEOUT;
+            playerAnswer = 0;
+            break; // Counts as a wrong answer
+        }
         
         playerAnswer = toupper(playerAnswer); // Convert to uppercase for case-insensitive comparison
         
         // Validate input format
         if (playerAnswer == 'A' || playerAnswer == 'B' || playerAnswer == 'C' || playerAnswer == 'D') {
             validInput = true;
+            if (input_is_raw()) out << (char)playerAnswer << endl; // Raw keys are not echoed by the terminal
         } else {
-            cout << "✗ Invalid input! Please enter A, B, C, or D." << endl;
+            if (input_is_raw()) out << endl;
+            out << "✗ Invalid input! Please enter A, B, C, or D." << endl;
         }
     }
 
-    // Evaluate answer
-    char correctChar = toupper(selectedQuestion.answer[0]); // Get first character of answer
-
-    if (playerAnswer == correctChar) {
-        cout << "✓ Correct! Well done!" << endl;
-        return 0.0; // No penalty for correct answer
-    } else {
-        double actualPenalty = basePenalty;
-        
-        // Apply penalty with difficulty multiplier
-        if (enemyType == 'T') {
-            actualPenalty *= difficulty.ta_penalty_k;
-        } else if (enemyType == 'F') {
-            actualPenalty *= difficulty.prof_penalty_k;
-        } else if (enemyType == 'S') {
-            actualPenalty *= difficulty.stu_penalty_k;
-        }
-        
-        cout << "✗ Wrong! The correct answer is: " << selectedQuestion.answer << endl;
-        cout << "You lost " << actualPenalty << " GPA!" << endl;
-        
-        return actualPenalty; // Return the calculated penalty
-    }
+    return answer_question(pending, difficulty, adaptive, playerAnswer, timedOut, out);
 }
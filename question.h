@@ -3,6 +3,12 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <memory>
+#include <iostream>
+#include "question_pack.h"
+#include "sampler.h"
+#include "adaptive.h"
 
 using namespace std;
 
@@ -12,75 +18,307 @@ using namespace std;
  * @param ta_penalty_k Penalty multiplier for TA encounters
  * @param prof_penalty_k Penalty multiplier for Professor encounters  
  * @param stu_penalty_k Penalty multiplier for Student encounters
+ * @param answerTimeoutMs Time allowed to answer in milliseconds (0 = unlimited)
  */
 struct set_difficulty {
     double initialGPA;
     double ta_penalty_k;
     double prof_penalty_k;
     double stu_penalty_k;
+    int answerTimeoutMs;
 };
 
 /**
- * @brief Structure representing a question in the game
- * @param questionText The text of the question to be displayed
+ * @brief Read-only slice of question records for one enemy type
+ */
+struct QsBank {
+    const QsRecord* records;
+    size_t count;
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    const QsRecord& operator[](size_t i) const { return records[i]; }
+};
+
+/**
+ * @brief Read-only view of a question, resolved against its text arena
+ * @param text Pointer to the question text (not NUL-terminated)
+ * @param textLength Length of the question text in bytes
  * @param answer The correct answer (A, B, C, or D)
  * @param basePenalty The base GPA penalty for incorrect answers
  */
-struct Qs {
-    string questionText;
-    string answer;
+struct QsView {
+    const char* text;
+    size_t textLength;
+    char answer;
     double basePenalty;
 };
 
-// Global vectors storing questions for different enemy types
-extern vector<Qs> taQs;      ///< Questions asked by TAs
-extern vector<Qs> profQs;    ///< Questions asked by Professors 
-extern vector<Qs> stuQs;     ///< Questions asked by Students
+// Question bank compiled into the binary (generated questions_builtin.cpp)
+extern const uint32_t qsBuiltinCounts[3];
+extern const QsRecord qsBuiltinRecords[];
+extern const char qsBuiltinText[];
+extern const size_t qsBuiltinTextSize;
+
+/**
+ * @brief One immutable, loaded question bank shared by all sessions
+ *
+ * Holds the TA, Professor and Student banks together with the storage
+ * behind them: buffers parsed from the text files, a read-only mapping
+ * of a compiled pack, or the bank compiled into the binary. Sessions keep
+ * a shared_ptr to the set they started with, so a hot reload never
+ * changes questions underneath a running encounter.
+ */
+class QuestionSet {
+private:
+    vector<QsRecord> ownedRecords; ///< Records parsed from text files
+    string ownedText;              ///< Text arena parsed from text files
+    void* mapping;                 ///< Mapped pack file, if any
+    size_t mappingSize;            ///< Size of the mapping in bytes
+
+    void setBanks(const QsRecord* records, const uint32_t counts[3]);
+
+public:
+    QsBank ta;          ///< Questions asked by TAs
+    QsBank prof;        ///< Questions asked by Professors
+    QsBank stu;         ///< Questions asked by Students
+    const char* text;   ///< Text arena the record offsets refer to
+    size_t textSize;    ///< Size of the text arena in bytes
+
+    QuestionSet();
+    ~QuestionSet();
+
+    QuestionSet(const QuestionSet&) = delete;
+    QuestionSet& operator=(const QuestionSet&) = delete;
+
+    /**
+     * @brief Parses the three pipe-delimited question files in parallel
+     * @param log Where progress and errors are reported
+     * @return True if at least one file could be read
+     */
+    bool loadTextFiles(ostream& log = cout);
+
+    /**
+     * @brief Memory-maps a compiled question pack
+     *
+     * Only the header is validated up front; records and text are paged in
+     * by the OS when an encounter first touches them.
+     *
+     * @param filename Path to the pack file
+     * @param log Where progress and errors are reported
+     * @return True if the pack was mapped
+     */
+    bool loadPack(const string& filename, ostream& log = cout);
+
+    /**
+     * @brief Points the banks at the question bank compiled into the binary
+     * @param log Where progress is reported
+     */
+    void loadBuiltin(ostream& log = cout);
+
+    /**
+     * @brief Returns the bank asked by an enemy type
+     * @param enemyType 'T', 'F' or 'S'
+     * @return The bank, or nullptr for an unknown type
+     */
+    const QsBank* bank(char enemyType) const;
+
+    /**
+     * @brief Resolves a question record against this set's text arena
+     * @param record Record from one of this set's banks
+     * @return View of the question, valid as long as the set is alive
+     */
+    QsView view(const QsRecord& record) const;
+
+    /**
+     * @brief Checksum of a bank's questions, answers and penalties
+     *
+     * Identifies the bank mastery stats were recorded on. Reads every
+     * question of the bank, so callers compute it once per set.
+     *
+     * @param bank One of this set's banks
+     * @return 32-bit FNV-1a hash of the bank
+     */
+    uint32_t checksum(const QsBank& bank) const;
+
+    /**
+     * @brief Total number of questions in the three banks
+     */
+    size_t total() const { return ta.count + prof.count + stu.count; }
+};
 
 // Function declarations
 
 /**
- * @brief Removes leading and trailing whitespace from a string
- * @param str Input string to be trimmed
- * @return Trimmed string without leading/trailing whitespace
+ * @brief Builds a new question set from the best available source
+ *
+ * Maps the compiled pack (questions.pack) when it exists and is newer
+ * than the text files; otherwise parses the three text files in parallel.
+ * If neither is present, the bank compiled into the binary is used
+ * without any file I/O.
+ *
+ * @param log Where progress and errors are reported
+ * @return The freshly loaded set
+ */
+shared_ptr<const QuestionSet> load_Qs_set(ostream& log = cout);
+
+/**
+ * @brief Loads the process-wide question bank if it is not loaded yet
+ *
+ * Later calls return immediately; use current_Qs() to get the bank.
+ *
+ * @param log Where progress and errors are reported
+ */
+void load_All_Qs(ostream& log = cout);
+
+/**
+ * @brief Returns a snapshot of the process-wide question bank
+ *
+ * Loads it on first use. The snapshot stays valid after a hot reload
+ * swaps in a newer bank.
+ *
+ * @return Shared, read-only question set
  */
-string trim(const string& str);
+shared_ptr<const QuestionSet> current_Qs();
 
 /**
- * @brief Initializes random question ordering using modern shuffle algorithm
- * Uses std::shuffle for proper random distribution instead of unstable sort
+ * @brief Starts a background thread that reloads the bank when files change
+ *
+ * Polls the modification time and size of questions.pack and the three
+ * text files, and atomically swaps in a new bank after a change. The
+ * watcher prints nothing itself: what the reload reported is kept for
+ * print_Qs_reload_notice().
+ *
+ * @param intervalMs Polling interval in milliseconds
  */
-void initQsRandom();
+void start_Qs_watcher(unsigned intervalMs = 1000);
 
 /**
- * @brief Loads all question files (TA, Professor, Student)
+ * @brief Stops the question file watcher started by start_Qs_watcher()
  */
-void load_All_Qs();
+void stop_Qs_watcher();
 
 /**
- * @brief Loads TA questions from specified file
- * @param filename Path to the TA questions file
+ * @brief Prints what the last hot reloads reported, once
+ *
+ * Called by a game between turns, so reload messages never interleave
+ * with its own output. Costs one atomic load when nothing was reloaded.
+ *
+ * @param out Stream to print to
+ * @return True if a notice was printed
  */
-void load_TA_Qs(const string& filename);
+bool print_Qs_reload_notice(ostream& out);
 
 /**
- * @brief Loads Professor questions from specified file
- * @param filename Path to the Professor questions file
+ * @brief A question drawn and formatted ahead of its encounter
  */
-void load_Prof_Qs(const string& filename);
+struct PreparedQuestion {
+    char enemyType;                 ///< Enemy type the question was drawn for
+    uint32_t index;                 ///< Index in that type's bank
+    bool weighted;                  ///< True if drawn by mastery weight
+    const QuestionSet* questions;   ///< Set the index refers to
+    string text;                    ///< Encounter banner and question text, ready to print
+};
+
+/**
+ * @brief A question put to the player that is waiting for an answer
+ */
+struct PendingQuestion {
+    char enemyType;     ///< Enemy type asking the question
+    uint32_t index;     ///< Index in that type's bank
+    bool weighted;      ///< True if drawn by mastery weight, so the answer updates the weights
+    QsView view;        ///< Text, answer and base penalty
+};
+
+/**
+ * @brief Display name of an enemy type
+ * @param enemyType 'T', 'F' or 'S'
+ * @return "TA", "Professor", "Student", or nullptr for an unknown type
+ */
+const char* enemy_display_name(char enemyType);
+
+/**
+ * @brief Draws the next question index from a bank
+ * @param bank Bank to draw from
+ * @param sampler Session sampler used when weights are off
+ * @param adaptive Mastery weights for this bank, or nullptr
+ * @param index Output question index
+ * @param weighted Output true if the draw used the mastery weights
+ * @return False if the bank is empty
+ */
+bool draw_question(const QsBank& bank, QsSampler& sampler, QsAdaptive* adaptive,
+                   uint32_t& index, bool& weighted);
+
+/**
+ * @brief The question draw_question() would return next, without drawing it
+ *
+ * Neither the sampler nor the weights move, so a question looked up
+ * ahead of an encounter that never happens is not lost from the cycle.
+ *
+ * @return False if the bank is empty
+ */
+bool peek_question(const QsBank& bank, const QsSampler& sampler, const QsAdaptive* adaptive,
+                   uint32_t& index, bool& weighted);
+
+/**
+ * @brief Formats the encounter banner and question text as ask() prints them
+ * @param enemyType Enemy type asking the question
+ * @param question Question to format
+ * @param out Output text; its capacity is reused
+ */
+void format_question(char enemyType, const QsView& question, string& out);
+
+/**
+ * @brief GPA penalty for a wrong answer, scaled by the enemy type's multiplier
+ * @param enemyType Enemy type asking the question
+ * @param difficulty Difficulty settings holding the multipliers
+ * @param basePenalty Base penalty of the question
+ * @return Penalty to subtract from the GPA
+ */
+double question_penalty(char enemyType, const set_difficulty& difficulty, double basePenalty);
 
 /**
- * @brief Loads Student questions from specified file
- * @param filename Path to the Student questions file
+ * @brief Draws a question and prints it, without waiting for the answer
+ * @param enemyType Character representing enemy type ('T'=TA, 'F'=Professor, 'S'=Student)
+ * @param questions Question set snapshot of the current session
+ * @param sampler Session sampler for this enemy type's bank
+ * @param adaptive Mastery weights for this bank, or nullptr to draw from the sampler
+ * @param prepared Question prefetched for this encounter, or nullptr; its text is
+ *        printed if the draw picks the question it was prepared for
+ * @param pending Output question awaiting the answer (refers into questions)
+ * @param out Stream to print to
+ * @return False if there is nothing to ask (the encounter costs nothing)
+ */
+bool pose_question(char enemyType, const QuestionSet& questions, QsSampler& sampler,
+                   QsAdaptive* adaptive, const PreparedQuestion* prepared, PendingQuestion& pending,
+                   ostream& out = cout);
+
+/**
+ * @brief Evaluates the answer to a posed question and prints the result
+ * @param pending Question returned by pose_question()
+ * @param difficulty Difficulty settings for penalty calculations
+ * @param adaptive Mastery weights for the question's bank, or nullptr
+ * @param answer Upper-case answer letter, or 0 if none was given
+ * @param timedOut True if the time to answer ran out
+ * @param out Stream to print to
+ * @return GPA penalty applied (0.0 if answer was correct)
  */
-void load_Stu_Qs(const string& filename);
+double answer_question(const PendingQuestion& pending, const set_difficulty& difficulty,
+                       QsAdaptive* adaptive, int answer, bool timedOut, ostream& out = cout);
 
 /**
  * @brief Presents a question to the player and evaluates their answer
  * @param enemyType Character representing enemy type ('T'=TA, 'F'=Professor, 'S'=Student)
  * @param difficulty Difficulty settings for penalty calculations
+ * @param questions Question set snapshot of the current session
+ * @param sampler Session sampler for this enemy type's bank
+ * @param adaptive Mastery weights for this bank, or nullptr to draw from the sampler
+ * @param prepared Question prefetched for this encounter, or nullptr to draw now
+ * @param out Stream to print to (the answer is still read from the terminal)
  * @return GPA penalty applied (0.0 if answer was correct)
  */
-double ask(char enemyType, const set_difficulty& difficulty);
+double ask(char enemyType, const set_difficulty& difficulty, const QuestionSet& questions,
+           QsSampler& sampler, QsAdaptive* adaptive, const PreparedQuestion* prepared = nullptr,
+           ostream& out = cout);
 
 #endif
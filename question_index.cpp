@@ -0,0 +1,258 @@
+#include "question_index.h"
+#include <algorithm>
+#include <cctype>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Words per shingle used for near-duplicate detection
+static const size_t SHINGLE_WORDS = 3;
+
+// Shingles shared by more questions than this are too common to signal a duplicate
+static const size_t SHINGLE_POSTINGS_CAP = 64;
+
+// FNV-1a, continued from a previous hash value
+static uint64_t fnv1a(uint64_t hash, const char* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+static bool is_token_char(unsigned char c) {
+    return isalnum(c) || c == '+' || c == '#';
+}
+
+void tokenize_Qs_text(const char* text, size_t len, vector<string>& tokens) {
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && !is_token_char((unsigned char)text[i])) ++i;
+        size_t start = i;
+        while (i < len && is_token_char((unsigned char)text[i])) ++i;
+        if (i > start) {
+            tokens.push_back(string(text + start, i - start));
+            string& token = tokens.back();
+            for (size_t k = 0; k < token.size(); ++k) {
+                token[k] = (char)tolower((unsigned char)token[k]);
+            }
+        }
+    }
+}
+
+QuestionIndex::QuestionIndex() {
+    for (int i = 0; i < 3; ++i) {
+        files[i].path = QS_FILES[i];
+        files[i].mtimeNs = -2; // Never matches a real stamp, so the first refresh indexes
+        files[i].size = -1;
+        files[i].questions.malformed = 0;
+        files[i].questions.opened = false;
+    }
+}
+
+int QuestionIndex::refresh(bool changed[3]) {
+    int reindexed = 0;
+    for (int i = 0; i < 3; ++i) {
+        FileIndex& f = files[i];
+        struct stat st;
+        long long mtimeNs = -1;
+        long long size = -1;
+        if (stat(f.path.c_str(), &st) == 0) {
+            mtimeNs = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+            size = (long long)st.st_size;
+        }
+
+        bool stale = mtimeNs != f.mtimeNs || size != f.size;
+        if (changed != nullptr) changed[i] = stale;
+        if (!stale) continue;
+
+        f.mtimeNs = mtimeNs;
+        f.size = size;
+        indexFile(f);
+        ++reindexed;
+    }
+    return reindexed;
+}
+
+// Rebuild postings, sequence hashes and shingles of one file from scratch
+void QuestionIndex::indexFile(FileIndex& f) {
+    f.questions = QsFileResult();
+    f.postings.clear();
+    f.textHash.clear();
+    f.shingles.clear();
+
+    read_Qs_file(f.path, f.questions);
+
+    size_t n = f.questions.records.size();
+    f.textHash.resize(n);
+    f.shingles.resize(n);
+
+    vector<string> tokens;
+    for (size_t q = 0; q < n; ++q) {
+        const QsRecord& r = f.questions.records[q];
+        tokens.clear();
+        tokenize_Qs_text(f.questions.text.data() + r.textOffset, r.textLength, tokens);
+
+        // Questions are visited in order, so each postings list stays sorted;
+        // checking the last entry skips repeated words within a question
+        uint64_t hash = FNV_OFFSET;
+        for (size_t t = 0; t < tokens.size(); ++t) {
+            vector<uint32_t>& list = f.postings[tokens[t]];
+            if (list.empty() || list.back() != q) {
+                list.push_back((uint32_t)q);
+            }
+            hash = fnv1a(hash, tokens[t].data(), tokens[t].size());
+            hash = fnv1a(hash, " ", 1);
+        }
+        f.textHash[q] = hash;
+
+        // Short questions count as a single shingle
+        vector<uint64_t>& sh = f.shingles[q];
+        size_t width = tokens.size() < SHINGLE_WORDS ? tokens.size() : SHINGLE_WORDS;
+        for (size_t t = 0; width > 0 && t + width <= tokens.size(); ++t) {
+            uint64_t h = FNV_OFFSET;
+            for (size_t w = 0; w < width; ++w) {
+                h = fnv1a(h, tokens[t + w].data(), tokens[t + w].size());
+                h = fnv1a(h, " ", 1);
+            }
+            sh.push_back(h);
+        }
+        sort(sh.begin(), sh.end());
+        sh.erase(unique(sh.begin(), sh.end()), sh.end());
+    }
+}
+
+vector<QsRef> QuestionIndex::search(const string& query) const {
+    vector<string> terms;
+    tokenize_Qs_text(query.data(), query.size(), terms);
+    sort(terms.begin(), terms.end());
+    terms.erase(unique(terms.begin(), terms.end()), terms.end());
+
+    vector<QsRef> matches;
+    if (terms.empty()) return matches;
+
+    vector<const vector<uint32_t>*> lists;
+    vector<uint32_t> result, scratch;
+    for (uint32_t file = 0; file < 3; ++file) {
+        const FileIndex& f = files[file];
+
+        // Every term must occur in this file
+        lists.clear();
+        bool missing = false;
+        for (size_t t = 0; t < terms.size(); ++t) {
+            auto it = f.postings.find(terms[t]);
+            if (it == f.postings.end()) {
+                missing = true;
+                break;
+            }
+            lists.push_back(&it->second);
+        }
+        if (missing) continue;
+
+        // Intersect shortest lists first so the running result stays small
+        sort(lists.begin(), lists.end(),
+             [](const vector<uint32_t>* a, const vector<uint32_t>* b) { return a->size() < b->size(); });
+        result = *lists[0];
+        for (size_t l = 1; l < lists.size() && !result.empty(); ++l) {
+            scratch.clear();
+            set_intersection(result.begin(), result.end(), lists[l]->begin(), lists[l]->end(),
+                             back_inserter(scratch));
+            result.swap(scratch);
+        }
+
+        for (size_t i = 0; i < result.size(); ++i) {
+            QsRef ref = {file, result[i]};
+            matches.push_back(ref);
+        }
+    }
+    return matches;
+}
+
+vector<QsDuplicate> QuestionIndex::duplicates(double threshold) const {
+    // Number every question across the three files
+    size_t base[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 3; ++i) {
+        base[i + 1] = base[i] + files[i].shingles.size();
+    }
+    size_t total = base[3];
+    vector<QsRef> refs(total);
+    vector<const vector<uint64_t>*> shingles(total);
+    vector<uint64_t> textHash(total);
+    for (uint32_t i = 0; i < 3; ++i) {
+        for (uint32_t q = 0; q < files[i].shingles.size(); ++q) {
+            QsRef ref = {i, q};
+            refs[base[i] + q] = ref;
+            shingles[base[i] + q] = &files[i].shingles[q];
+            textHash[base[i] + q] = files[i].textHash[q];
+        }
+    }
+
+    vector<QsDuplicate> pairs;
+
+    // Exact duplicates: equal token-sequence hashes
+    vector<pair<uint64_t, uint32_t>> byHash(total);
+    for (size_t g = 0; g < total; ++g) {
+        byHash[g] = make_pair(textHash[g], (uint32_t)g);
+    }
+    sort(byHash.begin(), byHash.end());
+    for (size_t start = 0; start < total;) {
+        size_t end = start + 1;
+        while (end < total && byHash[end].first == byHash[start].first) ++end;
+        bool hasWords = !shingles[byHash[start].second]->empty();
+        for (size_t a = start; hasWords && a < end; ++a) {
+            for (size_t b = a + 1; b < end; ++b) {
+                QsDuplicate d = {refs[byHash[a].second], refs[byHash[b].second], 1.0, true};
+                pairs.push_back(d);
+            }
+        }
+        start = end;
+    }
+
+    // Near duplicates: count shared shingles per candidate pair
+    unordered_map<uint64_t, vector<uint32_t>> shingleOwners;
+    for (size_t g = 0; g < total; ++g) {
+        for (uint64_t h : *shingles[g]) {
+            shingleOwners[h].push_back((uint32_t)g);
+        }
+    }
+    unordered_map<uint64_t, uint32_t> shared;
+    for (const auto& entry : shingleOwners) {
+        const vector<uint32_t>& owners = entry.second;
+        if (owners.size() < 2 || owners.size() > SHINGLE_POSTINGS_CAP) continue;
+        for (size_t a = 0; a < owners.size(); ++a) {
+            for (size_t b = a + 1; b < owners.size(); ++b) {
+                ++shared[((uint64_t)owners[a] << 32) | owners[b]];
+            }
+        }
+    }
+    for (const auto& entry : shared) {
+        uint32_t a = (uint32_t)(entry.first >> 32);
+        uint32_t b = (uint32_t)entry.first;
+        if (textHash[a] == textHash[b]) continue; // Already reported as exact
+        double common = entry.second;
+        double similarity = common / (shingles[a]->size() + shingles[b]->size() - common);
+        if (similarity >= threshold) {
+            QsDuplicate d = {refs[a], refs[b], similarity, false};
+            pairs.push_back(d);
+        }
+    }
+
+    stable_sort(pairs.begin(), pairs.end(), [](const QsDuplicate& x, const QsDuplicate& y) {
+        if (x.exact != y.exact) return x.exact;
+        if (x.similarity != y.similarity) return x.similarity > y.similarity;
+        if (x.a.file != y.a.file) return x.a.file < y.a.file;
+        if (x.a.index != y.a.index) return x.a.index < y.a.index;
+        if (x.b.file != y.b.file) return x.b.file < y.b.file;
+        return x.b.index < y.b.index;
+    });
+    return pairs;
+}
+
+const char* QuestionIndex::text(const QsRef& ref, size_t& len) const {
+    const QsFileResult& result = files[ref.file].questions;
+    const QsRecord& r = result.records[ref.index];
+    len = r.textLength;
+    return result.text.data() + r.textOffset;
+}
@@ -0,0 +1,116 @@
+#ifndef QUESTION_INDEX_H
+#define QUESTION_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "question_pack.h"
+
+using namespace std;
+
+/**
+ * @brief Identifies one question: its file (0 = TA, 1 = Professor, 2 = Student) and position
+ */
+struct QsRef {
+    uint32_t file;
+    uint32_t index;
+};
+
+/**
+ * @brief Two questions whose shingle sets overlap
+ * @param a First question
+ * @param b Second question
+ * @param similarity Jaccard similarity of their shingle sets (1.0 = same wording)
+ * @param exact True if both normalize to the same token sequence
+ */
+struct QsDuplicate {
+    QsRef a;
+    QsRef b;
+    double similarity;
+    bool exact;
+};
+
+/**
+ * @brief Inverted index over the question text of the three question files
+ *
+ * Question text is split into lower-case tokens; each token maps to a
+ * sorted postings list of the questions containing it. Every question
+ * also keeps a hash of its whole token sequence (exact duplicates) and
+ * the hashes of its word 3-shingles (near duplicates).
+ *
+ * Each file has its own postings, so refresh() only re-reads and
+ * re-indexes the files whose size or modification time changed.
+ */
+class QuestionIndex {
+private:
+    struct FileIndex {
+        string path;
+        long long mtimeNs;                              ///< -1 if the file is missing
+        long long size;
+        QsFileResult questions;                         ///< Parsed records and text
+        unordered_map<string, vector<uint32_t>> postings; ///< Token -> sorted question indices
+        vector<uint64_t> textHash;                      ///< Hash of each question's token sequence
+        vector<vector<uint64_t>> shingles;              ///< Sorted, unique shingle hashes per question
+    };
+
+    FileIndex files[3];
+
+    void indexFile(FileIndex& f);
+
+public:
+    QuestionIndex();
+
+    /**
+     * @brief Re-indexes every file that changed since the last call
+     * @param changed Optional output, set to true for each re-indexed file
+     * @return Number of files re-indexed
+     */
+    int refresh(bool changed[3] = nullptr);
+
+    /**
+     * @brief Finds the questions containing every keyword
+     * @param query Keywords separated by spaces or punctuation
+     * @return Matching questions in file and file order
+     */
+    vector<QsRef> search(const string& query) const;
+
+    /**
+     * @brief Finds exact and near-duplicate question pairs across all files
+     * @param threshold Minimum shingle similarity reported (0..1)
+     * @return Pairs, exact duplicates first, then by decreasing similarity
+     */
+    vector<QsDuplicate> duplicates(double threshold) const;
+
+    /**
+     * @brief Number of questions indexed in one file
+     */
+    size_t count(uint32_t file) const { return files[file].questions.records.size(); }
+
+    /**
+     * @brief Number of distinct tokens in one file
+     */
+    size_t vocabulary(uint32_t file) const { return files[file].postings.size(); }
+
+    /**
+     * @brief Question text of an indexed question
+     * @param ref Question to look up
+     * @return The text (not NUL-terminated) and its length through len
+     */
+    const char* text(const QsRef& ref, size_t& len) const;
+
+    /**
+     * @brief Parse result of one file, for reporting malformed lines
+     */
+    const QsFileResult& fileResult(uint32_t file) const { return files[file].questions; }
+};
+
+/**
+ * @brief Splits text into lower-case tokens of letters, digits, '+' and '#'
+ * @param text Text to split
+ * @param len Length of the text
+ * @param tokens Output tokens, appended in order
+ */
+void tokenize_Qs_text(const char* text, size_t len, vector<string>& tokens);
+
+#endif
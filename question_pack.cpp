@@ -0,0 +1,293 @@
+#include "question_pack.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+#include <thread>
+#include <functional>
+
+using namespace std;
+
+const char* const QS_FILES[3] = {"questions_ta.txt", "questions_prof.txt", "questions_student.txt"};
+const char* const QS_LABELS[3] = {"TA", "Professor", "Student"};
+const char QS_CATEGORIES[3] = {'T', 'F', 'S'};
+
+static_assert(sizeof(QsRecord) == 24, "QsRecord is the on-disk pack index entry");
+
+// Move begin/end inward past spaces, tabs and line endings
+static void trim_range(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\n' || *begin == '\r')) {
+        begin++;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
+    }
+}
+
+static const size_t MAX_REPORTED_BAD_LINES = 10;
+
+// Parse one "Question|Answer|Penalty" line held in [begin, end).
+// The buffer is NUL-terminated after the last line, so strtod cannot run off it.
+// On success the trimmed question text is returned in [textBegin, textEnd).
+static bool parse_Qs_line(const char* begin, const char* end, const char*& textBegin,
+                          const char*& textEnd, char& answer, double& penalty) {
+    const char* bar1 = static_cast<const char*>(memchr(begin, '|', end - begin));
+    if (bar1 == nullptr) return false;
+    const char* bar2 = static_cast<const char*>(memchr(bar1 + 1, '|', end - bar1 - 1));
+    if (bar2 == nullptr) return false;
+
+    const char* qBegin = begin;
+    const char* qEnd = bar1;
+    const char* aBegin = bar1 + 1;
+    const char* aEnd = bar2;
+    const char* pBegin = bar2 + 1;
+    const char* pEnd = end;
+    trim_range(qBegin, qEnd);
+    trim_range(aBegin, aEnd);
+    trim_range(pBegin, pEnd);
+    if (qBegin == qEnd || aBegin == aEnd || pBegin == pEnd) return false;
+
+    char* parsedEnd = nullptr;
+    penalty = strtod(pBegin, &parsedEnd);
+    // strtod also takes "nan", "inf" and overflowing values; a NaN penalty
+    // would make every later GPA comparison false
+    if (parsedEnd != pEnd || !isfinite(penalty)) return false;
+
+    textBegin = qBegin;
+    textEnd = qEnd;
+    answer = (char)toupper((unsigned char)*aBegin);
+    return true;
+}
+
+bool read_Qs_file(const string& filename, QsFileResult& result) {
+    result.text.clear();
+    result.records.clear();
+    result.badLines.clear();
+    result.malformed = 0;
+    result.opened = false;
+
+    // Read the whole file in one go
+    ifstream file(filename, ios::binary);
+    if (file.fail()) {
+        return false;
+    }
+    string& buffer = result.text;
+    file.seekg(0, ios::end);
+    streamoff size = file.tellg();
+    if (size > 0) {
+        buffer.resize((size_t)size);
+        file.seekg(0, ios::beg);
+        file.read(&buffer[0], size);
+        buffer.resize((size_t)file.gcount());
+    }
+    file.close();
+    result.opened = true;
+
+    // Split into lines in place. Question text is compacted towards the
+    // front of the same buffer, which never overtakes the line being parsed.
+    char* data = &buffer[0];
+    const char* end = data + buffer.size();
+    size_t written = 0;
+    size_t lineNumber = 0;
+
+    // Rough pre-size: the shipped banks average well over 40 bytes per line
+    result.records.reserve(buffer.size() / 40 + 1);
+
+    for (const char* line = data; line < end; ) {
+        const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+        const char* lineEnd = newline != nullptr ? newline : end;
+        lineNumber++;
+
+        const char* contentBegin = line;
+        const char* contentEnd = lineEnd;
+        trim_range(contentBegin, contentEnd);
+        if (contentBegin != contentEnd) { // Skip empty lines
+            const char* textBegin;
+            const char* textEnd;
+            QsRecord q = {};
+            if (parse_Qs_line(line, lineEnd, textBegin, textEnd, q.answer, q.basePenalty)) {
+                q.textOffset = (uint32_t)written;
+                q.textLength = (uint32_t)(textEnd - textBegin);
+                memmove(data + written, textBegin, q.textLength);
+                written += q.textLength;
+                result.records.push_back(q);
+            } else {
+                if (result.badLines.size() < MAX_REPORTED_BAD_LINES) {
+                    result.badLines.push_back(lineNumber);
+                }
+                result.malformed++;
+            }
+        }
+        line = lineEnd + 1;
+    }
+
+    buffer.resize(written);
+    return true;
+}
+
+void report_Qs_file(const string& filename, const char* label, const QsFileResult& result, ostream& log) {
+    if (!result.opened) {
+        log << "Error: Cannot open " << label << " questions file: " << filename << endl;
+        return;
+    }
+    for (size_t line : result.badLines) {
+        log << "Warning: " << filename << ":" << line
+             << ": malformed question line (expected Question|Answer|Penalty)" << endl;
+    }
+    if (result.malformed > result.badLines.size()) {
+        log << "Warning: " << filename << ": " << (result.malformed - result.badLines.size())
+             << " more malformed lines not shown" << endl;
+    }
+    log << "Loaded " << result.records.size() << " " << label << " questions." << endl;
+}
+
+void read_Qs_files(QsFileResult results[3]) {
+    // Parse the three banks in parallel; callers report after the join
+    thread workers[3];
+    for (int i = 0; i < 3; ++i) {
+        workers[i] = thread(read_Qs_file, string(QS_FILES[i]), std::ref(results[i]));
+    }
+    for (int i = 0; i < 3; ++i) {
+        workers[i].join();
+    }
+}
+
+void merge_Qs_files(QsFileResult results[3], vector<QsRecord>& records, string& text, uint32_t counts[3]) {
+    size_t totalText = 0;
+    size_t totalRecords = 0;
+    for (int i = 0; i < 3; ++i) {
+        totalText += results[i].text.size();
+        totalRecords += results[i].records.size();
+    }
+    text.clear();
+    records.clear();
+    text.reserve(totalText);
+    records.reserve(totalRecords);
+
+    // Append each file's text to the single arena and rebase its records
+    for (int i = 0; i < 3; ++i) {
+        uint32_t base = (uint32_t)text.size();
+        text.append(results[i].text);
+        string().swap(results[i].text);
+        for (auto& record : results[i].records) {
+            record.textOffset += base;
+            record.category = QS_CATEGORIES[i];
+            records.push_back(record);
+        }
+        counts[i] = (uint32_t)results[i].records.size();
+    }
+}
+
+bool write_Qs_pack(const string& filename, const QsRecord* records, const uint32_t counts[3],
+                   const char* text, size_t textSize) {
+    QsPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HKQP", 4);
+    header.version = QS_PACK_VERSION;
+    uint64_t total = 0;
+    for (int i = 0; i < 3; ++i) {
+        header.counts[i] = counts[i];
+        total += counts[i];
+    }
+    header.recordsOffset = sizeof(QsPackHeader);
+    header.textOffset = header.recordsOffset + total * sizeof(QsRecord);
+    header.textSize = textSize;
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (file.fail()) {
+        cout << "Error: Cannot create question pack: " << filename << endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (total > 0) {
+        file.write(reinterpret_cast<const char*>(records), total * sizeof(QsRecord));
+    }
+    if (textSize > 0) {
+        file.write(text, textSize);
+    }
+    file.close();
+    if (file.fail()) {
+        cout << "Error: Failed writing question pack: " << filename << endl;
+        return false;
+    }
+    return true;
+}
+
+// Append text as a C string literal, escaping everything outside printable ASCII
+static void append_C_literal(string& out, const char* text, size_t length) {
+    static const char digits[] = "01234567";
+    out += '"';
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c >= 0x20 && c < 0x7f && c != '?') {
+            out += (char)c;
+        } else {
+            // Three-digit octal never swallows a following digit; '?' avoids trigraphs
+            out += '\\';
+            out += digits[(c >> 6) & 7];
+            out += digits[(c >> 3) & 7];
+            out += digits[c & 7];
+        }
+    }
+    out += '"';
+}
+
+bool write_Qs_source(const string& filename, const QsRecord* records, const uint32_t counts[3],
+                     const char* text, size_t textSize) {
+    size_t total = (size_t)counts[0] + counts[1] + counts[2];
+
+    string out;
+    out.reserve(textSize * 2 + total * 64 + 512);
+    out += "// Generated by qpack from the questions_*.txt files. Do not edit.\n";
+    out += "#include \"question.h\"\n\n";
+
+    out += "extern constexpr uint32_t qsBuiltinCounts[3] = {";
+    for (int i = 0; i < 3; ++i) {
+        out += to_string(counts[i]);
+        out += i < 2 ? "u, " : "u};\n\n";
+    }
+
+    // Zero-length arrays are not allowed, so an empty bank still gets one entry
+    out += "extern constexpr QsRecord qsBuiltinRecords[] = {\n";
+    if (total == 0) {
+        out += "    {0u, 0u, 0.0, 65, 84, {0}},\n";
+    }
+    char penalty[64];
+    for (size_t i = 0; i < total; ++i) {
+        const QsRecord& r = records[i];
+        snprintf(penalty, sizeof(penalty), "%.17g", r.basePenalty);
+        out += "    {" + to_string(r.textOffset) + "u, " + to_string(r.textLength) + "u, " + penalty + ", " +
+               to_string((int)r.answer) + ", " + to_string((int)r.category) + ", {0}},\n";
+    }
+    out += "};\n\n";
+
+    // Emit the blob in fixed-size literal pieces so lines stay short
+    const size_t PIECE = 64;
+    out += "extern constexpr char qsBuiltinText[] =\n";
+    if (textSize == 0) {
+        out += "    \"\"";
+    }
+    for (size_t pos = 0; pos < textSize; pos += PIECE) {
+        size_t length = textSize - pos < PIECE ? textSize - pos : PIECE;
+        out += "    ";
+        append_C_literal(out, text + pos, length);
+        if (pos + length < textSize) out += '\n';
+    }
+    out += ";\n\n";
+    out += "extern const size_t qsBuiltinTextSize = " + to_string(textSize) + "u;\n";
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (file.fail()) {
+        cout << "Error: Cannot create source file: " << filename << endl;
+        return false;
+    }
+    file.write(out.data(), out.size());
+    file.close();
+    return !file.fail();
+}
@@ -0,0 +1,140 @@
+#ifndef QUESTION_PACK_H
+#define QUESTION_PACK_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * @brief Fixed-size index record for one question
+ *
+ * The question text itself lives in the shared text arena (qsText);
+ * the record only stores where to find it. The layout is also the
+ * on-disk index entry of a compiled question pack, so it must not change
+ * without bumping QS_PACK_VERSION.
+ *
+ * @param textOffset Byte offset of the question text in qsText
+ * @param textLength Length of the question text in bytes
+ * @param basePenalty The base GPA penalty for incorrect answers
+ * @param answer The correct answer (A, B, C, or D)
+ * @param category Enemy type asking the question ('T', 'F' or 'S')
+ */
+struct QsRecord {
+    uint32_t textOffset;
+    uint32_t textLength;
+    double basePenalty;
+    char answer;
+    char category;
+    char reserved[6];
+};
+
+/**
+ * @brief Header of a compiled question pack
+ *
+ * A pack is the header, then every QsRecord (TA, Professor, Student in
+ * that order), then the text blob. Integers are in host byte order.
+ */
+struct QsPackHeader {
+    char magic[4];          ///< "HKQP"
+    uint32_t version;       ///< QS_PACK_VERSION
+    uint32_t counts[3];     ///< Number of TA, Professor and Student records
+    uint32_t reserved;
+    uint64_t recordsOffset; ///< Byte offset of the first record
+    uint64_t textOffset;    ///< Byte offset of the text blob
+    uint64_t textSize;      ///< Size of the text blob in bytes
+};
+
+const uint32_t QS_PACK_VERSION = 1;
+
+/**
+ * @brief Questions parsed from one file, with their own text buffer
+ *
+ * Record offsets point into text until the records are merged into
+ * the shared arena.
+ */
+struct QsFileResult {
+    string text;              ///< Question text of this file, back to back
+    vector<QsRecord> records; ///< Parsed questions in file order
+    vector<size_t> badLines;  ///< 1-based numbers of malformed lines (first few only)
+    size_t malformed;         ///< Total number of malformed lines
+    bool opened;              ///< False if the file could not be read
+};
+
+// Default question files, their bank labels and record categories
+extern const char* const QS_FILES[3];
+extern const char* const QS_LABELS[3];
+extern const char QS_CATEGORIES[3];
+
+/**
+ * @brief Reads and parses one pipe-delimited question file
+ *
+ * Reads the file in a single pass and parses "Question|Answer|Penalty"
+ * lines in place, compacting the question text into result.text.
+ * Malformed lines are counted and their line numbers recorded.
+ *
+ * @param filename Path to the questions file
+ * @param result Output with the parsed records and text
+ * @return True if the file could be read
+ */
+bool read_Qs_file(const string& filename, QsFileResult& result);
+
+/**
+ * @brief Reads the three default question files in parallel
+ * @param results One result per file, in QS_FILES order
+ */
+void read_Qs_files(QsFileResult results[3]);
+
+/**
+ * @brief Prints the outcome of one file load (errors, malformed lines, count)
+ * @param filename Path of the file that was read
+ * @param label Bank name used in messages
+ * @param result Result returned by read_Qs_file
+ * @param log Where the messages go
+ */
+void report_Qs_file(const string& filename, const char* label, const QsFileResult& result, ostream& log = cout);
+
+/**
+ * @brief Concatenates three parsed files into one record array and text arena
+ *
+ * Record offsets are rebased onto the merged text and categories are set.
+ *
+ * @param results Parsed files in QS_FILES order (their text is consumed)
+ * @param records Output TA, Professor and Student records back to back
+ * @param text Output merged text arena
+ * @param counts Output number of records of each category
+ */
+void merge_Qs_files(QsFileResult results[3], vector<QsRecord>& records, string& text, uint32_t counts[3]);
+
+/**
+ * @brief Writes question records and their text as a compiled pack
+ * @param filename Path of the pack file to create
+ * @param records TA, Professor and Student records back to back
+ * @param counts Number of records of each category
+ * @param text Text blob the record offsets refer to
+ * @param textSize Size of the text blob in bytes
+ * @return True if the pack was written
+ */
+bool write_Qs_pack(const string& filename, const QsRecord* records, const uint32_t counts[3],
+                   const char* text, size_t textSize);
+
+/**
+ * @brief Writes question records and their text as a C++ source file
+ *
+ * The generated file defines qsBuiltinCounts, qsBuiltinRecords,
+ * qsBuiltinText and qsBuiltinTextSize as constant data, so the bank can
+ * be linked into the game.
+ *
+ * @param filename Path of the source file to create
+ * @param records TA, Professor and Student records back to back
+ * @param counts Number of records of each category
+ * @param text Text blob the record offsets refer to
+ * @param textSize Size of the text blob in bytes
+ * @return True if the file was written
+ */
+bool write_Qs_source(const string& filename, const QsRecord* records, const uint32_t counts[3],
+                     const char* text, size_t textSize);
+
+#endif
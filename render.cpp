@@ -0,0 +1,188 @@
+#include "render.h"
+#include "map.h"
+#include "input.h"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+// Terminal lines used by the status lines above the map and the help line below it
+static const int CHROME_LINES = 4;
+
+FrameRenderer::FrameRenderer()
+    : backIndex(0), frontIndex(2), middle(1), published(0),
+      running(false), paused(false), drawing(false), fullRedraw(true),
+      framesPerSecond(20), consumed(0) {}
+
+FrameRenderer::~FrameRenderer() {
+    stop();
+}
+
+void FrameRenderer::start(int fps) {
+    stop();
+    framesPerSecond = fps > 0 ? fps : 20;
+    running = true;
+    paused = false;
+    fullRedraw = true;
+    drawStats = FrameStats();
+    consumed = 0;
+    published = 0;
+    middle = 1;
+    backIndex = 0;
+    frontIndex = 2;
+    cout.flush();
+    worker = thread(&FrameRenderer::run, this);
+}
+
+void FrameRenderer::stop() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void FrameRenderer::publish() {
+    slots[backIndex].sequence = ++published;
+    int previous = middle.exchange(backIndex | FRESH);
+    backIndex = previous & ~FRESH;
+}
+
+void FrameRenderer::pause() {
+    unique_lock<mutex> lock(stateMutex);
+    paused = true;
+    wake.wait(lock, [this] { return !drawing; });
+}
+
+void FrameRenderer::resume() {
+    cout.flush();
+    {
+        lock_guard<mutex> lock(stateMutex);
+        paused = false;
+        fullRedraw = true;
+    }
+    wake.notify_all();
+}
+
+// Wake once per frame period and draw the newest snapshot, if there is one
+void FrameRenderer::run() {
+    typedef chrono::steady_clock Clock;
+    const Clock::duration period = chrono::duration_cast<Clock::duration>(
+        chrono::duration<double>(1.0 / framesPerSecond));
+    Clock::time_point next = Clock::now();
+    bool haveFrame = false;
+
+    unique_lock<mutex> lock(stateMutex);
+    while (running) {
+        wake.wait_until(lock, next, [this] { return !running; });
+        wake.wait(lock, [this] { return !running || !paused; });
+        if (!running) break;
+
+        Clock::time_point now = Clock::now();
+        next += period;
+        if (next < now) next = now + period;
+
+        // Take the latest published frame; anything published before it is gone
+        if (middle.load() & FRESH) {
+            int previous = middle.exchange(frontIndex);
+            frontIndex = previous & ~FRESH;
+            ++consumed;
+            haveFrame = true;
+        } else if (!fullRedraw) {
+            continue; // Nothing new to show
+        }
+        if (!haveFrame) continue;
+
+        drawing = true;
+        lock.unlock();
+        Clock::time_point start = Clock::now();
+        draw(slots[frontIndex]);
+        drawStats.add(chrono::duration<double, milli>(Clock::now() - start).count());
+        lock.lock();
+        drawing = false;
+        wake.notify_all();
+    }
+}
+
+// Write all bytes, retrying after interrupts and partial writes
+static void write_all(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+}
+
+void FrameRenderer::draw(const FrameSnapshot& frame) {
+    int termRows = 24;
+    int termCols = 80;
+    input_terminal_size(termRows, termCols);
+
+    int viewRows = termRows - CHROME_LINES;
+    int viewCols = termCols;
+    int top, left;
+    map_view_origin(*frame.world, frame.playerRow, frame.playerCol, viewRows, viewCols, top, left);
+
+    mapText.resize(map_view_buffer_size(viewRows, viewCols));
+    overlay.resize((size_t)viewRows * viewCols);
+    char* mapEnd = encode_map_view(*frame.world, mapText.data(), overlay.data(), frame.playerRow, frame.playerCol,
+                                   frame.enemies.data(), (int)frame.enemies.size(),
+                                   top, left, viewRows, viewCols);
+
+    // Build this frame's lines in place, reusing last frame's string capacity
+    size_t lineCount = 2 + (size_t)viewRows + 1;
+    vector<string>& lines = frameLines;
+    lines.resize(lineCount);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "Level %d | %s | GPA: %g | Enemies: %zu",
+             frame.level, frame.difficulty.c_str(), frame.gpa, frame.enemyTotal);
+    lines[0] = buffer;
+    snprintf(buffer, sizeof(buffer),
+             "Tick %lu @ %d Hz: %.3f ms avg, %.3f ms max | Frame %.3f ms avg | Dropped %lu",
+             frame.ticks, frame.tickRate, frame.tickAvgMs, frame.tickMaxMs,
+             drawStats.averageMs(), frame.droppedTicks);
+    lines[1] = buffer;
+    const char* p = mapText.data();
+    for (int r = 0; r < viewRows; ++r) {
+        const char* eol = p;
+        while (eol < mapEnd && *eol != '\n') ++eol;
+        lines[2 + r].assign(p, eol - p);
+        p = eol + 1;
+    }
+    lines[lineCount - 1] = "W/A/S/D or arrows to move, P to save";
+
+    // Rewrite only the lines that differ from what is on screen
+    output.clear();
+    bool full;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        full = fullRedraw;
+        fullRedraw = false;
+    }
+    if (full || lastLines.size() != lineCount) {
+        output += "\033[H\033[2J";
+        lastLines.assign(lineCount, string());
+        full = true;
+    }
+    for (size_t i = 0; i < lineCount; ++i) {
+        if (!full && lines[i] == lastLines[i]) continue;
+        snprintf(buffer, sizeof(buffer), "\033[%zu;1H", i + 1);
+        output += buffer;
+        output += lines[i];
+        output += "\033[K";
+        lastLines[i].swap(lines[i]);
+    }
+    snprintf(buffer, sizeof(buffer), "\033[%zu;1H", lineCount);
+    output += buffer;
+    write_all(output.data(), output.size());
+}
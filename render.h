@@ -0,0 +1,154 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "save.h"
+
+using namespace std;
+
+/**
+ * @brief Running timing statistics of one part of the real-time loop
+ */
+struct FrameStats {
+    unsigned long count; ///< Number of samples
+    double totalMs;      ///< Sum of all samples in milliseconds
+    double maxMs;        ///< Longest sample in milliseconds
+
+    FrameStats() : count(0), totalMs(0.0), maxMs(0.0) {}
+
+    void add(double ms) {
+        ++count;
+        totalMs += ms;
+        if (ms > maxMs) maxMs = ms;
+    }
+
+    double averageMs() const { return count > 0 ? totalMs / count : 0.0; }
+};
+
+/**
+ * @brief Everything the render thread needs to draw one frame
+ *
+ * Filled by the game thread and never touched by it again once
+ * published. Map tiles are not copied but read from the session's
+ * world: the map does not change while a level is being played, and the
+ * renderer is stopped before the next level is loaded.
+ */
+struct FrameSnapshot {
+    unsigned long sequence;   ///< Publication number, starting at 1
+    const World* world;       ///< Session whose map is drawn
+    int level;                ///< Current level
+    double gpa;               ///< Player's GPA
+    string difficulty;        ///< Difficulty name (capacity is reused)
+    int playerRow;            ///< Player position
+    int playerCol;
+    vector<Entity> enemies;   ///< Active enemies only (capacity is reused)
+    size_t enemyTotal;        ///< All enemies of the level, active or not
+    int tickRate;             ///< Simulation rate in ticks per second
+    unsigned long ticks;      ///< Ticks simulated so far
+    double tickAvgMs;         ///< Average tick time
+    double tickMaxMs;         ///< Longest tick time
+    unsigned long droppedTicks; ///< Ticks skipped because the simulation fell behind
+};
+
+/**
+ * @brief Draws real-time frames on a dedicated thread
+ *
+ * The game thread fills back(), calls publish() and carries on; it
+ * never waits for the terminal. Snapshots travel through a triple
+ * buffer: the game thread owns one slot, the render thread owns one,
+ * and the third holds the latest published frame. Publishing again
+ * before the renderer took that frame replaces it, so stale frames are
+ * dropped rather than queued.
+ *
+ * The render thread wakes at a fixed frame rate, encodes the newest
+ * snapshot and rewrites only the terminal lines that changed since the
+ * previous frame.
+ */
+class FrameRenderer {
+private:
+    static const int FRESH = 4; ///< Set in middle when it holds an unread frame
+
+    FrameSnapshot slots[3];
+    int backIndex;              ///< Slot the game thread fills (game thread only)
+    int frontIndex;             ///< Slot being drawn (render thread only)
+    atomic<int> middle;         ///< Latest published slot, plus FRESH
+    atomic<unsigned long> published;
+
+    thread worker;
+    mutex stateMutex;
+    condition_variable wake;
+    bool running;
+    bool paused;
+    bool drawing;
+    bool fullRedraw;
+    int framesPerSecond;
+
+    // Owned by the render thread while it runs
+    vector<char> mapText;
+    vector<char> overlay;
+    vector<string> frameLines;
+    vector<string> lastLines;
+    string output;
+    FrameStats drawStats;
+    unsigned long consumed;
+
+    void run();
+    void draw(const FrameSnapshot& frame);
+
+public:
+    FrameRenderer();
+    ~FrameRenderer();
+
+    FrameRenderer(const FrameRenderer&) = delete;
+    FrameRenderer& operator=(const FrameRenderer&) = delete;
+
+    /**
+     * @brief Starts the render thread with a cleared screen
+     * @param fps Frames drawn per second
+     */
+    void start(int fps);
+
+    /**
+     * @brief Stops the render thread after the frame it is drawing
+     */
+    void stop();
+
+    /**
+     * @brief Snapshot slot the game thread may fill before publish()
+     */
+    FrameSnapshot& back() { return slots[backIndex]; }
+
+    /**
+     * @brief Hands the filled back() slot to the renderer without waiting
+     */
+    void publish();
+
+    /**
+     * @brief Stops drawing so the game thread can write to the terminal
+     *
+     * Returns once any frame being written is complete.
+     */
+    void pause();
+
+    /**
+     * @brief Resumes drawing; the next frame redraws the whole screen
+     */
+    void resume();
+
+    /**
+     * @brief Time spent encoding and writing frames (valid after stop())
+     */
+    const FrameStats& stats() const { return drawStats; }
+
+    /**
+     * @brief Published frames that were replaced before being drawn (valid after stop())
+     */
+    unsigned long superseded() const { return published.load() - consumed; }
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "rng.h"
+
+// splitmix64: each output is a full avalanche of a counter advanced by a constant
+static uint64_t splitmix64(uint64_t& state) {
+    uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void game_srand(RandomStream& rng, uint64_t seed) {
+    // Hash the seed so consecutive seeds start far apart in the sequence
+    rng.state = seed;
+    rng.state = splitmix64(rng.state);
+}
+
+int game_rand(RandomStream& rng) {
+    return (int)(splitmix64(rng.state) >> 33);
+}
@@ -0,0 +1,37 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/**
+ * @brief A random number stream owned by one game session
+ *
+ * Map generation and enemy movement draw from the session's stream
+ * instead of rand(), whose state is shared by the whole process, so
+ * concurrent games never disturb each other and a game replays exactly
+ * from its seed. The whole state is one splitmix64 counter.
+ *
+ * Each session keeps separate streams for separate purposes (the world's
+ * stream for the map and enemy moves, another for headless answers),
+ * seeded from different values: two streams seeded alike produce the
+ * same draws, which would tie one kind of outcome to the other.
+ */
+struct RandomStream {
+    uint64_t state;
+};
+
+/**
+ * @brief Seeds a random stream
+ * @param rng Stream to reset
+ * @param seed Any value; nearby seeds still give unrelated streams
+ */
+void game_srand(RandomStream& rng, uint64_t seed);
+
+/**
+ * @brief Next number of a random stream
+ * @param rng Stream to advance
+ * @return Uniform value in [0, 2^31)
+ */
+int game_rand(RandomStream& rng);
+
+#endif
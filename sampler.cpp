@@ -0,0 +1,60 @@
+#include "sampler.h"
+
+// splitmix64 finalizer, used as the Feistel round function and key schedule
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Balanced 4-round Feistel network: a bijection on [0, 2^(2*halfBits))
+static uint64_t feistel(uint64_t value, uint64_t key, unsigned halfBits) {
+    uint64_t mask = (1ULL << halfBits) - 1;
+    uint64_t left = value >> halfBits;
+    uint64_t right = value & mask;
+    for (uint64_t round = 0; round < 4; ++round) {
+        uint64_t next = left ^ (mix64(key ^ (round << 56) ^ right) & mask);
+        left = right;
+        right = next;
+    }
+    return (left << halfBits) | right;
+}
+
+void sampler_init(QsSampler& sampler, uint64_t seed) {
+    sampler.key = mix64(seed);
+    sampler.cycle = 0;
+    sampler.position = 0;
+    sampler.size = 0;
+}
+
+uint32_t sampler_next(QsSampler& sampler, uint32_t bankSize) {
+    // A resized bank (hot reload) also starts a new cycle: the old key would
+    // replay the questions just asked. A fresh sampler keeps its first key.
+    bool resized = sampler.size != 0 && sampler.size != bankSize;
+    sampler.size = bankSize;
+    if (resized || sampler.position >= sampler.size) {
+        // Cycle exhausted: derive the next permutation's key
+        sampler.cycle++;
+        sampler.key = mix64(sampler.key ^ sampler.cycle);
+        sampler.position = 0;
+    }
+
+    // Smallest even bit width covering the bank, so at most 4x the bank size
+    unsigned bits = 2;
+    while (bits < 64 && (1ULL << bits) < bankSize) {
+        bits += 2;
+    }
+
+    // Cycle-walking keeps the permutation inside [0, bankSize)
+    uint64_t value = sampler.position++;
+    do {
+        value = feistel(value, sampler.key, bits / 2);
+    } while (value >= bankSize);
+    return (uint32_t)value;
+}
+
+uint32_t sampler_peek(const QsSampler& sampler, uint32_t bankSize) {
+    QsSampler copy = sampler;
+    return sampler_next(copy, bankSize);
+}
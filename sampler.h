@@ -0,0 +1,54 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+
+/**
+ * @brief Sampling-without-replacement state for one question bank
+ *
+ * Draws walk a pseudo-random permutation of [0, size) that is computed on
+ * the fly from the key, so every question is asked at most once per cycle
+ * without shuffling or storing the bank. The whole state is these four
+ * numbers, which is what the save file records.
+ *
+ * @param key Key of the current cycle's permutation
+ * @param cycle Number of completed passes over the bank
+ * @param position Draws taken in the current cycle
+ * @param size Bank size the permutation covers
+ */
+struct QsSampler {
+    uint64_t key;
+    uint32_t cycle;
+    uint32_t position;
+    uint32_t size;
+};
+
+/**
+ * @brief Starts a fresh sampler
+ * @param sampler Sampler to initialize
+ * @param seed Random seed for the first cycle
+ */
+void sampler_init(QsSampler& sampler, uint64_t seed);
+
+/**
+ * @brief Draws the next question index in O(1) expected time
+ *
+ * When the cycle is exhausted a new permutation is started. If the bank
+ * size changed (e.g. after a hot reload) a new cycle starts with a fresh
+ * key, so the questions just asked are not replayed in the same order.
+ *
+ * @param sampler Sampler state, advanced by one draw
+ * @param bankSize Number of questions in the bank (must be > 0)
+ * @return Index in [0, bankSize)
+ */
+uint32_t sampler_next(QsSampler& sampler, uint32_t bankSize);
+
+/**
+ * @brief The index the next sampler_next() call will return, without drawing it
+ * @param sampler Sampler state, left unchanged
+ * @param bankSize Number of questions in the bank (must be > 0)
+ * @return Index in [0, bankSize)
+ */
+uint32_t sampler_peek(const QsSampler& sampler, uint32_t bankSize);
+
+#endif
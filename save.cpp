@@ -1,16 +1,35 @@
 #include "save.h"
+#include "entity.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <cstring>
+#include <cerrno>
 #include <limits>  // Added for numeric_limits
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
-// External map data variables (need to be declared in your main program)
-extern int map_rows;
-extern int map_cols; 
-extern char** map_data;
-extern void free_map();  // Function to free existing map memory
+static_assert(sizeof(SaveEntityRecord) == 36, "SaveEntityRecord is part of the save file layout");
+static_assert(sizeof(SaveSamplerRecord) == 24, "SaveSamplerRecord is part of the save file layout");
+static_assert(sizeof(SaveHeader) % 8 == 0, "SaveHeader keeps the records after it aligned");
+
+static const char* const SAVE_FILE = "hku_gpa_escape_save.bin";
+
+// Written in full and synced before it is renamed over SAVE_FILE
+static const char* const SAVE_TEMP_FILE = "hku_gpa_escape_save.bin.tmp";
+
+// Saves written before the binary format; still loaded when no binary save exists
+static const char* const TEXT_SAVE_FILE = "hku_gpa_escape_save.txt";
+
+// Largest map side a save may declare; anything bigger is treated as corrupt
+static const int32_t MAX_SAVED_MAP_SIDE = 10000;
+
+// Map functions from the map module
+extern void allocate_map(World& world, int rows, int cols);  // Allocates map cells from the level arena
 
 GameDifficultySettings easy() {
     GameDifficultySettings diff;
@@ -42,51 +61,296 @@ GameDifficultySettings hard() {
     return diff;
 }
 
-bool saveGame(int level, double gpa, const Entity& player,
-              const vector<Entity>& enemies, const GameDifficultySettings& diff) {
+// CRC-32 lookup tables for eight bytes at a time (slicing-by-8)
+struct Crc32Tables {
+    uint32_t table[8][256];
     
-    string filename = "hku_gpa_escape_save.txt";
-    ofstream file(filename);
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+uint32_t save_crc32(const void* data, size_t size, uint32_t crc) {
+    static const Crc32Tables tables;
+    const uint32_t (*t)[256] = tables.table;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
     
-    if (file.fail()) {
-        cout << "Error: Cannot create save file: " << filename << endl;
-        return false;
+    // Eight bytes per step; the byte loop handles the rest (little-endian word order)
+    while (size >= 8) {
+        uint32_t low = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        uint32_t high = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    }
+    return ~crc;
+}
+
+// Copy every Entity field into its on-disk record
+static void pack_entity(const Entity& entity, SaveEntityRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.x = entity.x;
+    record.y = entity.y;
+    record.id = entity.id;
+    record.chaseProbability = entity.chaseProbability;
+    record.detectionRange = entity.detectionRange;
+    record.movementStrategy = entity.movementStrategy;
+    record.predictiveTracking = entity.predictiveTracking;
+    record.distractionFactor = entity.distractionFactor;
+    record.type = entity.type;
+    record.active = entity.active ? 1 : 0;
+}
+
+static void unpack_entity(const SaveEntityRecord& record, Entity& entity) {
+    entity.x = record.x;
+    entity.y = record.y;
+    entity.id = record.id;
+    entity.chaseProbability = record.chaseProbability;
+    entity.detectionRange = record.detectionRange;
+    entity.movementStrategy = record.movementStrategy;
+    entity.predictiveTracking = record.predictiveTracking;
+    entity.distractionFactor = record.distractionFactor;
+    entity.type = record.type;
+    entity.active = record.active != 0;
+}
+
+// Write the whole buffer, continuing after partial writes and signals
+static bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+// LEB128 varint of a run length; returns the bytes written (at most 5)
+static size_t put_varint(uint32_t value, char* out) {
+    size_t n = 0;
+    do {
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        if (value != 0) byte |= 0x80;
+        out[n++] = (char)byte;
+    } while (value != 0);
+    return n;
+}
+
+// Run-length encode the map plane into out, row by row (see SaveHeader);
+// returns the encoded size, or 0 if it would not fit in limit bytes
+static size_t encode_map_rle(const char* cells, int rows, int cols, char* out, size_t limit) {
+    size_t size = 0;
+    char run[6];
+    for (int r = 0; r < rows; ++r) {
+        const char* row = cells + (size_t)r * cols;
+        int c = 0;
+        while (c < cols) {
+            int start = c;
+            while (c < cols && row[c] == row[start]) ++c;
+            size_t n = put_varint((uint32_t)(c - start), run);
+            run[n++] = row[start];
+            if (size + n > limit) return 0;
+            memcpy(out + size, run, n);
+            size += n;
+        }
+    }
+    return size;
+}
+
+// Decode a run-length encoded map plane into the given rows, or only check it
+// when rowsOut is null; false unless the runs fill every row exactly
+static bool decode_map_rle(const char* in, size_t size, int rows, int cols, char** rowsOut) {
+    const char* end = in + size;
+    for (int r = 0; r < rows; ++r) {
+        int c = 0;
+        while (c < cols) {
+            uint32_t run = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (in == end || shift > 28) return false;
+                unsigned char byte = (unsigned char)*in++;
+                run |= (uint32_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) break;
+            }
+            if (in == end || run == 0 || run > (uint32_t)(cols - c)) return false;
+            char tile = *in++;
+            if (rowsOut != nullptr) memset(rowsOut[r] + c, tile, run);
+            c += (int)run;
+        }
+    }
+    return in == end;
+}
+
+// Largest size of the save image of a snapshot: header, records, raw map plane and CRC
+static size_t save_image_size(const SaveSnapshot& snapshot) {
+    return sizeof(SaveHeader) + (1 + snapshot.enemies.size()) * sizeof(SaveEntityRecord) +
+           snapshot.cells.size() + sizeof(uint32_t);
+}
+
+void snapshot_game(const World& world, int level, double gpa, const Entity& player,
+                   const vector<Entity>& enemies, const GameDifficultySettings& diff,
+                   const QsSampler samplers[3], SaveSnapshot& snapshot) {
+    snapshot.level = level;
+    snapshot.gpa = gpa;
+    snapshot.difficulty = diff.name == "EASY" ? 1 : (diff.name == "HARD" ? 3 : 2);
+    snapshot.player = player;
+    snapshot.enemies.assign(enemies.begin(), enemies.end());
+    for (int i = 0; i < 3; ++i) {
+        snapshot.samplers[i] = samplers[i];
+    }
+    snapshot.rows = world.map_data != nullptr ? world.map_rows : 0;
+    snapshot.cols = world.map_data != nullptr ? world.map_cols : 0;
+    snapshot.cells.resize((size_t)snapshot.rows * snapshot.cols);
+    for (int r = 0; r < snapshot.rows; ++r) {
+        memcpy(&snapshot.cells[(size_t)r * snapshot.cols], world.map_data[r], snapshot.cols);
     }
     
-    // Save game metadata
-    file << "LEVEL " << level << endl;
-    file << "GPA " << gpa << endl;
-    file << "DIFFICULTY " << diff.name << endl;
-    file << "PLAYER " << player.x << " " << player.y << " " << player.type << " " << player.active << " " << player.id << endl;
+    // Sized here so the writer serializes without allocating
+    snapshot.image.reserve(save_image_size(snapshot));
+}
+
+// Lay out the save image of a snapshot in snapshot.image
+static void serialize_snapshot(SaveSnapshot& snapshot) {
+    SaveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HKSV", 4);
+    header.version = SAVE_VERSION;
+    header.headerSize = sizeof(SaveHeader);
+    header.journalId = snapshot.journalId;
+    header.level = snapshot.level;
+    header.difficulty = snapshot.difficulty;
+    header.gpa = snapshot.gpa;
+    header.rows = snapshot.rows;
+    header.cols = snapshot.cols;
+    header.enemyCount = (uint32_t)snapshot.enemies.size();
+    for (int i = 0; i < 3; ++i) {
+        header.samplers[i].key = snapshot.samplers[i].key;
+        header.samplers[i].cycle = snapshot.samplers[i].cycle;
+        header.samplers[i].position = snapshot.samplers[i].position;
+        header.samplers[i].size = snapshot.samplers[i].size;
+    }
     
-    // Save enemy data with count
-    file << "ENEMIES " << enemies.size() << endl;
-    for (const auto& enemy : enemies) {
-        file << enemy.type << " " << enemy.x << " " << enemy.y << " " << enemy.active << " " << enemy.id << endl;
+    // Sized for a raw map plane, which the encoded one never exceeds
+    size_t total = save_image_size(snapshot);
+    snapshot.image.resize(total);
+    char* out = snapshot.image.data() + sizeof(header);
+    
+    SaveEntityRecord record;
+    pack_entity(snapshot.player, record);
+    memcpy(out, &record, sizeof(record));
+    out += sizeof(record);
+    for (const auto& enemy : snapshot.enemies) {
+        pack_entity(enemy, record);
+        memcpy(out, &record, sizeof(record));
+        out += sizeof(record);
     }
     
-    // Save map data to preserve layout
-    file << "MAP " << map_rows << " " << map_cols << endl;
-    for (int r = 0; r < map_rows; ++r) {
-        for (int c = 0; c < map_cols; ++c) {
-            file << map_data[r][c]; // Write each map cell
-        }
-        file << '\n'; // Newline after each row
+    // Mostly-empty maps shrink to a few runs per row; noisy ones are stored raw
+    size_t mapSize = encode_map_rle(snapshot.cells.data(), snapshot.rows, snapshot.cols, out, snapshot.cells.size() - 1);
+    if (mapSize != 0) {
+        header.flags = SAVE_MAP_RLE;
+    } else {
+        mapSize = snapshot.cells.size();
+        memcpy(out, snapshot.cells.data(), mapSize);
     }
+    out += mapSize;
+    header.mapSize = (uint32_t)mapSize;
+    memcpy(snapshot.image.data(), &header, sizeof(header));
     
-    file.close();
-    cout << "Game saved successfully to " << filename << endl;
+    total = (size_t)(out - snapshot.image.data()) + sizeof(uint32_t);
+    snapshot.image.resize(total);
+    uint32_t crc = save_crc32(snapshot.image.data(), total - sizeof(uint32_t));
+    memcpy(snapshot.image.data() + total - sizeof(uint32_t), &crc, sizeof(crc));
+}
+
+bool commit_file(const char* path, const char* tempPath, const char* data, size_t size, string& error) {
+    // Write a temporary file and rename it over the target, so a crash or a
+    // full disk leaves either the old file or the new one, never half of one.
+    // Only failures build strings: a save must not touch the heap while the
+    // game thread checks that its turns do not.
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = string("cannot create ") + tempPath + ": " + strerror(errno);
+        return false;
+    }
+    bool written = write_all(fd, data, size) && fsync(fd) == 0;
+    if (!written) {
+        error = string("cannot write ") + tempPath + ": " + strerror(errno);
+    }
+    if (close(fd) != 0 && written) {
+        error = string("cannot write ") + tempPath + ": " + strerror(errno);
+        written = false;
+    }
+    if (!written) {
+        unlink(tempPath);
+        return false;
+    }
+    if (rename(tempPath, path) != 0) {
+        error = string("cannot replace ") + path + ": " + strerror(errno);
+        unlink(tempPath);
+        return false;
+    }
+    
+    // Make the rename itself durable
+    int dir = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+    return true;
+}
+
+bool write_snapshot(SaveSnapshot& snapshot, string& error) {
+    if (snapshot.cells.empty()) {
+        error = "no level to save";
+        return false;
+    }
+    serialize_snapshot(snapshot);
+    return commit_file(SAVE_FILE, SAVE_TEMP_FILE, snapshot.image.data(), snapshot.image.size(), error);
+}
+
+bool saveGame(const World& world, int level, double gpa, const Entity& player,
+              const vector<Entity>& enemies, const GameDifficultySettings& diff,
+              const QsSampler samplers[3]) {
+    SaveSnapshot snapshot;
+    snapshot_game(world, level, gpa, player, enemies, diff, samplers, snapshot);
+    string error;
+    if (!write_snapshot(snapshot, error)) {
+        cout << "Error: Save failed: " << error << endl;
+        return false;
+    }
+    cout << "Game saved successfully to " << SAVE_FILE << endl;
     return true;
 }
 
-bool loadGame(int& level, double& gpa, Entity& player,
-    vector<Entity>& enemies, GameDifficultySettings& diff) {
+// Read a text save of older versions; enemies get the default behaviors of the level
+static bool load_text_save(World& world, int& level, double& gpa, Entity& player,
+    vector<Entity>& enemies, GameDifficultySettings& diff, QsSampler samplers[3], ostream& log) {
     
-    string filename = "hku_gpa_escape_save.txt";
+    string filename = TEXT_SAVE_FILE;
     ifstream file(filename);
 
     if (!file.is_open()) {
-        cout << "Error: Cannot open save file: " << filename << endl;
+        log << "Error: Cannot open save file: " << filename << endl;
         return false;
     }
 
@@ -104,19 +368,19 @@ bool loadGame(int& level, double& gpa, Entity& player,
         iss >> token; // Get the first token to identify data type
 
         if (token == "LEVEL") {
-            if (!(iss >> level)) {
-                cout << "Error reading level" << endl;
+            if (!(iss >> level) || level < 1 || level > 3) {
+                log << "Error reading level" << endl;
                 success = false;
             }
         } else if (token == "GPA") {
             if (!(iss >> gpa)) {
-                cout << "Error reading GPA" << endl;
+                log << "Error reading GPA" << endl;
                 success = false;
             }
         } else if (token == "DIFFICULTY") {
             string diffName;
             if (!(iss >> diffName)) {
-                cout << "Error reading difficulty" << endl;
+                log << "Error reading difficulty" << endl;
                 success = false;
             } else {
                 // Set difficulty based on saved name
@@ -132,19 +396,19 @@ bool loadGame(int& level, double& gpa, Entity& player,
             }
         } else if (token == "PLAYER") {
             if (!(iss >> player.x >> player.y >> player.type >> player.active >> player.id)) {
-                cout << "Error reading player data" << endl;
+                log << "Error reading player data" << endl;
                 success = false;
             }
         } else if (token == "ENEMIES") {
             int enemyCount;
             if (!(iss >> enemyCount)) {
-                cout << "Error reading enemy count" << endl;
+                log << "Error reading enemy count" << endl;
                 success = false;
             } else {
                 // Read each enemy entry
                 for (int i = 0; i < enemyCount && success; i++) {
                     if (!getline(file, line)) {
-                        cout << "Error: Expected " << enemyCount << " enemies but got only " << i << endl;
+                        log << "Error: Expected " << enemyCount << " enemies but got only " << i << endl;
                         success = false;
                     } else if (!line.empty()) {
                         istringstream enemyIss(line);
@@ -152,7 +416,7 @@ bool loadGame(int& level, double& gpa, Entity& player,
                         if (enemyIss >> enemy.type >> enemy.x >> enemy.y >> enemy.active >> enemy.id) {
                             enemies.push_back(enemy);
                         } else {
-                            cout << "Error reading enemy data: '" << line << "'" << endl;
+                            log << "Error reading enemy data: '" << line << "'" << endl;
                             success = false;
                         }
                     } else {
@@ -160,37 +424,40 @@ bool loadGame(int& level, double& gpa, Entity& player,
                     }
                 }
             }
+        } else if (token == "SAMPLER") {
+            char type;
+            QsSampler sampler;
+            if (!(iss >> type >> sampler.key >> sampler.cycle >> sampler.position >> sampler.size)) {
+                log << "Error reading question sampler" << endl;
+                success = false;
+            } else if (type == 'T') {
+                samplers[0] = sampler;
+            } else if (type == 'F') {
+                samplers[1] = sampler;
+            } else if (type == 'S') {
+                samplers[2] = sampler;
+            }
         } else if (token == "MAP") {
             int rows, cols;
             if (!(iss >> rows >> cols)) {
-                cout << "Error reading map dimensions" << endl;
+                log << "Error reading map dimensions" << endl;
                 success = false;
             } else {
-                // Clear the old map before loading new one
-                free_map();
-                
-                // Set new dimensions
-                map_rows = rows;
-                map_cols = cols;
-                
-                // Allocate new map memory
-                map_data = new char*[map_rows];
-                for (int r = 0; r < map_rows; ++r) {
-                    map_data[r] = new char[map_cols];
-                }
+                // Release the old level and allocate the new map in the level arena
+                allocate_map(world, rows, cols);
                 
                 // Read map data
                 
-                for (int r = 0; r < map_rows && success; ++r) {
+                for (int r = 0; r < world.map_rows && success; ++r) {
                     if (!getline(file, line)) {
-                        cout << "Error reading map row " << r << endl;
+                        log << "Error reading map row " << r << endl;
                         success = false;
                     } else {
-                        for (int c = 0; c < map_cols; ++c) {
+                        for (int c = 0; c < world.map_cols; ++c) {
                             if (c < (int)line.size()) {
-                                map_data[r][c] = line[c];
+                                world.map_data[r][c] = line[c];
                             } else {
-                                map_data[r][c] = '.'; // Default to empty space
+                                world.map_data[r][c] = '.'; // Default to empty space
                             }
                         }
                     }
@@ -202,15 +469,152 @@ bool loadGame(int& level, double& gpa, Entity& player,
 
     file.close();
 
+    // Entities off the map would be read outside it during play
+    if (success && mapLoaded) {
+        bool onMap = player.x >= 0 && player.x < world.map_cols && player.y >= 0 && player.y < world.map_rows;
+        for (const Entity& enemy : enemies) {
+            if (enemy.x < 0 || enemy.x >= world.map_cols || enemy.y < 0 || enemy.y >= world.map_rows) onMap = false;
+        }
+        if (!onMap) {
+            log << "Error: Entity position outside the map in save file" << endl;
+            success = false;
+        }
+    }
+
     // Verify successful loading of all required components
     if (success && mapLoaded) {
-        cout << "Game loaded successfully from " << filename << endl;
+        // Text saves hold no behavior modifiers: use the level's defaults, numbered per type
+        int difficultyLevel = diff.name == "EASY" ? 1 : (diff.name == "HARD" ? 3 : 2);
+        int typeIndex[3] = {0, 0, 0};
+        for (Entity& enemy : enemies) {
+            int bank = enemy.type == 'T' ? 0 : (enemy.type == 'F' ? 1 : 2);
+            initEnemyBehavior(enemy, difficultyLevel, level, typeIndex[bank]++);
+        }
+        log << "Game loaded successfully from " << filename << endl;
         return true;
     } else {
         if (!mapLoaded) {
-            cout << "Error: Map data not found in save file" << endl;
+            log << "Error: Map data not found in save file" << endl;
+        }
+        log << "Failed to load game" << endl;
+        return false;
+    }
+}
+
+bool loadGame(World& world, int& level, double& gpa, Entity& player,
+    vector<Entity>& enemies, GameDifficultySettings& diff, QsSampler samplers[3], uint64_t& journalId,
+    ostream& log) {
+    
+    journalId = 0;
+    string filename = SAVE_FILE;
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT && access(TEXT_SAVE_FILE, F_OK) == 0) {
+            return load_text_save(world, level, gpa, player, enemies, diff, samplers, log);
         }
-        cout << "Failed to load game" << endl;
+        log << "Error: Cannot open save file: " << filename << endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SAVE_HEADER_V1_SIZE + sizeof(SaveEntityRecord) + sizeof(uint32_t)) {
+        close(fd);
+        log << "Error: Save file is truncated: " << filename << endl;
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        log << "Error: Cannot map save file: " << filename << endl;
+        return false;
+    }
+    
+    // Check the layout and the checksum before restoring anything; version 1
+    // headers are shorter and leave journalId at 0, and only version 3 may
+    // run-length encode the map
+    const char* base = static_cast<const char*>(mapped);
+    SaveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, base, SAVE_HEADER_V1_SIZE);
+    uint32_t headerSize = header.version == 1 ? SAVE_HEADER_V1_SIZE : (uint32_t)sizeof(SaveHeader);
+    if (header.version != 1 && size >= sizeof(SaveHeader)) {
+        memcpy(&header, base, sizeof(header));
+    }
+    bool rle = (header.flags & SAVE_MAP_RLE) != 0;
+    bool valid = memcmp(header.magic, "HKSV", 4) == 0 &&
+                 header.version >= 1 && header.version <= SAVE_VERSION &&
+                 header.headerSize == headerSize &&
+                 (header.flags & ~SAVE_MAP_RLE) == 0 &&
+                 (header.version >= 3 || header.flags == 0) &&
+                 header.rows > 0 && header.rows <= MAX_SAVED_MAP_SIDE &&
+                 header.cols > 0 && header.cols <= MAX_SAVED_MAP_SIDE &&
+                 (rle || header.mapSize == (uint32_t)header.rows * (uint32_t)header.cols) &&
+                 size == headerSize + ((size_t)header.enemyCount + 1) * sizeof(SaveEntityRecord) +
+                         header.mapSize + sizeof(uint32_t);
+    if (!valid) {
+        munmap(mapped, size);
+        log << "Error: Invalid or outdated save file: " << filename << endl;
+        return false;
+    }
+    uint32_t storedCrc;
+    memcpy(&storedCrc, base + size - sizeof(uint32_t), sizeof(storedCrc));
+    if (save_crc32(base, size - sizeof(uint32_t)) != storedCrc) {
+        munmap(mapped, size);
+        log << "Error: Save file is corrupted (checksum mismatch): " << filename << endl;
+        return false;
+    }
+    if (header.level < 1 || header.level > 3 || header.difficulty < 1 || header.difficulty > 3) {
+        munmap(mapped, size);
+        log << "Error: Invalid level or difficulty in save file: " << filename << endl;
         return false;
     }
+    
+    // Every record must lie on the map before any output is touched, so a
+    // rejected save leaves the running game as it was
+    const char* records = base + headerSize;
+    const char* in = records + ((size_t)header.enemyCount + 1) * sizeof(SaveEntityRecord);
+    SaveEntityRecord record;
+    for (uint32_t i = 0; i <= header.enemyCount; ++i) {
+        memcpy(&record, records + (size_t)i * sizeof(record), sizeof(record));
+        if (record.x < 0 || record.x >= header.cols || record.y < 0 || record.y >= header.rows) {
+            munmap(mapped, size);
+            log << "Error: Invalid " << (i == 0 ? "player" : "enemy") << " position in save file: " << filename << endl;
+            return false;
+        }
+    }
+    if (rle && !decode_map_rle(in, header.mapSize, header.rows, header.cols, nullptr)) {
+        munmap(mapped, size);
+        log << "Error: Invalid map data in save file: " << filename << endl;
+        return false;
+    }
+    
+    level = header.level;
+    gpa = header.gpa;
+    journalId = header.journalId;
+    diff = header.difficulty == 1 ? easy() : (header.difficulty == 3 ? hard() : normal());
+    for (int i = 0; i < 3; ++i) {
+        samplers[i].key = header.samplers[i].key;
+        samplers[i].cycle = header.samplers[i].cycle;
+        samplers[i].position = header.samplers[i].position;
+        samplers[i].size = header.samplers[i].size;
+    }
+    memcpy(&record, records, sizeof(record));
+    unpack_entity(record, player);
+    enemies.resize(header.enemyCount);
+    for (uint32_t i = 0; i < header.enemyCount; ++i) {
+        memcpy(&record, records + (size_t)(i + 1) * sizeof(record), sizeof(record));
+        unpack_entity(record, enemies[i]);
+    }
+    
+    // Release the old level; runs are decoded straight into the new map's rows
+    allocate_map(world, header.rows, header.cols);
+    if (rle) {
+        decode_map_rle(in, header.mapSize, header.rows, header.cols, world.map_data);
+    } else {
+        memcpy(world.map_data[0], in, header.mapSize);
+    }
+    
+    munmap(mapped, size);
+    log << "Game loaded successfully from " << filename << endl;
+    return true;
 }
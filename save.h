@@ -3,6 +3,11 @@
 
 #include <string>
 #include <vector>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include "sampler.h"
+#include "world.h"
 
 using namespace std;
 
@@ -36,8 +41,109 @@ struct GameDifficultySettings {
     double stu_k;
 };
 
+/**
+ * @brief Fixed-layout record of one entity in a binary save
+ *
+ * Holds every Entity field, including the behavior modifiers, so a
+ * loaded enemy moves exactly as it did when the game was saved.
+ */
+struct SaveEntityRecord {
+    int32_t x;
+    int32_t y;
+    int32_t id;
+    int32_t chaseProbability;
+    int32_t detectionRange;
+    int32_t movementStrategy;
+    int32_t predictiveTracking;
+    int32_t distractionFactor;
+    char type;
+    uint8_t active;
+    char reserved[2];
+};
+
+/**
+ * @brief Question sampler state in a binary save
+ */
+struct SaveSamplerRecord {
+    uint64_t key;
+    uint32_t cycle;
+    uint32_t position;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Header of a binary save
+ *
+ * A save is the header, the player record, enemyCount enemy records,
+ * the map plane, then the CRC-32 of everything before it. The map plane
+ * is rows * cols tiles, row by row, or with SAVE_MAP_RLE (version 3) each
+ * row as runs: a run length (LEB128 varint, 1 to cols) followed by the tile.
+ * Integers are in host byte order. The layout must not change without
+ * bumping SAVE_VERSION.
+ */
+struct SaveHeader {
+    char magic[4];          ///< "HKSV"
+    uint32_t version;       ///< SAVE_VERSION
+    uint32_t headerSize;    ///< sizeof(SaveHeader), so records can be found by older readers
+    uint32_t flags;         ///< SAVE_MAP_RLE or 0
+    int32_t level;          ///< Current level (1-3)
+    int32_t difficulty;     ///< 1 = Easy, 2 = Normal, 3 = Hard
+    double gpa;
+    int32_t rows;           ///< Map height
+    int32_t cols;           ///< Map width
+    uint32_t enemyCount;    ///< Enemy records after the player record
+    uint32_t mapSize;       ///< Bytes of the map plane as stored
+    SaveSamplerRecord samplers[3]; ///< TA, Professor and Student samplers
+    uint64_t journalId;     ///< Checkpoint the turn journal continues from (0 = none; version 2)
+};
+
+/// Version 2 added journalId, version 3 the run-length encoded map
+const uint32_t SAVE_VERSION = 3;
+
+/// Header size of version 1 saves, which end before journalId
+const uint32_t SAVE_HEADER_V1_SIZE = offsetof(SaveHeader, journalId);
+
+/// SaveHeader::flags: the map plane is run-length encoded per row (version 3 only)
+const uint32_t SAVE_MAP_RLE = 1;
+
+/**
+ * @brief Copy of everything a save holds, taken between turns
+ *
+ * Filled on the game thread by snapshot_game() (plain copies, no
+ * formatting), then serialized and written by write_snapshot(),
+ * possibly on another thread while the game goes on. Buffers keep
+ * their capacity when a snapshot is reused.
+ */
+struct SaveSnapshot {
+    int level;
+    double gpa;
+    int difficulty;            ///< 1 = Easy, 2 = Normal, 3 = Hard
+    Entity player;
+    vector<Entity> enemies;
+    QsSampler samplers[3];
+    int rows;
+    int cols;
+    vector<char> cells;        ///< Map tiles, row by row
+    bool autosave;             ///< Taken by autosave rather than by the player
+    uint64_t journalId;        ///< Checkpoint id the turn journal refers to (0 = none)
+    vector<char> image;        ///< Serialized save, built by write_snapshot()
+
+    SaveSnapshot() : level(0), gpa(0.0), difficulty(2), player(), samplers(), rows(0), cols(0), autosave(false), journalId(0) {}
+};
+
 // Function declarations
 
+/**
+ * @brief CRC-32 (IEEE, as used by zip and PNG) of a byte range
+ * 
+ * @param data Bytes to checksum
+ * @param size Number of bytes
+ * @param crc CRC of the bytes before this range, to checksum in pieces (0 to start)
+ * @return CRC-32 of everything checksummed so far
+ */
+uint32_t save_crc32(const void* data, size_t size, uint32_t crc = 0);
+
 /**
  * @brief Creates easy difficulty settings
  * 
@@ -75,43 +181,109 @@ GameDifficultySettings normal();
 GameDifficultySettings hard();
 
 /**
- * @brief Saves the current game state to a file
+ * @brief Saves the current game state to a binary file and waits for it
  * 
- * This function serializes and saves the current game state including:
+ * Same as snapshot_game() followed by write_snapshot() on the calling
+ * thread. The whole save (see SaveHeader) is built in memory and written
+ * with a single write. It contains:
  * - Current level progress
  * - Player's GPA
- * - Player entity data (position, type, status, ID)
- * - All enemy entities data
+ * - Player entity data (every Entity field)
+ * - All enemy entities data, behavior modifiers included
  * - Current difficulty settings
- * - Map layout data (rows, columns, and tile contents)
+ * - Question sampler state, so questions do not repeat after loading
+ * - Map layout data (rows, columns, and tile contents), run-length
+ *   encoded per row unless that would be larger
+ * - A CRC-32 that loadGame() checks
  * 
+ * @param world Session whose map is saved
  * @param level Current level number to save
  * @param gpa Current GPA value to save
  * @param player Player entity data to save
  * @param enemies Vector of enemy entities to save
  * @param diff Current difficulty settings to save
+ * @param samplers Question samplers for the TA, Professor and Student banks
  * @return bool True if save operation succeeded, false otherwise
  */
-bool saveGame(int level, double gpa, const Entity& player, const vector<Entity>& enemies, const GameDifficultySettings& diff);
+bool saveGame(const World& world, int level, double gpa, const Entity& player, const vector<Entity>& enemies, const GameDifficultySettings& diff,
+              const QsSampler samplers[3]);
+
+/**
+ * @brief Copies the game state into a snapshot
+ * 
+ * Cheap enough to run between turns: the map and the entities are
+ * copied as they are, and the snapshot's image buffer is reserved so
+ * write_snapshot() does not allocate.
+ * 
+ * @param world Session whose map is saved
+ * @param level Current level number
+ * @param gpa Current GPA
+ * @param player Player entity
+ * @param enemies All enemies of the level
+ * @param diff Current difficulty settings
+ * @param samplers Question samplers for the TA, Professor and Student banks
+ * @param snapshot Output snapshot; its buffers are reused
+ */
+void snapshot_game(const World& world, int level, double gpa, const Entity& player,
+                   const vector<Entity>& enemies, const GameDifficultySettings& diff,
+                   const QsSampler samplers[3], SaveSnapshot& snapshot);
+
+/**
+ * @brief Replaces a file in the working directory atomically
+ * 
+ * Writes tempPath, fsyncs it, renames it over path and fsyncs the
+ * directory, so a crash leaves either the old file or the new one.
+ * Builds no strings unless it fails.
+ * 
+ * @param path File to replace
+ * @param tempPath Temporary file next to it
+ * @param data New contents
+ * @param size Bytes of data
+ * @param error Output reason when it failed
+ * @return True if the new contents were committed
+ */
+bool commit_file(const char* path, const char* tempPath, const char* data, size_t size, string& error);
+
+/**
+ * @brief Serializes a snapshot and commits it as the save file
+ * 
+ * Writes a temporary file, fsyncs it and renames it over the save, so
+ * the save on disk is always complete. Prints nothing and touches no
+ * game state, so it may run on a background thread.
+ * 
+ * @param snapshot Snapshot to write; its image buffer is filled
+ * @param error Output reason when the save failed
+ * @return True if the save was committed
+ */
+bool write_snapshot(SaveSnapshot& snapshot, string& error);
 
 /**
  * @brief Loads a previously saved game state from file
  * 
- * This function reads and deserializes a saved game state including:
+ * The binary save is memory-mapped and checked (magic, version, sizes,
+ * CRC and that every entity lies on the map) before any output is
+ * written, so a rejected save leaves them unchanged; the map plane is decoded (or
+ * copied) straight into the level's map. Without a binary save, a text save from older versions is
+ * read instead. It restores:
  * - Previously saved level progress
  * - Player's GPA at time of save
- * - Player entity data (position, type, status, ID)
- * - All enemy entities data
+ * - Player entity data
+ * - All enemy entities data (text saves get default behaviors for the level)
  * - Difficulty settings used in saved game
  * - Map layout data from saved game
  * 
+ * @param world Session that receives the saved map
  * @param level Output parameter for loaded level number
  * @param gpa Output parameter for loaded GPA value
  * @param player Output parameter for loaded player entity data
  * @param enemies Output parameter for loaded enemy entities vector
  * @param diff Output parameter for loaded difficulty settings
+ * @param samplers Output question samplers (left unchanged if the save has none)
+ * @param journalId Output checkpoint id for replay_journal() (0 if the save has none)
+ * @param log Where the outcome and errors are reported
  * @return bool True if load operation succeeded, false otherwise
  */
-bool loadGame(int& level, double& gpa, Entity& player, vector<Entity>& enemies, GameDifficultySettings& diff);
+bool loadGame(World& world, int& level, double& gpa, Entity& player, vector<Entity>& enemies, GameDifficultySettings& diff,
+              QsSampler samplers[3], uint64_t& journalId, ostream& log = cout);
 
 #endif
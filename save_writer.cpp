@@ -0,0 +1,90 @@
+#include "save_writer.h"
+
+using namespace std;
+
+SaveWriter::SaveWriter()
+    : spareIndex(0), pendingIndex(-1), writingIndex(-1), stopping(false),
+      resultReady(false), resultSuccess(false), resultAutosave(false) {}
+
+SaveWriter::~SaveWriter() {
+    if (!worker.joinable()) return;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void SaveWriter::submit() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (pendingIndex >= 0) {
+            // The unwritten older snapshot becomes the next spare
+            int superseded = pendingIndex;
+            pendingIndex = spareIndex;
+            spareIndex = superseded;
+        } else {
+            pendingIndex = spareIndex;
+            // The spare is whichever slot is neither waiting nor being written
+            for (int i = 0; i < 3; ++i) {
+                if (i != pendingIndex && i != writingIndex) {
+                    spareIndex = i;
+                    break;
+                }
+            }
+        }
+        if (!worker.joinable()) {
+            worker = thread(&SaveWriter::run, this);
+        }
+    }
+    wake.notify_one();
+}
+
+void SaveWriter::wait() {
+    unique_lock<mutex> lock(stateMutex);
+    idle.wait(lock, [this] { return pendingIndex < 0 && writingIndex < 0; });
+}
+
+bool SaveWriter::busy() {
+    lock_guard<mutex> lock(stateMutex);
+    return pendingIndex >= 0 || writingIndex >= 0;
+}
+
+bool SaveWriter::takeResult(bool& success, bool& autosave, string& error) {
+    lock_guard<mutex> lock(stateMutex);
+    if (!resultReady) return false;
+    resultReady = false;
+    success = resultSuccess;
+    autosave = resultAutosave;
+    error = resultError;
+    return true;
+}
+
+/**
+ * @brief Worker loop: writes waiting snapshots until stopped
+ *
+ * A snapshot waiting at shutdown is still written.
+ */
+void SaveWriter::run() {
+    unique_lock<mutex> lock(stateMutex);
+    while (true) {
+        wake.wait(lock, [this] { return pendingIndex >= 0 || stopping; });
+        if (pendingIndex < 0) break;
+        writingIndex = pendingIndex;
+        pendingIndex = -1;
+        SaveSnapshot& snapshot = slots[writingIndex];
+        lock.unlock();
+
+        string error;
+        bool success = write_snapshot(snapshot, error);
+
+        lock.lock();
+        resultReady = true;
+        resultSuccess = success;
+        resultAutosave = snapshot.autosave;
+        resultError.swap(error);
+        writingIndex = -1;
+        idle.notify_all();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef SAVE_WRITER_H
+#define SAVE_WRITER_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "save.h"
+
+using namespace std;
+
+/**
+ * @brief Writes save snapshots on a background thread
+ *
+ * The game fills spare() with snapshot_game() and calls submit(); the
+ * worker serializes the snapshot and commits it with write_snapshot()
+ * while the game carries on. Snapshots rotate through three slots: the
+ * game owns the spare one, one waits to be written and one is being
+ * written. Submitting again before the waiting snapshot was picked up
+ * replaces it, since only the newest state is worth writing.
+ *
+ * The worker thread starts with the first submit(), so sessions that
+ * never save cost no thread. The destructor writes any waiting snapshot
+ * before returning.
+ */
+class SaveWriter {
+private:
+    SaveSnapshot slots[3];
+    int spareIndex;          ///< Slot the game thread fills (game thread only)
+    int pendingIndex;        ///< Slot waiting for the worker, or -1
+    int writingIndex;        ///< Slot being written, or -1
+
+    thread worker;
+    mutex stateMutex;
+    condition_variable wake;
+    condition_variable idle;
+    bool stopping;
+
+    // Outcome of the last finished write, until takeResult() reports it
+    bool resultReady;
+    bool resultSuccess;
+    bool resultAutosave;
+    string resultError;
+
+    void run();
+
+public:
+    SaveWriter();
+    ~SaveWriter();
+
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+
+    /**
+     * @brief Snapshot slot the game thread may fill before submit()
+     */
+    SaveSnapshot& spare() { return slots[spareIndex]; }
+
+    /**
+     * @brief Queues the filled spare() snapshot for writing without waiting
+     */
+    void submit();
+
+    /**
+     * @brief Waits until every submitted snapshot has been written
+     */
+    void wait();
+
+    /**
+     * @brief True while a submitted snapshot is waiting or being written
+     */
+    bool busy();
+
+    /**
+     * @brief Reports the last finished write once
+     * @param success Output: true if it was committed
+     * @param autosave Output: true if it was an autosave
+     * @param error Output: reason for a failure
+     * @return False if no write finished since the last call
+     */
+    bool takeResult(bool& success, bool& autosave, string& error);
+};
+
+#endif
@@ -0,0 +1,522 @@
+#include "server.h"
+#include "game.h"
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+// Longest command line a client may send; a longer one ends the session
+static const size_t MAX_LINE = 256;
+
+// Unsent reply bytes after which a client's further commands wait
+static const size_t MAX_PENDING_OUTPUT = 64 * 1024;
+
+static const int MAX_EVENTS = 64;
+
+// Written by the signal handler to wake every worker for shutdown
+static int stopEventFd = -1;
+
+static void request_stop(int) {
+    uint64_t one = 1;
+    ssize_t ignored = write(stopEventFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+/**
+ * @brief One connected client and the game it plays
+ */
+struct ClientSession {
+    int fd;
+    uint32_t events;          ///< Events currently registered with epoll
+    string input;             ///< Received bytes not yet handled
+    string output;            ///< Replies not yet sent
+    size_t outputSent;        ///< Bytes of output already sent
+    unique_ptr<Game> game;    ///< Created by the first NEW
+    bool closing;             ///< Close once the output is sent
+
+    explicit ClientSession(int socket)
+        : fd(socket), events(0), outputSent(0), closing(false) {}
+
+    size_t backlog() const { return output.size() - outputSent; }
+
+    /// A game is in progress: it waits for a move or an answer
+    bool playing() const {
+        return game && (game->awaiting() == GameInput::MOVE || game->awaiting() == GameInput::ANSWER);
+    }
+};
+
+/**
+ * @brief An event loop thread and the sessions it accepted
+ */
+class ServerWorker {
+private:
+    int epollFd;
+    int listenFd;
+    unordered_map<int, unique_ptr<ClientSession>> sessions;
+    mt19937_64 seedSource;    ///< Seeds for games started without one
+    int mapRows;              ///< Map size of new sessions (0 = the difficulty's size)
+    int mapCols;
+    string mapText;           ///< Scratch for MAP replies
+    char line[512];           ///< Scratch for formatting reply lines
+
+    void acceptClients();
+    void readClient(ClientSession& s);
+    void handleInput(ClientSession& s);
+    void handleLine(ClientSession& s, string& command);
+    void sendState(ClientSession& s);
+    void sendQuestion(ClientSession& s);
+    void sendEndOfMove(ClientSession& s, int levelBefore);
+    void sendNext(ClientSession& s, int levelBefore);
+    void flush(ClientSession& s);
+    void updateEvents(ClientSession& s);
+    void closeClient(ClientSession& s);
+
+public:
+    unsigned long accepted;
+    unsigned long commands;
+
+    ServerWorker(int listenSocket, int rows, int cols);
+    ~ServerWorker();
+
+    /**
+     * @brief Serves clients until the stop event fires
+     * @return False if the epoll instance could not be set up
+     */
+    bool run();
+};
+
+ServerWorker::ServerWorker(int listenSocket, int rows, int cols)
+    : epollFd(-1), listenFd(listenSocket), seedSource(random_device()()), mapRows(rows), mapCols(cols),
+      accepted(0), commands(0) {}
+
+ServerWorker::~ServerWorker() {
+    for (auto& entry : sessions) {
+        close(entry.first);
+    }
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool ServerWorker::run() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) return false;
+
+    // Every worker waits on the listening socket; EPOLLEXCLUSIVE wakes only one per connection
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.fd = listenFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) != 0) return false;
+    ev.events = EPOLLIN;
+    ev.data.fd = stopEventFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopEventFd, &ev) != 0) return false;
+
+    struct epoll_event events[MAX_EVENTS];
+    for (;;) {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == stopEventFd) return true;
+            if (fd == listenFd) {
+                acceptClients();
+                continue;
+            }
+
+            auto found = sessions.find(fd);
+            if (found == sessions.end()) continue;
+            ClientSession& s = *found->second;
+            if (events[i].events & EPOLLOUT) {
+                flush(s);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readClient(s);
+            }
+            // Replies freed room for commands that were held back
+            handleInput(s);
+            flush(s);
+            if (s.closing && s.backlog() == 0) {
+                closeClient(s);
+            } else {
+                updateEvents(s);
+            }
+        }
+    }
+}
+
+void ServerWorker::acceptClients() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN: another worker took it, or none left
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Fails harmlessly on Unix sockets
+
+        unique_ptr<ClientSession> session(new ClientSession(fd));
+        ClientSession& s = *session;
+        sessions[fd] = move(session);
+        ++accepted;
+
+        s.output = "HELLO HKU-GPA-ESCAPE 1\n";
+        flush(s);
+        updateEvents(s);
+    }
+}
+
+void ServerWorker::readClient(ClientSession& s) {
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = read(s.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            s.input.append(buffer, (size_t)n);
+            if (s.input.size() > MAX_LINE * 64) break; // Handle what we have first
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        s.closing = true; // End of input or a socket error
+        return;
+    }
+}
+
+void ServerWorker::handleInput(ClientSession& s) {
+    size_t start = 0;
+    string command;
+    while (s.backlog() < MAX_PENDING_OUTPUT) {
+        size_t end = s.input.find('\n', start);
+        if (end == string::npos) {
+            if (s.input.size() - start > MAX_LINE) {
+                s.output += "ERR line too long\n";
+                s.closing = true;
+                start = s.input.size();
+            }
+            break;
+        }
+        command.assign(s.input, start, end - start);
+        start = end + 1;
+        if (command.size() > MAX_LINE) {
+            s.output += "ERR line too long\n";
+            s.closing = true;
+            break;
+        }
+        handleLine(s, command);
+        if (s.closing) break;
+    }
+    s.input.erase(0, start);
+}
+
+// Upper-case a command word in place
+static void to_upper(char* word) {
+    for (; *word; ++word) *word = (char)toupper((unsigned char)*word);
+}
+
+void ServerWorker::handleLine(ClientSession& s, string& command) {
+    if (!command.empty() && command.back() == '\r') command.pop_back();
+    char word[16] = "";
+    char arg1[32] = "";
+    char arg2[32] = "";
+    if (sscanf(command.c_str(), "%15s %31s %31s", word, arg1, arg2) < 1) {
+        return; // Blank line
+    }
+    to_upper(word);
+    ++commands;
+
+    if (strcmp(word, "NEW") == 0) {
+        int difficulty = arg1[0] != '\0' ? atoi(arg1) : 2;
+        if (difficulty < 1 || difficulty > 3) {
+            s.output += "ERR difficulty must be 1, 2 or 3\n";
+            return;
+        }
+        unsigned long seed = arg2[0] != '\0' ? strtoul(arg2, nullptr, 10) : (unsigned long)(seedSource() >> 1);
+        if (!s.game) {
+            // The session's prompts and map drawings have no terminal to go to
+            s.game.reset(new Game());
+            s.game->setOutput(nullptr);
+            s.game->setMapSize(mapRows, mapCols);
+        }
+        s.game->remoteStart(difficulty, seed);
+        snprintf(line, sizeof(line), "GAME %lu %d\n", seed, difficulty);
+        s.output += line;
+        sendEndOfMove(s, 0);
+    } else if (strcmp(word, "MOVE") == 0) {
+        char move = (char)toupper((unsigned char)arg1[0]);
+        if (!s.playing()) {
+            s.output += "ERR no game in progress, send NEW\n";
+        } else if (s.game->awaiting() == GameInput::ANSWER) {
+            s.output += "ERR answer the question first\n";
+        } else if (move != 'W' && move != 'A' && move != 'S' && move != 'D') {
+            s.output += "ERR move with W, A, S or D\n";
+        } else {
+            int levelBefore = s.game->getLevel();
+            s.game->feed(move);
+            sendNext(s, levelBefore);
+        }
+    } else if (strcmp(word, "ANSWER") == 0) {
+        char answer = (char)toupper((unsigned char)arg1[0]);
+        if (!s.game || s.game->awaiting() != GameInput::ANSWER) {
+            s.output += "ERR no question to answer\n";
+        } else if (answer < 'A' || answer > 'D') {
+            s.output += "ERR answer with A, B, C or D\n";
+        } else {
+            char correct = s.game->question().view.answer;
+            int levelBefore = s.game->getLevel();
+            s.game->feed(answer);
+            double penalty = s.game->lastPenalty();
+            if (penalty > 0) {
+                snprintf(line, sizeof(line), "WRONG %c %g\n", correct, penalty);
+                s.output += line;
+            } else {
+                s.output += "CORRECT\n";
+            }
+            sendNext(s, levelBefore);
+        }
+    } else if (strcmp(word, "MAP") == 0) {
+        if (!s.playing()) {
+            s.output += "ERR no game in progress, send NEW\n";
+        } else {
+            s.game->remoteMap(mapText);
+            snprintf(line, sizeof(line), "MAP %d %d\n", s.game->getWorld().map_rows, s.game->getWorld().map_cols);
+            s.output += line;
+            s.output += mapText;
+            sendState(s);
+        }
+    } else if (strcmp(word, "QUIT") == 0) {
+        s.output += "BYE\n";
+        s.closing = true;
+    } else {
+        s.output += "ERR unknown command\n";
+    }
+}
+
+void ServerWorker::sendState(ClientSession& s) {
+    const Entity& player = s.game->getPlayer();
+    snprintf(line, sizeof(line), "STATE %g %d %d %d\n",
+             s.game->getGPA(), player.y, player.x, s.game->activeEnemyCount());
+    s.output += line;
+}
+
+// Send the pending question, escaping line breaks so it fits on one line
+void ServerWorker::sendQuestion(ClientSession& s) {
+    const PendingQuestion& question = s.game->question();
+    s.output += "QUESTION ";
+    s.output += question.enemyType;
+    s.output += ' ';
+    for (size_t i = 0; i < question.view.textLength; ++i) {
+        char c = question.view.text[i];
+        if (c == '\n') {
+            s.output += "\\n";
+        } else if (c == '\\') {
+            s.output += "\\\\";
+        } else if (c != '\r') {
+            s.output += c;
+        }
+    }
+    s.output += '\n';
+}
+
+// Report how a move or answer left the game: new level, state, or its end
+void ServerWorker::sendEndOfMove(ClientSession& s, int levelBefore) {
+    GameState state = s.game->getState();
+    if (state == GameState::VICTORY) {
+        snprintf(line, sizeof(line), "WIN %g\n", s.game->getGPA());
+        s.output += line;
+        return;
+    }
+    if (state == GameState::GAME_OVER) {
+        s.output += "LOSE\n";
+        return;
+    }
+    if (s.game->getLevel() != levelBefore) {
+        snprintf(line, sizeof(line), "LEVEL %d %d %d\n", s.game->getLevel(),
+                 s.game->getWorld().map_rows, s.game->getWorld().map_cols);
+        s.output += line;
+    }
+    sendState(s);
+}
+
+// After a move or answer: the next question if the game stopped for one, else the end of the move
+void ServerWorker::sendNext(ClientSession& s, int levelBefore) {
+    if (s.game->awaiting() == GameInput::ANSWER) {
+        sendQuestion(s);
+    } else {
+        sendEndOfMove(s, levelBefore);
+    }
+}
+
+void ServerWorker::flush(ClientSession& s) {
+    while (s.backlog() > 0) {
+        ssize_t n = send(s.fd, s.output.data() + s.outputSent, s.backlog(), MSG_NOSIGNAL);
+        if (n > 0) {
+            s.outputSent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        // The client is gone; nothing more can be delivered
+        s.closing = true;
+        s.output.clear();
+        s.outputSent = 0;
+        return;
+    }
+    s.output.clear();
+    s.outputSent = 0;
+}
+
+void ServerWorker::updateEvents(ClientSession& s) {
+    uint32_t wanted = 0;
+    if (!s.closing && s.backlog() < MAX_PENDING_OUTPUT) wanted |= EPOLLIN | EPOLLRDHUP;
+    if (s.backlog() > 0) wanted |= EPOLLOUT;
+    if (wanted == s.events) return;
+
+    struct epoll_event ev;
+    ev.events = wanted;
+    ev.data.fd = s.fd;
+    epoll_ctl(epollFd, s.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, s.fd, &ev);
+    s.events = wanted;
+}
+
+void ServerWorker::closeClient(ClientSession& s) {
+    int fd = s.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    sessions.erase(fd); // Destroys s
+}
+
+// Open the listening socket: a Unix socket at path, or TCP on 127.0.0.1:port
+static int open_listener(const ServerOptions& options, string& where) {
+    int fd;
+    if (!options.socketPath.empty()) {
+        struct sockaddr_un addr;
+        if (options.socketPath.size() >= sizeof(addr.sun_path)) {
+            cerr << "Error: Socket path too long: " << options.socketPath << endl;
+            return -1;
+        }
+        // Replace a socket left behind by an earlier run, but never another kind of file
+        struct stat st;
+        if (lstat(options.socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(options.socketPath.c_str());
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, options.socketPath.c_str());
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            cerr << "Error: Cannot bind " << options.socketPath << ": " << strerror(errno) << endl;
+            close(fd);
+            return -1;
+        }
+        where = options.socketPath;
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((uint16_t)options.port);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            cerr << "Error: Cannot bind 127.0.0.1:" << options.port << ": " << strerror(errno) << endl;
+            close(fd);
+            return -1;
+        }
+        where = "127.0.0.1:" + to_string(options.port);
+    }
+    if (listen(fd, SOMAXCONN) != 0) {
+        cerr << "Error: Cannot listen on " << where << ": " << strerror(errno) << endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_server(const ServerOptions& options) {
+    string where;
+    int listenFd = open_listener(options, where);
+    if (listenFd < 0) {
+        return 1;
+    }
+    stopEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopEventFd < 0) {
+        close(listenFd);
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    struct sigaction oldInt, oldTerm;
+    sigaction(SIGINT, &action, &oldInt);
+    sigaction(SIGTERM, &action, &oldTerm);
+
+    int workerCount = options.workers;
+    if (workerCount <= 0) {
+        workerCount = (int)thread::hardware_concurrency();
+        if (workerCount > 4) workerCount = 4;
+        if (workerCount < 1) workerCount = 1;
+    }
+    cout << "Serving on " << where << " with " << workerCount << " worker(s). Press Ctrl-C to stop." << endl;
+
+    vector<unique_ptr<ServerWorker>> workers;
+    vector<thread> threads;
+    atomic<int> failed(0);
+    for (int i = 0; i < workerCount; ++i) {
+        workers.push_back(unique_ptr<ServerWorker>(new ServerWorker(listenFd, options.mapRows, options.mapCols)));
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        ServerWorker* worker = workers[i].get();
+        threads.push_back(thread([worker, &failed] {
+            if (!worker->run()) {
+                ++failed;
+                request_stop(0); // Take the other workers down too
+            }
+        }));
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    unsigned long accepted = 0, commands = 0;
+    for (auto& worker : workers) {
+        accepted += worker->accepted;
+        commands += worker->commands;
+    }
+    workers.clear(); // Closes the remaining client connections
+
+    sigaction(SIGINT, &oldInt, nullptr);
+    sigaction(SIGTERM, &oldTerm, nullptr);
+    close(listenFd);
+    close(stopEventFd);
+    stopEventFd = -1;
+    if (!options.socketPath.empty()) {
+        unlink(options.socketPath.c_str());
+    }
+
+    cout << endl << "Server stopped: " << accepted << " session(s), " << commands << " command(s)." << endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Where and how the game server listens
+ */
+struct ServerOptions {
+    string socketPath;  ///< Unix domain socket to listen on (empty = TCP)
+    int port;           ///< TCP port on 127.0.0.1, used when socketPath is empty
+    int workers;        ///< Event loop threads (0 = one per core, at most 4)
+    int mapRows;        ///< Size of every level of every session (0 = the difficulty's size)
+    int mapCols;
+};
+
+/**
+ * @brief Serves many game sessions from one process until SIGINT or SIGTERM
+ *
+ * Every worker thread runs its own epoll loop over the listening socket
+ * and the connections it accepted, so a session is only ever touched by
+ * one thread and needs no locks. Sockets are non-blocking: a session
+ * waiting for its player's next line costs no thread, and a slow client
+ * only delays itself. All sessions share the process-wide question bank.
+ *
+ * Clients speak a line protocol; commands are case-insensitive:
+ *   NEW [difficulty] [seed]   start a game (default Normal, random seed)
+ *   MOVE W|A|S|D              move one cell
+ *   ANSWER A|B|C|D            answer the pending question
+ *   MAP                       show the current map
+ *   QUIT                      end the session
+ *
+ * Each command is answered by one or more lines. The last one is
+ * STATE, QUESTION, WIN, LOSE, ERR or BYE:
+ *   GAME <seed> <difficulty>            a game started (replay it with --headless --seed)
+ *   LEVEL <n> <rows> <cols>             a level started
+ *   STATE <gpa> <row> <col> <enemies>   waiting for a move
+ *   QUESTION <T|F|S> <text>             waiting for an answer; "\n" in the text is a line break
+ *   CORRECT | WRONG <answer> <penalty>  result of an answer
+ *   WIN <gpa> | LOSE                    the game is over; NEW starts another
+ *   MAP <rows> <cols>                   followed by the map rows, then STATE
+ *   ERR <reason>                        the command was rejected
+ *
+ * @param options Socket to listen on and number of workers
+ * @return 0 after a clean shutdown, 1 if the socket could not be opened
+ */
+int run_server(const ServerOptions& options);
+
+#endif
@@ -0,0 +1,276 @@
+#include "spectate.h"
+#include <cstring>
+#include <new>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static_assert(sizeof(SpectatorEnemy) == 12, "SpectatorEnemy is part of the shared layout");
+
+// Room for this many enemies at least, so a segment rarely has to grow
+static const uint32_t MIN_ENEMY_CAPACITY = 64;
+
+// Shared-memory names start with a single slash
+static string segment_path(const string& name) {
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+// Bytes of one slot: the fixed part, the enemies, then the cells, rounded up to 8
+static size_t slot_bytes(uint32_t enemyCapacity, uint32_t cellCapacity) {
+    size_t bytes = sizeof(SpectatorSlot) + (size_t)enemyCapacity * sizeof(SpectatorEnemy) + cellCapacity;
+    return (bytes + 7) & ~(size_t)7;
+}
+
+SpectatorFeed::SpectatorFeed() : header(nullptr), mappedSize(0), nextSlot(0), frames(0) {}
+
+SpectatorFeed::~SpectatorFeed() {
+    close();
+}
+
+/**
+ * @brief Creates and maps a fresh segment with the given capacities
+ */
+bool SpectatorFeed::create(uint32_t enemyCapacity, uint32_t cellCapacity) {
+    // A segment left behind by a crashed game is replaced, not reused
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    size_t slotSize = slot_bytes(enemyCapacity, cellCapacity);
+    size_t size = sizeof(SpectatorHeader) + 2 * slotSize;
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // Fresh pages are zero: state is SPECTATE_STARTING until everything below is set
+    header = new (memory) SpectatorHeader;
+    mappedSize = size;
+    header->magic = SPECTATE_MAGIC;
+    header->version = SPECTATE_VERSION;
+    header->latest.store(0, memory_order_relaxed);
+    header->slotSize = (uint32_t)slotSize;
+    header->enemyCapacity = enemyCapacity;
+    header->cellCapacity = cellCapacity;
+    header->writerPid = (uint32_t)getpid();
+    for (uint32_t i = 0; i < 2; ++i) {
+        SpectatorSlot* s = new (slot(i)) SpectatorSlot;
+        s->sequence.store(0, memory_order_relaxed);
+    }
+    nextSlot = 0;
+    header->state.store(SPECTATE_LIVE, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Marks the segment closed for readers and unmaps it
+ */
+void SpectatorFeed::release() {
+    if (header == nullptr) return;
+    header->state.store(SPECTATE_CLOSED, memory_order_release);
+    munmap(header, mappedSize);
+    header = nullptr;
+    mappedSize = 0;
+}
+
+SpectatorSlot* SpectatorFeed::slot(uint32_t index) {
+    char* base = reinterpret_cast<char*>(header) + sizeof(SpectatorHeader);
+    return reinterpret_cast<SpectatorSlot*>(base + (size_t)index * header->slotSize);
+}
+
+bool SpectatorFeed::open(const string& segmentName) {
+    close();
+    name = segment_path(segmentName);
+    frames = 0;
+    // Capacity for a normal level; larger maps grow the segment on first publish
+    return create(MIN_ENEMY_CAPACITY, 4096);
+}
+
+void SpectatorFeed::close() {
+    if (header == nullptr) return;
+    release();
+    shm_unlink(name.c_str());
+}
+
+void SpectatorFeed::publish(const World& world, int level, double gpa, const string& difficulty,
+                            const Entity* players, int playerCount, const vector<Entity>& enemies) {
+    if (header == nullptr || world.map_data == nullptr) return;
+
+    uint32_t cells = (uint32_t)world.map_rows * (uint32_t)world.map_cols;
+    uint32_t active = 0;
+    for (const Entity& enemy : enemies) {
+        if (enemy.active) ++active;
+    }
+    if (cells > header->cellCapacity || active > header->enemyCapacity) {
+        // Outgrown: readers see SPECTATE_CLOSED and reopen the new segment
+        uint32_t enemyCapacity = active > header->enemyCapacity ? active * 2 : header->enemyCapacity;
+        uint32_t cellCapacity = cells > header->cellCapacity ? cells : header->cellCapacity;
+        release();
+        if (!create(enemyCapacity, cellCapacity)) return;
+    }
+
+    SpectatorSlot* s = slot(nextSlot);
+    uint32_t sequence = s->sequence.load(memory_order_relaxed);
+    s->sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    s->frame = ++frames;
+    s->level = level;
+    s->rows = world.map_rows;
+    s->cols = world.map_cols;
+    s->gpa = gpa;
+    strncpy(s->difficulty, difficulty.c_str(), sizeof(s->difficulty) - 1);
+    s->difficulty[sizeof(s->difficulty) - 1] = '\0';
+
+    s->playerCount = playerCount < SPECTATE_MAX_PLAYERS ? playerCount : SPECTATE_MAX_PLAYERS;
+    for (int i = 0; i < s->playerCount; ++i) {
+        s->players[i][0] = players[i].y;
+        s->players[i][1] = players[i].x;
+    }
+
+    SpectatorEnemy* out = reinterpret_cast<SpectatorEnemy*>(s + 1);
+    int32_t count = 0;
+    for (const Entity& enemy : enemies) {
+        if (!enemy.active) continue;
+        out[count].row = enemy.y;
+        out[count].col = enemy.x;
+        out[count].type = enemy.type;
+        ++count;
+    }
+    s->enemyCount = count;
+    s->enemyTotal = (int32_t)enemies.size();
+
+    // Each buffer keeps the map it last held; copy the cells only when the level changed
+    if (s->mapVersion != world.map_version) {
+        char* grid = reinterpret_cast<char*>(out + header->enemyCapacity);
+        for (int row = 0; row < world.map_rows; ++row) {
+            memcpy(grid + (size_t)row * world.map_cols, world.map_data[row], world.map_cols);
+        }
+        s->mapVersion = world.map_version;
+    }
+
+    s->sequence.store(sequence + 2, memory_order_release);
+    header->latest.store(nextSlot, memory_order_release);
+    nextSlot ^= 1;
+}
+
+SpectatorView::SpectatorView() : header(nullptr), mappedSize(0) {}
+
+SpectatorView::~SpectatorView() {
+    close();
+}
+
+bool SpectatorView::open(const string& segmentName) {
+    close();
+    int fd = shm_open(segment_path(segmentName).c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SpectatorHeader)) {
+        memory = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    header = static_cast<const SpectatorHeader*>(memory);
+    mappedSize = (size_t)info.st_size;
+    if (header->state.load(memory_order_acquire) != SPECTATE_LIVE ||
+        header->magic != SPECTATE_MAGIC || header->version != SPECTATE_VERSION ||
+        sizeof(SpectatorHeader) + 2 * (size_t)header->slotSize > mappedSize) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SpectatorView::close() {
+    if (header == nullptr) return;
+    munmap(const_cast<SpectatorHeader*>(header), mappedSize);
+    header = nullptr;
+    mappedSize = 0;
+}
+
+bool SpectatorView::closed() const {
+    return header == nullptr || header->state.load(memory_order_acquire) != SPECTATE_LIVE;
+}
+
+// Give up on a frame the game keeps rewriting; the next poll tries again
+static const int MAX_READ_ATTEMPTS = 64;
+
+bool SpectatorView::poll(SpectatorFrame& frame) {
+    if (header == nullptr) return false;
+
+    const char* base = reinterpret_cast<const char*>(header) + sizeof(SpectatorHeader);
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        uint32_t index = header->latest.load(memory_order_acquire) & 1;
+        const SpectatorSlot* s = reinterpret_cast<const SpectatorSlot*>(base + (size_t)index * header->slotSize);
+        uint32_t sequence = s->sequence.load(memory_order_acquire);
+        if (sequence & 1) continue;
+
+        uint64_t number = s->frame;
+        if (number == frame.frame) {
+            atomic_thread_fence(memory_order_acquire);
+            if (s->sequence.load(memory_order_relaxed) == sequence) return false;
+            continue;
+        }
+
+        int32_t rows = s->rows;
+        int32_t cols = s->cols;
+        int32_t players = s->playerCount;
+        int32_t enemies = s->enemyCount;
+        uint32_t mapVersion = s->mapVersion;
+        if (rows < 0 || cols < 0 || (uint64_t)rows * (uint64_t)cols > header->cellCapacity ||
+            players < 0 || players > SPECTATE_MAX_PLAYERS ||
+            enemies < 0 || (uint32_t)enemies > header->enemyCapacity) {
+            continue; // Torn read; the sequence check would reject it anyway
+        }
+
+        frame.level = s->level;
+        frame.gpa = s->gpa;
+        frame.enemyTotal = s->enemyTotal;
+        char difficulty[sizeof(s->difficulty)];
+        memcpy(difficulty, s->difficulty, sizeof(difficulty));
+        difficulty[sizeof(difficulty) - 1] = '\0';
+        frame.players.resize((size_t)players * 2);
+        for (int32_t i = 0; i < players; ++i) {
+            frame.players[i * 2] = s->players[i][0];
+            frame.players[i * 2 + 1] = s->players[i][1];
+        }
+        const SpectatorEnemy* enemyData = reinterpret_cast<const SpectatorEnemy*>(s + 1);
+        frame.enemies.assign(enemyData, enemyData + enemies);
+        bool newMap = mapVersion != frame.mapVersion || rows != frame.rows || cols != frame.cols;
+        if (newMap) {
+            const char* grid = reinterpret_cast<const char*>(enemyData + header->enemyCapacity);
+            frame.grid.assign(grid, grid + (size_t)rows * cols);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (s->sequence.load(memory_order_relaxed) != sequence) {
+            // The game rewrote the buffer while it was copied: the copy is torn
+            frame.mapVersion = 0;
+            frame.frame = 0;
+            continue;
+        }
+        frame.difficulty = difficulty;
+        frame.rows = rows;
+        frame.cols = cols;
+        frame.mapVersion = mapVersion;
+        frame.frame = number;
+        return true;
+    }
+    return false;
+}
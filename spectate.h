@@ -0,0 +1,200 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "save.h"
+
+using namespace std;
+
+static const uint32_t SPECTATE_MAGIC = 0x43455053;   ///< "SPEC" at the start of the segment
+static const uint32_t SPECTATE_VERSION = 1;          ///< Bumped when the layout below changes
+static const int SPECTATE_MAX_PLAYERS = 9;
+
+/**
+ * @brief Lifecycle of a spectator segment, in SpectatorHeader::state
+ */
+enum SpectatorState : uint32_t {
+    SPECTATE_STARTING = 0, ///< Being set up; readers wait
+    SPECTATE_LIVE = 1,     ///< Frames are being published
+    SPECTATE_CLOSED = 2    ///< The game quit or moved to a larger segment of the same name
+};
+
+/**
+ * @brief One active enemy as published to spectators
+ */
+struct SpectatorEnemy {
+    int32_t row;
+    int32_t col;
+    char type;    ///< 'T', 'F' or 'S'
+    char pad[3];
+};
+
+/**
+ * @brief Fixed part of one frame buffer in the segment
+ *
+ * In memory it is followed by enemyCapacity SpectatorEnemy records and
+ * then cellCapacity map cells (rows * cols, row by row).
+ */
+struct SpectatorSlot {
+    atomic<uint32_t> sequence; ///< Odd while the game writes this slot
+    uint32_t mapVersion;       ///< World::map_version of the cells in this slot
+    uint64_t frame;            ///< Publication number, starting at 1
+    int32_t level;
+    int32_t rows;
+    int32_t cols;
+    int32_t playerCount;
+    int32_t enemyCount;        ///< Active enemies that follow this struct
+    int32_t enemyTotal;        ///< All enemies of the level, active or not
+    double gpa;
+    char difficulty[16];       ///< NUL-terminated difficulty name
+    int32_t players[SPECTATE_MAX_PLAYERS][2]; ///< Row and column of each player
+};
+
+/**
+ * @brief Start of the shared-memory segment
+ */
+struct SpectatorHeader {
+    uint32_t magic;
+    uint32_t version;
+    atomic<uint32_t> state;    ///< SpectatorState
+    atomic<uint32_t> latest;   ///< Slot (0 or 1) holding the newest complete frame
+    uint32_t slotSize;         ///< Bytes from one slot to the next
+    uint32_t enemyCapacity;
+    uint32_t cellCapacity;
+    uint32_t writerPid;
+};
+
+/**
+ * @brief Publishes a live game into a POSIX shared-memory segment
+ *
+ * The segment holds two frame buffers. Each publish() fills the one
+ * readers were not pointed at, bracketed by its sequence number (odd
+ * while writing, a seqlock), then points SpectatorHeader::latest at it.
+ * Publishing never waits for readers and makes no system calls; readers
+ * never write to the segment, so any number of them cost the game
+ * nothing. Map cells are copied into a buffer only when its map changed,
+ * so a turn costs one copy of the active enemies.
+ *
+ * When a level outgrows the segment it is replaced by a larger one under
+ * the same name; the old one is marked SPECTATE_CLOSED so readers reopen.
+ */
+class SpectatorFeed {
+private:
+    string name;
+    SpectatorHeader* header;
+    size_t mappedSize;
+    uint32_t nextSlot;
+    uint64_t frames;
+
+    bool create(uint32_t enemyCapacity, uint32_t cellCapacity);
+    void release();
+    SpectatorSlot* slot(uint32_t index);
+
+public:
+    SpectatorFeed();
+    ~SpectatorFeed();
+
+    SpectatorFeed(const SpectatorFeed&) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed&) = delete;
+
+    /**
+     * @brief Creates the segment, replacing a stale one of the same name
+     * @param segmentName Shared-memory name; a leading '/' is added if missing
+     * @return False if the segment could not be created
+     */
+    bool open(const string& segmentName);
+
+    /**
+     * @brief Marks the segment closed and removes its name
+     */
+    void close();
+
+    /**
+     * @brief True while a segment is open
+     */
+    bool isOpen() const { return header != nullptr; }
+
+    /**
+     * @brief Publishes the current state of a game
+     * @param world Session whose map is published (must have a level loaded)
+     * @param level Current level
+     * @param gpa Current GPA
+     * @param difficulty Difficulty name
+     * @param players Players on the map (at most SPECTATE_MAX_PLAYERS are shown)
+     * @param playerCount Number of players
+     * @param enemies All enemies of the level; inactive ones are skipped
+     */
+    void publish(const World& world, int level, double gpa, const string& difficulty,
+                 const Entity* players, int playerCount, const vector<Entity>& enemies);
+};
+
+/**
+ * @brief A spectator's copy of one published frame
+ */
+struct SpectatorFrame {
+    uint64_t frame;             ///< 0 until a frame was read
+    uint32_t mapVersion;        ///< Version of the cells in grid
+    int level;
+    int rows;
+    int cols;
+    double gpa;
+    string difficulty;
+    int enemyTotal;
+    vector<int> players;        ///< Row and column of each player, in turn
+    vector<SpectatorEnemy> enemies;
+    vector<char> grid;          ///< rows * cols map cells
+
+    SpectatorFrame() : frame(0), mapVersion(0), level(0), rows(0), cols(0), gpa(0.0), enemyTotal(0) {}
+};
+
+/**
+ * @brief Maps a spectator segment read-only and reads frames from it
+ *
+ * poll() reads the sequence number and frame counter straight from the
+ * mapping; when nothing was published since the last call it returns
+ * without copying anything. New frames are copied and checked against
+ * the sequence number, retrying if the game rewrote the buffer meanwhile.
+ * Map cells are only copied when the map changed.
+ */
+class SpectatorView {
+private:
+    const SpectatorHeader* header;
+    size_t mappedSize;
+
+public:
+    SpectatorView();
+    ~SpectatorView();
+
+    SpectatorView(const SpectatorView&) = delete;
+    SpectatorView& operator=(const SpectatorView&) = delete;
+
+    /**
+     * @brief Maps the segment of a running game
+     * @param segmentName Name given to the game; a leading '/' is added if missing
+     * @return False if no live segment of that name exists (yet)
+     */
+    bool open(const string& segmentName);
+
+    /**
+     * @brief Unmaps the segment
+     */
+    void close();
+
+    /**
+     * @brief True if the game closed the segment; open() it again to follow a replacement
+     */
+    bool closed() const;
+
+    /**
+     * @brief Reads the newest frame if it differs from the one in frame
+     * @param frame Last frame read; updated in place
+     * @return True if frame now holds a newer frame
+     */
+    bool poll(SpectatorFrame& frame);
+};
+
+#endif
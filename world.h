@@ -0,0 +1,56 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <memory>
+#include <vector>
+#include "arena.h"
+#include "rng.h"
+
+using namespace std;
+
+class QuestionSet;
+
+/**
+ * @brief Everything one game session plays in
+ *
+ * The current level's map, the arena that owns it, the session's random
+ * stream, scratch space reused by enemy movement, and the question bank
+ * snapshot the session draws from. The map, entity and save modules work
+ * on the World they are given instead of on globals, so any number of
+ * sessions can run side by side in one process, each on its own thread,
+ * without locks. The question data is read-only and shared between
+ * sessions through the shared_ptr.
+ */
+struct World {
+    char** map_data;           ///< Map rows, pointing into map_arena (nullptr when no level is loaded)
+    int map_rows;              ///< Map height
+    int map_cols;              ///< Map width
+    int map_player_start_row;  ///< Where the player starts on this map
+    int map_player_start_col;
+    unsigned map_version;      ///< Bumped by every allocate_map(), so observers can tell maps apart
+    int map_override_rows;     ///< Size every level is generated at (0 = the difficulty's size)
+    int map_override_cols;
+    int map_override_wall_percent;  ///< Wall percentage of every level (-1 = the difficulty's)
+    int map_override_enemy_percent; ///< Enemy percentage of every level (-1 = the difficulty's)
+    LevelArena map_arena;      ///< Owns the map cells and all transient allocations of the level
+    RandomStream rng;          ///< Random stream for map generation and enemy moves
+    vector<int> occupancy;     ///< Active enemies per cell, rebuilt by every moveEnemies() call
+    vector<int> playerField;   ///< Nearest player of each cell in co-op games (-1 = unreachable)
+    vector<int> fieldQueue;    ///< Scratch queue for building playerField
+    shared_ptr<const QuestionSet> questions; ///< Question bank snapshot used by this session
+
+    // Small arena blocks: a normal level fits in a few kilobytes, and a
+    // server may hold many idle sessions; larger maps get larger blocks.
+    World()
+        : map_data(nullptr), map_rows(0), map_cols(0),
+          map_player_start_row(0), map_player_start_col(0), map_version(0),
+          map_override_rows(0), map_override_cols(0),
+          map_override_wall_percent(-1), map_override_enemy_percent(-1), map_arena(4 * 1024) {
+        rng.state = 0;
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+};
+
+#endif